@@ -46,12 +46,15 @@ public:
   std::string getName() const { return name; }
   std::string getTypeName() const { return typeName; }
   Stage getStage() const { return stage; }
+  void setStage(const Stage stage_) { stage = stage_; }
 
   static Data *get(std::string const &name) {
     auto iterator(dataMap.find(name));
     return (iterator != dataMap.end()) ? iterator->second : nullptr;
   }
 
+  static std::map<std::string, Data *> const &getDataMap() { return dataMap; }
+
 protected:
   /**
    * \brief protected constructor for typed data.
@@ -10,11 +10,14 @@ Options::Options(int argc_, char **argv_)
     , inFile("")
     , logFile("sisi4s.log")
     , yamlOutFile("sisi4s.out.yaml")
+    , spillDirectory(".")
     , argc(argc_)
     , argv(argv_)
     , cc4s(false)
     , listAlgorithms(false)
-    , dryRun(false) {
+    , dryRun(false)
+    , keepData(false)
+    , spillMemory(0.0) {
 
   app.add_option("-i,--in", inFile, "Input file path")
       ->check(CLI::ExistingFile)
@@ -27,6 +30,22 @@ Options::Options(int argc_, char **argv_)
 
   app.add_flag("--dry", dryRun, "Do a dry run pass")->default_val(dryRun);
 
+  app.add_flag("--keep-data",
+               keepData,
+               "Keep tensors after their last use in the execution plan")
+      ->default_val(keepData);
+
+  app.add_option("--spill-memory",
+                 spillMemory,
+                 "Memory budget in GB of all tensors, spilling idle ones "
+                 "to --spill-directory when exceeded, 0 disables spilling")
+      ->default_val(spillMemory);
+
+  app.add_option("--spill-directory",
+                 spillDirectory,
+                 "Scratch directory of spilled tensors")
+      ->default_val(spillDirectory);
+
   app.add_option("--log-level", logLevel, "Log level")->default_val(logLevel);
 
   app.add_flag("--cc4s", cc4s, "Interpret the input file in the old cc4s DSL")
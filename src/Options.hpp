@@ -9,10 +9,11 @@ struct Options {
 
   CLI::App app;
   int logLevel;
-  std::string inFile, logFile, yamlOutFile;
+  std::string inFile, logFile, yamlOutFile, spillDirectory;
   int argc;
   char **argv;
-  bool cc4s, listAlgorithms, dryRun;
+  bool cc4s, listAlgorithms, dryRun, keepData;
+  double spillMemory;
 
   static const int DEFAULT_LOG_LEVEL = 1;
 
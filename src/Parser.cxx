@@ -66,6 +66,11 @@ std::vector<Algorithm *> InputFileParser<InputFileFormat::YAML>::parse() {
     Algorithm *algorithm(AlgorithmFactory::create(name, arguments));
     if (node["note"]) { algorithm->note = node["note"].as<std::string>(); }
     if (node["fallible"]) { algorithm->fallible = node["fallible"].as<bool>(); }
+    for (const YAML::Node &keep : node["keep"]) {
+      const std::string value(keep.as<std::string>());
+      algorithm->keep.push_back(value.substr(0, 1) == "$" ? value.substr(1)
+                                                          : value);
+    }
     algorithms.push_back(algorithm);
   }
   return algorithms;
@@ -13,12 +13,76 @@
 #include <util/Log.hpp>
 #include <util/Emitter.hpp>
 #include <util/Exception.hpp>
+#include <util/SpillManager.hpp>
 
 // TODO: to be removed from the main class
 #include <math/MathFunctions.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
 
 using namespace sisi4s;
 
+std::vector<std::vector<std::string>>
+Sisi4s::getLastUses(const std::vector<Algorithm *> &algorithms) {
+  std::vector<std::vector<std::string>> lastUses(algorithms.size());
+  if (options->keepData) return lastUses;
+  std::map<std::string, size_t> lastUse;
+  std::set<std::string> kept;
+  for (size_t i(0); i < algorithms.size(); ++i) {
+    for (const auto &argument : algorithms[i]->arguments) {
+      lastUse[argument.second] = i;
+    }
+    kept.insert(algorithms[i]->keep.begin(), algorithms[i]->keep.end());
+  }
+  for (const auto &use : lastUse) {
+    if (!kept.count(use.first)) lastUses[use.second].push_back(use.first);
+  }
+  return lastUses;
+}
+
+namespace {
+template <typename F>
+int64_t getTensorBytes(Data *data) {
+  auto tensorData(dynamic_cast<TensorData<F> *>(data));
+  // spilled tensors take no memory
+  if (tensorData && !tensorData->value) return 0;
+  if (tensorData) {
+    int64_t elements(1);
+    for (int d(0); d < tensorData->value->order; ++d) {
+      elements *= tensorData->value->lens[d];
+    }
+    return elements * sizeof(F);
+  }
+  auto dryTensorData(dynamic_cast<TensorData<F, DryTensor<F>> *>(data));
+  if (dryTensorData && dryTensorData->value) {
+    return dryTensorData->value->getElementsCount() * sizeof(F);
+  }
+  return -1;
+}
+} // namespace
+
+int64_t Sisi4s::freeTensors(const std::vector<std::string> &dataNames) {
+  int64_t freedBytes(0);
+  for (const auto &name : dataNames) {
+    Data *data(Data::get(name));
+    if (!data) continue;
+    int64_t bytes(getTensorBytes<real>(data));
+    if (bytes < 0) bytes = getTensorBytes<complex>(data);
+    // only tensors are freed, scalars and texts are kept
+    if (bytes < 0) continue;
+    SpillManager::forget(name);
+    delete data;
+    // remention it in case it will be written to in the future
+    new Data(name);
+    LOG(1, "root") << "freed " << name << " after its last use, memory="
+                   << bytes / (1024.0 * 1024.0 * 1024.0) << " GB"
+                   << std::endl;
+    freedBytes += bytes;
+  }
+  return freedBytes;
+}
+
 void Sisi4s::run() {
   EMIT() << YAML::BeginMap;
   printBanner();
@@ -42,6 +106,19 @@ void Sisi4s::run() {
                  << std::endl;
   EMIT() << YAML::Key << "execution-plan-size" << YAML::Value
          << algorithms.size();
+  const auto lastUses(getLastUses(algorithms));
+  int64_t totalFreedBytes(0);
+  std::vector<std::set<std::string>> stepUses;
+  for (const auto algorithm : algorithms) {
+    stepUses.push_back(std::set<std::string>());
+    for (const auto &argument : algorithm->arguments) {
+      stepUses.back().insert(argument.second);
+    }
+  }
+  const double GB(1024.0 * 1024.0 * 1024.0);
+  SpillManager::configure(options->spillMemory * GB,
+                          options->spillDirectory,
+                          stepUses);
 
   EMIT() << YAML::Key << "steps" << YAML::Value << YAML::BeginSeq;
 
@@ -68,6 +145,7 @@ void Sisi4s::run() {
       {
         FlopsCounter flopsCounter(&flops);
         Timer timer(&time);
+        SpillManager::beforeStep(i);
         const auto fallible = algorithms[i]->fallible;
         if (fallible) {
 #define ___CATCH(type, var, string)                                            \
@@ -87,6 +165,8 @@ void Sisi4s::run() {
         }
         delete algorithms[i];
       }
+      const int64_t freedBytes(freeTensors(lastUses[i]));
+      totalFreedBytes += freedBytes;
 
       std::stringstream realtime;
       realtime << time;
@@ -99,11 +179,29 @@ void Sisi4s::run() {
              << YAML::Comment(" seconds") << YAML::Key
              << "floating-point-operations" << YAML::Value << flops
              << YAML::Comment("on root process") << YAML::Key << "flops"
-             << YAML::Value << flops / time.getFractionalSeconds();
+             << YAML::Value << flops / time.getFractionalSeconds()
+             << YAML::Key << "freed-memory" << YAML::Value
+             << freedBytes / (1024.0 * 1024.0 * 1024.0) << YAML::Comment("GB");
+      const SpillManager::Statistics spills(SpillManager::takeStatistics());
+      if (options->spillMemory > 0.0) {
+        EMIT() << YAML::Key << "spill" << YAML::Value << YAML::BeginMap
+               << YAML::Key << "count" << YAML::Value << spills.spills
+               << YAML::Key << "memory" << YAML::Value
+               << spills.spilledBytes / GB << YAML::Comment("GB") << YAML::Key
+               << "realtime" << YAML::Value << spills.spillSeconds
+               << YAML::EndMap;
+        EMIT() << YAML::Key << "reload" << YAML::Value << YAML::BeginMap
+               << YAML::Key << "count" << YAML::Value << spills.reloads
+               << YAML::Key << "memory" << YAML::Value
+               << spills.reloadedBytes / GB << YAML::Comment("GB") << YAML::Key
+               << "realtime" << YAML::Value << spills.reloadSeconds
+               << YAML::EndMap;
+      }
       printStatistics();
       EMIT() << YAML::EndMap;
     }
   }
+  SpillManager::cleanup();
 
   EMIT() << YAML::EndSeq;
 
@@ -118,12 +216,17 @@ void Sisi4s::run() {
                  << " GFLOPS/s/core" << std::endl;
   LOG(0, "root") << "overall operations=" << totalFlops / 1.e9 << " GFLOPS"
                  << std::endl;
+  LOG(0, "root") << "memory freed after last use="
+                 << totalFreedBytes / (1024.0 * 1024.0 * 1024.0) << " GB"
+                 << std::endl;
   EMIT() << YAML::Key << "realtime" << YAML::Value << totalRealtime.str()
          << YAML::Key << "floating-point-operations" << YAML::Value << rootFlops
          << YAML::Comment("on root process") << YAML::Key << "flops"
          << YAML::Value << rootFlops / totalTime.getFractionalSeconds()
          << YAML::Key << "total-floating-point-operations" << totalFlops
-         << YAML::Comment("of all processes");
+         << YAML::Comment("of all processes") << YAML::Key
+         << "total-freed-memory" << YAML::Value
+         << totalFreedBytes / (1024.0 * 1024.0 * 1024.0) << YAML::Comment("GB");
 
   EMIT() << YAML::EndMap;
 }
@@ -139,6 +242,7 @@ void Sisi4s::dryRun() {
                  << std::endl;
   EMIT() << YAML::Key << "execution-plan-size" << YAML::Value
          << algorithms.size();
+  const auto lastUses(getLastUses(algorithms));
 
   EMIT() << YAML::Key << "steps" << YAML::Value << YAML::BeginSeq;
 
@@ -149,6 +253,7 @@ void Sisi4s::dryRun() {
     EMIT() << YAML::Key << "step" << YAML::Value << (i + 1) << YAML::Key
            << "name" << YAML::Value << algorithms[i]->getName();
     algorithms[i]->dryRun();
+    freeTensors(lastUses[i]);
     LOG(0, "root") << "estimated memory="
                    << DryMemory::maxTotalSize / (1024.0 * 1024.0 * 1024.0)
                    << " GB" << std::endl;
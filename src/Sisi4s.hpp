@@ -6,8 +6,12 @@
 
 #  include <util/CTF.hpp>
 #  include <Options.hpp>
+#  include <string>
+#  include <vector>
 
 namespace sisi4s {
+class Algorithm;
+
 class Sisi4s {
 public:
   void run();
@@ -20,6 +24,20 @@ public:
   void printBanner();
   void printStatistics();
   void listHosts();
+
+protected:
+  /**
+   * \brief Returns for each step of the execution plan the names of the
+   * data whose last use is in this step and which are not to be kept.
+   */
+  std::vector<std::vector<std::string>>
+  getLastUses(const std::vector<Algorithm *> &algorithms);
+
+  /**
+   * \brief Frees the tensors among the given data and returns the
+   * number of bytes freed over all processes.
+   */
+  int64_t freeTensors(const std::vector<std::string> &dataNames);
 };
 } // namespace sisi4s
 
@@ -6,6 +6,7 @@
 #include <util/Exception.hpp>
 #include <util/Emitter.hpp>
 #include <util/Log.hpp>
+#include <util/SpillManager.hpp>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -145,6 +146,7 @@ sisi4s::real Algorithm::getRealArgumentFromInteger(IntegerData *integerData) {
   return value;
 }
 sisi4s::real Algorithm::getRealArgumentFromTensor(TensorData<real> *data) {
+  if (!data->value) SpillManager::reload(data);
   Assert(data->value->order == 0,
          "Scalar expected in conversion from tensor to real.");
   // retrieve the real value from the tensor
@@ -190,7 +192,10 @@ template <typename F, typename T>
 T *Algorithm::getTensorArgument(std::string const &name) {
   Data *data(getArgumentData(name));
   TensorData<F, T> *tensorData(dynamic_cast<TensorData<F, T> *>(data));
-  if (tensorData) return tensorData->value;
+  if (tensorData) {
+    if (!tensorData->value) SpillManager::reload(tensorData);
+    return tensorData->value;
+  }
   RealData *realData(dynamic_cast<RealData *>(data));
   if (realData) return getTensorArgumentFromReal<F, T>(realData);
   // TODO: provide conversion routines from real to complex tensors
@@ -33,6 +33,8 @@ public:
 
   std::string note;
   bool fallible = false;
+  // names of the data not to be freed after their last use
+  std::vector<std::string> keep;
 
   bool isArgumentGiven(std::string const &argumentName);
   // retrieving input arguments
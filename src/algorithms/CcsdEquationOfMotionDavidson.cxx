@@ -110,10 +110,14 @@ void CcsdEquationOfMotionDavidson::run() {
                                            "amplitudesConvergence",
                                            "energyConvergence",
                                            "maxBasisSize",
+                                           "blockSize",
+                                           "subspaceMemory",
+                                           "subspaceDirectory",
                                            "intermediates",
                                            "eigenstates",
                                            "refreshIterations",
                                            "refreshOnMaxBasisSize",
+                                           "refreshBasisSize",
                                            "maxIterations",
                                            "minIterations"
                                            // preconditioner
@@ -154,7 +158,10 @@ void CcsdEquationOfMotionDavidson::run() {
                     getIntegerArgument("preconditionerSpinFlip", 1) == 1};
 
   const double energyConvergence(getRealArgument("energyConvergence", 1e-6)),
-      amplitudesConvergence(getRealArgument("amplitudesConvergence", 1e-6));
+      amplitudesConvergence(getRealArgument("amplitudesConvergence", 1e-6)),
+      subspaceMemory(getRealArgument("subspaceMemory", 0.0));
+  const std::string subspaceDirectory(
+      getTextArgument("subspaceDirectory", "."));
 
   const typename SimilarityTransformedHamiltonian<F>::StructureFactorSettings
       sfSettings = {getIntegerArgument("structureFactorOnlySingles", 0) == 1,
@@ -179,6 +186,8 @@ void CcsdEquationOfMotionDavidson::run() {
       structureFactorIndices(argToRange("structureFactorRange"));
 
   const unsigned int eigenStates(getIntegerArgument("eigenstates", 1)),
+      blockSize(getIntegerArgument("blockSize", 1)),
+      refreshBasisSize(getIntegerArgument("refreshBasisSize", 0)),
       maxIterations(getIntegerArgument("maxIterations", 32)),
       minIterations(getIntegerArgument("minIterations", 1));
 
@@ -204,7 +213,8 @@ void CcsdEquationOfMotionDavidson::run() {
          << YAML::Value << No << YAML::Key << "maxBasisSize" << YAML::Value
          << maxBasisSize << YAML::Key << "maxIterations" << YAML::Value
          << maxIterations << YAML::Key << "eigenStates" << YAML::Value
-         << eigenStates;
+         << eigenStates << YAML::Key << "blockSize" << YAML::Value
+         << blockSize;
 
   // Logging arguments
   LOGGER(0) << "max iter         : " << maxIterations << std::endl;
@@ -213,6 +223,11 @@ void CcsdEquationOfMotionDavidson::run() {
   LOGGER(0) << "No               : " << No << std::endl;
   LOGGER(0) << "Nv               : " << Nv << std::endl;
   LOGGER(0) << "max basis        : " << maxBasisSize << std::endl;
+  LOGGER(0) << "block size       : " << blockSize << std::endl;
+  if (subspaceMemory > 0.0) {
+    LOGGER(0) << "subspace memory  : " << subspaceMemory << " GB in "
+              << subspaceDirectory << std::endl;
+  }
 
   for (auto &integral : requiredIntegrals) {
     LOGGER(0) << "Converting " << integral.name << std::endl;
@@ -328,6 +343,10 @@ void CcsdEquationOfMotionDavidson::run() {
                   minIterations);
 
   eigenSystem.refreshOnMaxBasisSize(refreshOnMaxBasisSize);
+  eigenSystem.blockSize(blockSize);
+  eigenSystem.refreshBasisSize(refreshBasisSize);
+  eigenSystem.subspaceMemory(subspaceMemory * 1024.0 * 1024.0 * 1024.0,
+                             subspaceDirectory);
   if (eigenSystem.refreshOnMaxBasisSize())
     LOGGER(0) << "Refreshing on max basis size reaching" << std::endl;
 
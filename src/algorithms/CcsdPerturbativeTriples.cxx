@@ -8,6 +8,8 @@
 #include <util/Exception.hpp>
 #include <Sisi4s.hpp>
 #include <util/Tensor.hpp>
+#include <extern/Lapack.hpp>
+#include <mpi.h>
 
 using namespace sisi4s;
 
@@ -121,6 +123,31 @@ void CcsdPerturbativeTriples::run() {
   Tensor<double> *epsa(getTensorArgument("ParticleEigenEnergies"));
   No = epsi->lens[0];
   Nv = epsa->lens[0];
+
+  // ctf: evaluate each i,j,k with distributed CTF expressions,
+  // local: replicate the tensors and evaluate each i,j,k on a single rank
+  const std::string backend(getTextArgument("backend", "ctf"));
+  LOG(0, "CcsdPerturbativeTriples") << "backend: " << backend << std::endl;
+  double eTriples;
+  if (backend == "ctf") {
+    eTriples = getCtfTriplesEnergy();
+  } else if (backend == "local") {
+    eTriples = getLocalTriplesEnergy();
+  } else {
+    throw new EXCEPTION("Unknown backend " + backend + ", use ctf or local");
+  }
+
+  double eCcsd(getRealArgument("CcsdEnergy"));
+  double e(eCcsd + eTriples);
+  LOG(0, "CcsdPerturbativeTriples") << "e=" << e << std::endl;
+  LOG(1, "CcsdPerturbativeTriples") << "ccsd=" << eCcsd << std::endl;
+  LOG(1, "CcsdPerturbativeTriples") << "triples=" << eTriples << std::endl;
+
+  setRealArgument("CcsdPerturbativeTriplesEnergy", e);
+}
+
+double CcsdPerturbativeTriples::getCtfTriplesEnergy() {
+  Tensor<double> *epsi(getTensorArgument("HoleEigenEnergies"));
   int vvv[] = {Nv, Nv, Nv};
   int syms[] = {NS, NS, NS};
   // doubles amplitudes contracted with V for current i,j,k
@@ -237,14 +264,284 @@ void CcsdPerturbativeTriples::run() {
   delete realGammaFai;
   delete imagGammaFai;
 
-  double eTriples(energy.get_val());
-  double eCcsd(getRealArgument("CcsdEnergy"));
-  double e(eCcsd + eTriples);
-  LOG(0, "CcsdPerturbativeTriples") << "e=" << e << std::endl;
-  LOG(1, "CcsdPerturbativeTriples") << "ccsd=" << eCcsd << std::endl;
-  LOG(1, "CcsdPerturbativeTriples") << "triples=" << eTriples << std::endl;
+  return energy.get_val();
+}
 
-  setRealArgument("CcsdPerturbativeTriplesEnergy", e);
+void CcsdPerturbativeTriples::replicateTensors() {
+  getTensorArgument("HoleEigenEnergies")->read_all(localEpsi.data());
+  getTensorArgument("ParticleEigenEnergies")->read_all(localEpsa.data());
+  getTensorArgument("CcsdSinglesAmplitudes")->read_all(localTai.data());
+  getTensorArgument("CcsdDoublesAmplitudes")->read_all(localTabij.data());
+  getTensorArgument("PPHHCoulombIntegrals")->read_all(localVabij.data());
+
+  // reorder V[jklc] to V[lc](jk)
+  std::vector<double> Vjklc(localVlcjk.size());
+  getTensorArgument("HHHPCoulombIntegrals")->read_all(Vjklc.data());
+  for (int64_t c(0); c < Nv; ++c) {
+    for (int64_t l(0); l < No; ++l) {
+      for (int64_t jk(0); jk < No * No; ++jk) {
+        localVlcjk[l + No * c + No * Nv * jk] =
+            Vjklc[jk + No * No * l + No * No * No * c];
+      }
+    }
+  }
+
+  Tensor<complex> *GammaFqr(getTensorArgument<complex>("CoulombVertex"));
+  int Np(GammaFqr->lens[1]);
+  int aStart(Np - Nv), aEnd(Np);
+  int FaiStart[] = {0, aStart, 0};
+  int FaiEnd[] = {NF, aEnd, No};
+  int FabStart[] = {0, aStart, aStart};
+  int FabEnd[] = {NF, aEnd, aEnd};
+  Tensor<complex> GammaFai(GammaFqr->slice(FaiStart, FaiEnd));
+  Tensor<complex> GammaFab(GammaFqr->slice(FabStart, FabEnd));
+  Tensor<double> realGammaFai(3,
+                              GammaFai.lens,
+                              GammaFai.sym,
+                              *GammaFai.wrld,
+                              "RealGammaFai");
+  Tensor<double> imagGammaFai(realGammaFai);
+  fromComplexTensor(GammaFai, realGammaFai, imagGammaFai);
+  realGammaFai.read_all(realGai.data());
+  imagGammaFai.read_all(imagGai.data());
+
+  Tensor<double> realGammaFab(3,
+                              GammaFab.lens,
+                              GammaFab.sym,
+                              *GammaFab.wrld,
+                              "RealGammaFab");
+  Tensor<double> imagGammaFab(realGammaFab);
+  fromComplexTensor(GammaFab, realGammaFab, imagGammaFab);
+  std::vector<double> realGab(realGammaFdb.size());
+  std::vector<double> imagGab(imagGammaFdb.size());
+  realGammaFab.read_all(realGab.data());
+  imagGammaFab.read_all(imagGab.data());
+  // swap b and d for contracting Gamma[Fdb] over F and Tabij over d
+  for (int64_t b(0); b < Nv; ++b) {
+    for (int64_t d(0); d < Nv; ++d) {
+      for (int64_t F(0); F < NF; ++F) {
+        realGammaFdb[F + NF * (d + Nv * b)] = realGab[F + NF * (b + Nv * d)];
+        imagGammaFdb[F + NF * (d + Nv * b)] = imagGab[F + NF * (b + Nv * d)];
+      }
+    }
+  }
+}
+
+void CcsdPerturbativeTriples::getLocalDoublesContribution(const Map<3> &i,
+                                                          double *scratch,
+                                                          double *DVabc) {
+  // blas needs int, Nv^2 does not overflow for feasible systems
+  int blasNv(Nv), blasNvNv(Nv * Nv), blasNo(No), blasNF(NF);
+  int blasNvNvNo(Nv * Nv * No);
+  double zero(0.0), one(1.0), minusOne(-1.0);
+  // X[dbc] = Gamma[Fdb] * Gamma[Fck] for the given k
+  const int64_t k(i(2));
+  dgemm_("T",
+         "N",
+         &blasNvNv,
+         &blasNv,
+         &blasNF,
+         &one,
+         realGammaFdb.data(),
+         &blasNF,
+         &realGai[NF * Nv * k],
+         &blasNF,
+         &zero,
+         scratch,
+         &blasNvNv);
+  dgemm_("T",
+         "N",
+         &blasNvNv,
+         &blasNv,
+         &blasNF,
+         &one,
+         imagGammaFdb.data(),
+         &blasNF,
+         &imagGai[NF * Nv * k],
+         &blasNF,
+         &one,
+         scratch,
+         &blasNvNv);
+  // DV[abc] = T[ad](ij) * X[dbc]
+  dgemm_("N",
+         "N",
+         &blasNv,
+         &blasNvNv,
+         &blasNv,
+         &one,
+         &localTabij[Nv * Nv * (i(0) + No * i(1))],
+         &blasNv,
+         scratch,
+         &blasNv,
+         &zero,
+         DVabc,
+         &blasNv);
+  // DV[abc] -= T[ab](i)[l] * V[lc](jk)
+  dgemm_("N",
+         "N",
+         &blasNvNv,
+         &blasNv,
+         &blasNo,
+         &minusOne,
+         &localTabij[Nv * Nv * i(0)],
+         &blasNvNvNo,
+         &localVlcjk[No * Nv * (i(1) + No * i(2))],
+         &blasNo,
+         &one,
+         DVabc,
+         &blasNvNv);
+}
+
+void CcsdPerturbativeTriples::addLocalSinglesContribution(const Map<3> &i,
+                                                          double *Zabc) {
+  const double *Ta(&localTai[Nv * i(0)]);
+  const double *Vbc(&localVabij[Nv * Nv * (i(1) + No * i(2))]);
+#pragma omp parallel for
+  for (int64_t bc = 0; bc < Nv * Nv; bc++) {
+    for (int64_t a(0); a < Nv; a++) {
+      Zabc[a + Nv * bc] += 0.5 * Ta[a] * Vbc[bc];
+    }
+  }
+}
+
+namespace {
+// strides of the a,b,c in a Nv^3 tensor whose n-th index is given by
+// the index f(n) of a,b,c
+void getStrides(const sisi4s::Map<3> &f, const int64_t Nv, int64_t *strides) {
+  int64_t stride(1);
+  for (int n(0); n < 3; ++n) {
+    strides[f(n)] = stride;
+    stride *= Nv;
+  }
+}
+} // namespace
+
+double CcsdPerturbativeTriples::getLocalTriplesEnergy() {
+  Tensor<complex> *GammaFqr(getTensorArgument<complex>("CoulombVertex"));
+  NF = GammaFqr->lens[0];
+  const int64_t NvCube(int64_t(Nv) * Nv * Nv);
+  localEpsi.resize(No);
+  localEpsa.resize(Nv);
+  localTai.resize(Nv * No);
+  localTabij.resize(int64_t(Nv) * Nv * No * No);
+  localVabij.resize(int64_t(Nv) * Nv * No * No);
+  localVlcjk.resize(int64_t(No) * No * No * Nv);
+  realGammaFdb.resize(int64_t(NF) * Nv * Nv);
+  imagGammaFdb.resize(int64_t(NF) * Nv * Nv);
+  realGai.resize(int64_t(NF) * Nv * No);
+  imagGai.resize(int64_t(NF) * Nv * No);
+  replicateTensors();
+
+  // D.V for all permutations of a,b,c together with i,j,k
+  std::vector<double> piDVabc(Permutation<3>::ORDER * NvCube);
+  std::vector<double> DVabc(NvCube), scratch(NvCube);
+  // spin factors and Fermion sign depending on the number of
+  // invariant indices when permuting a,b,c keeping i,j,k fixed.
+  // having 2 invariant indices is impossible
+  const double spinAndFermiFactors[] = {+2.0, -4.0, 0.0, +8.0};
+  // strides of piDVabc in permutation pi and sigma*pi of a,b,c
+  int64_t piStrides[Permutation<3>::ORDER][3];
+  int64_t sigmaPiStrides[Permutation<3>::ORDER][Permutation<3>::ORDER][3];
+  for (int p(0); p < Permutation<3>::ORDER; ++p) {
+    Permutation<3> pi(p);
+    getStrides(pi, Nv, piStrides[p]);
+    for (int s(0); s < Permutation<3>::ORDER; ++s) {
+      Permutation<3> sigma(s);
+      getStrides(sigma * pi, Nv, sigmaPiStrides[p][s]);
+    }
+  }
+
+  const int rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  double energy(0.0);
+  Map<3> i;
+  // go through all N distinct orders 0 <= i(0) <= i(1) <= i(2) < No,
+  // distributed cyclically among the ranks
+  int n(0), localN(0);
+  const int N(No * (No + 1) * (No + 2) / 6);
+  Time startTime(Time::getCurrentRealTime());
+  for (i(0) = 0; i(0) < No; ++i(0)) {
+    for (i(1) = i(0); i(1) < No; ++i(1)) {
+      for (i(2) = i(1); i(2) < No; ++i(2), ++n) {
+        if (n % np != rank) continue;
+        // the equivalent distinct permutation of each permutation of i,j,k
+        int distinct[Permutation<3>::ORDER];
+        for (int p(0); p < Permutation<3>::ORDER; ++p) {
+          Permutation<3> pi(p);
+          for (distinct[p] = 0; distinct[p] < p; ++distinct[p]) {
+            if (i * Permutation<3>(distinct[p]) == i * pi) break;
+          }
+          if (distinct[p] == p) {
+            getLocalDoublesContribution(i * pi,
+                                        scratch.data(),
+                                        &piDVabc[p * NvCube]);
+          }
+        }
+
+        // sum over all permutations of i,j,k together with a,b,c
+        // divided by the energy denominator
+        const double epsijk(localEpsi[i(0)] + localEpsi[i(1)]
+                            + localEpsi[i(2)]);
+#pragma omp parallel for
+        for (int64_t c = 0; c < Nv; c++) {
+          for (int64_t b(0); b < Nv; b++) {
+            for (int64_t a(0); a < Nv; a++) {
+              double dv(0.0);
+              for (int p(0); p < Permutation<3>::ORDER; ++p) {
+                const int64_t *st(piStrides[p]);
+                dv += piDVabc[distinct[p] * NvCube + a * st[0] + b * st[1]
+                              + c * st[2]];
+              }
+              DVabc[a + Nv * b + Nv * Nv * c] =
+                  dv / (epsijk - localEpsa[a] - localEpsa[b] - localEpsa[c]);
+            }
+          }
+        }
+
+        for (int p(0); p < Permutation<3>::ORDER; ++p) {
+          if (distinct[p] != p) continue;
+          // all distinct permutation pi of i,j,k together with a,b,c
+          Permutation<3> pi(p);
+          double *Zabc(&piDVabc[p * NvCube]);
+          addLocalSinglesContribution(i * pi, Zabc);
+          double piEnergy(0.0);
+#pragma omp parallel for reduction(+ : piEnergy)
+          for (int64_t c = 0; c < Nv; c++) {
+            for (int64_t b(0); b < Nv; b++) {
+              for (int64_t a(0); a < Nv; a++) {
+                // after pi, permute a,b,c with sigma leaving i,j,k fixed.
+                double t(0.0);
+                for (int s(0); s < Permutation<3>::ORDER; ++s) {
+                  Permutation<3> sigma(s);
+                  const int64_t *st(sigmaPiStrides[p][s]);
+                  t += spinAndFermiFactors[sigma.invariantElementsCount()]
+                     * Zabc[a * st[0] + b * st[1] + c * st[2]];
+                }
+                piEnergy += DVabc[a + Nv * b + Nv * Nv * c] * t;
+              }
+            }
+          }
+          energy += piEnergy;
+        }
+        ++localN;
+        LOG(1, "CcsdPerturbativeTriples")
+            << n + 1 << "/" << N << " distinct indices calculated, ETA="
+            << (Time::getCurrentRealTime() - startTime)
+                   * (static_cast<double>(N) / (n + 1) - 1)
+            << " s" << std::endl;
+      }
+    }
+  }
+  LOG(1, "CcsdPerturbativeTriples")
+      << "distinct indices calculated on this rank: " << localN << std::endl;
+
+  double localEnergy(energy);
+  MPI_Allreduce(&localEnergy,
+                &energy,
+                1,
+                MPI_DOUBLE,
+                MPI_SUM,
+                Sisi4s::world->comm);
+  return energy;
 }
 
 void CcsdPerturbativeTriples::dryRun() {
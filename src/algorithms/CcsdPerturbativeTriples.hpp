@@ -4,6 +4,7 @@
 #include <algorithms/Algorithm.hpp>
 #include <math/Permutation.hpp>
 #include <util/SlicedCtfTensor.hpp>
+#include <vector>
 
 namespace sisi4s {
 /**
@@ -35,6 +36,29 @@ protected:
   Tensor<double> &getSinglesContribution(const Map<3> &);
   Tensor<double> &getDoublesContribution(const Map<3> &);
   Tensor<double> &getEnergyDenominator(const Map<3> &);
+
+  /**
+   * \brief Evaluates the triples energy with CTF expressions for each i,j,k.
+   */
+  double getCtfTriplesEnergy();
+
+  /**
+   * \brief Evaluates the triples energy with node-local BLAS kernels.
+   * The required tensors are replicated on each rank once and the
+   * i,j,k are distributed among the ranks.
+   */
+  double getLocalTriplesEnergy();
+
+  // replicated tensors of the local backend, first index fastest
+  std::vector<double> localEpsi, localEpsa, localTai, localTabij, localVabij;
+  // Vijla reordered to V[lc](jk) for contiguous slabs in j,k
+  std::vector<double> localVlcjk;
+  // GammaFab with b,d swapped to Gamma[Fdb], and GammaFai
+  std::vector<double> realGammaFdb, imagGammaFdb, realGai, imagGai;
+  int NF;
+  void replicateTensors();
+  void getLocalDoublesContribution(const Map<3> &, double *scratch, double *);
+  void addLocalSinglesContribution(const Map<3> &, double *);
 };
 } // namespace sisi4s
 
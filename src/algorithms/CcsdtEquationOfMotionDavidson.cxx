@@ -48,6 +48,10 @@ void CcsdtEquationOfMotionDavidson::run() {
       getRealArgument("preconditionerRandomSigma", 0.1));
   bool refreshOnMaxBasisSize(getIntegerArgument("refreshOnMaxBasisSize", 0)
                              == 1);
+  unsigned int blockSize(getIntegerArgument("blockSize", 1));
+  unsigned int refreshBasisSize(getIntegerArgument("refreshBasisSize", 0));
+  double subspaceMemory(getRealArgument("subspaceMemory", 0.0));
+  std::string subspaceDirectory(getTextArgument("subspaceDirectory", "."));
   std::vector<int> oneBodyRdmIndices(
       RangeParser(getTextArgument("oneBodyRdmRange", "")).getRange());
   int eigenStates(getIntegerArgument("eigenStates", 1));
@@ -83,6 +87,11 @@ void CcsdtEquationOfMotionDavidson::run() {
   LOG(0, "CcsdtEomDavid") << "No: " << No << std::endl;
   LOG(0, "CcsdtEomDavid") << "Nv: " << Nv << std::endl;
   LOG(0, "CcsdtEomDavid") << "maxBasisSize: " << maxBasisSize << std::endl;
+  LOG(0, "CcsdtEomDavid") << "blockSize: " << blockSize << std::endl;
+  if (subspaceMemory > 0.0) {
+    LOG(0, "CcsdtEomDavid") << "subspaceMemory: " << subspaceMemory << " GB in "
+                            << subspaceDirectory << std::endl;
+  }
 
   // Get copy of couloumb integrals
   Tensor<double> *pVijkl(
@@ -312,6 +321,10 @@ void CcsdtEquationOfMotionDavidson::run() {
                   maxIterations,
                   minIterations);
   eigenSystem.refreshOnMaxBasisSize(refreshOnMaxBasisSize);
+  eigenSystem.blockSize(blockSize);
+  eigenSystem.refreshBasisSize(refreshBasisSize);
+  eigenSystem.subspaceMemory(subspaceMemory * 1024.0 * 1024.0 * 1024.0,
+                             subspaceDirectory);
   if (eigenSystem.refreshOnMaxBasisSize()) {
     LOG(0, "CcsdtEomDavid")
         << "Refreshing on max basis size reaching" << std::endl;
@@ -10,6 +10,7 @@
 #include <util/Tensor.hpp>
 #include <Options.hpp>
 #include <Sisi4s.hpp>
+#include <algorithm>
 #include <array>
 
 #include <initializer_list>
@@ -82,10 +83,22 @@ F ClusterSinglesDoublesAlgorithm::run() {
            << getIntegerArgument("integralsSliceSize");
   }
 
-  EMIT() << YAML::Key << "iterations" << YAML::Value;
-  EMIT() << YAML::BeginSeq;
+  // write a checkpoint every checkpointInterval iterations, if positive,
+  // and continue from the last one, if any
+  int checkpointInterval(getIntegerArgument("checkpointInterval", 0));
+  Checkpoint checkpoint(getTextArgument("checkpointDirectory", "."),
+                        getAbbreviation());
   F e(0), previousE(0);
   int i(0);
+  if (checkpointInterval > 0) {
+    EMIT() << YAML::Key << "checkpointInterval" << YAML::Value
+           << checkpointInterval;
+    i = readCheckpoint(checkpoint, amplitudes, mixer, previousE);
+    e = previousE;
+  }
+
+  EMIT() << YAML::Key << "iterations" << YAML::Value;
+  EMIT() << YAML::BeginSeq;
   for (; i < maxIterationsCount; ++i) {
     EMIT() << YAML::BeginMap;
     LOG(0, getCapitalizedAbbreviation()) << "iteration: " << i + 1 << std::endl;
@@ -109,6 +122,9 @@ F ClusterSinglesDoublesAlgorithm::run() {
       break;
     }
     previousE = e;
+    if (checkpointInterval > 0 && (i + 1) % checkpointInterval == 0) {
+      writeCheckpoint(checkpoint, i + 1, mixer, previousE);
+    }
     EMIT() << YAML::EndMap;
   }
   EMIT() << YAML::EndSeq;
@@ -121,6 +137,9 @@ F ClusterSinglesDoublesAlgorithm::run() {
     LOG(0, getCapitalizedAbbreviation())
         << "WARNING: energy or amplitudes convergence not reached."
         << std::endl;
+  } else if (checkpointInterval > 0) {
+    // converged, not to be continued by a later calculation
+    checkpoint.remove();
   }
 
   storeAmplitudes(amplitudes, {"Singles", "Doubles"});
@@ -284,6 +303,76 @@ ClusterSinglesDoublesAlgorithm::createAmplitudes(
     std::vector<std::vector<TensorIndex>> amplitudeLens,
     std::vector<std::string> amplitudeIndices);
 
+template <typename F>
+int ClusterSinglesDoublesAlgorithm::readCheckpoint(
+    Checkpoint &checkpoint,
+    PTR(const FockVector<F>) &amplitudes,
+    const PTR(Mixer<F>) &mixer,
+    F &energy) {
+  if (!checkpoint.load()) return 0;
+  const int iterationsCount(checkpoint.getInteger("iterations"));
+  mixer->readCheckpoint(checkpoint);
+  // the checkpoint may be of another system or calculation
+  const PTR(const FockVector<F>) restored(mixer->get());
+  bool matching(restored->get_components_count()
+                == amplitudes->get_components_count());
+  for (size_t c(0); matching && c < amplitudes->get_components_count(); ++c) {
+    const auto &T(*amplitudes->get(c)), &R(*restored->get(c));
+    matching = T.order == R.order
+            && std::equal(T.lens, T.lens + T.order, R.lens)
+            && amplitudes->get_indices(c) == restored->get_indices(c);
+  }
+  if (!matching) {
+    throw new EXCEPTION("Amplitudes in checkpoint " + checkpoint.getFileName()
+                        + " do not match the current system, remove it to "
+                          "start from scratch");
+  }
+  amplitudes = restored;
+  energy = checkpoint.getScalar<F>("energy");
+  LOG(0, getCapitalizedAbbreviation())
+      << "continuing after iteration " << iterationsCount << std::endl;
+  EMIT() << YAML::Key << "restartedFromIteration" << YAML::Value
+         << iterationsCount;
+  return iterationsCount;
+}
+
+template int ClusterSinglesDoublesAlgorithm::readCheckpoint(
+    Checkpoint &checkpoint,
+    PTR(const FockVector<sisi4s::Float64>) &amplitudes,
+    const PTR(Mixer<sisi4s::Float64>) &mixer,
+    sisi4s::Float64 &energy);
+
+template int ClusterSinglesDoublesAlgorithm::readCheckpoint(
+    Checkpoint &checkpoint,
+    PTR(const FockVector<sisi4s::Complex64>) &amplitudes,
+    const PTR(Mixer<sisi4s::Complex64>) &mixer,
+    sisi4s::Complex64 &energy);
+
+template <typename F>
+void ClusterSinglesDoublesAlgorithm::writeCheckpoint(
+    Checkpoint &checkpoint,
+    const int iterationsCount,
+    const PTR(Mixer<F>) &mixer,
+    const F energy) {
+  checkpoint.begin();
+  checkpoint.setInteger("iterations", iterationsCount);
+  checkpoint.setScalar<F>("energy", energy);
+  mixer->writeCheckpoint(checkpoint);
+  checkpoint.commit();
+}
+
+template void ClusterSinglesDoublesAlgorithm::writeCheckpoint(
+    Checkpoint &checkpoint,
+    const int iterationsCount,
+    const PTR(Mixer<sisi4s::Float64>) &mixer,
+    const sisi4s::Float64 energy);
+
+template void ClusterSinglesDoublesAlgorithm::writeCheckpoint(
+    Checkpoint &checkpoint,
+    const int iterationsCount,
+    const PTR(Mixer<sisi4s::Complex64>) &mixer,
+    const sisi4s::Complex64 energy);
+
 template <typename F>
 void ClusterSinglesDoublesAlgorithm::storeAmplitudes(
     const PTR(const FockVector<F>) &amplitudes,
@@ -3,7 +3,9 @@
 
 #include <algorithms/Algorithm.hpp>
 #include <math/FockVector.hpp>
+#include <mixers/Mixer.hpp>
 #include <DryTensor.hpp>
+#include <util/Checkpoint.hpp>
 #include <util/SharedPointer.hpp>
 
 #include <util/Tensor.hpp>
@@ -107,6 +109,28 @@ protected:
   void storeAmplitudes(const PTR(const FockVector<F>) &amplitudes,
                        std::vector<std::string> names);
 
+  /**
+   * \brief Restores the amplitudes, the state of the mixer and the energy
+   * of the last completed iteration from the given checkpoint, if any.
+   * Returns the index of the iteration to continue with, 0 otherwise.
+   **/
+  template <typename F>
+  int readCheckpoint(Checkpoint &checkpoint,
+                     PTR(const FockVector<F>) &amplitudes,
+                     const PTR(Mixer<F>) &mixer,
+                     F &energy);
+
+  /**
+   * \brief Writes the state of the mixer, whose estimate is the current
+   * amplitudes, and the energy after the given number of completed
+   * iterations to the given checkpoint.
+   **/
+  template <typename F>
+  void writeCheckpoint(Checkpoint &checkpoint,
+                       const int iterationsCount,
+                       const PTR(Mixer<F>) &mixer,
+                       const F energy);
+
   /**
    * \brief Calculates and returns one slice Xxycd of the Coulomb integrals
    * \f$V_{cd}^{ab}\f$ coupled to the singles amplitudes. The indices x and y
@@ -67,11 +67,23 @@ F ClusterSinglesDoublesTriplesAlgorithm::run() {
          << std::abs(amplitudesConvergence) << YAML::Key << "energyConvergence"
          << YAML::Value << std::abs(energyConvergence);
 
+  // write a checkpoint every checkpointInterval iterations, if positive,
+  // and continue from the last one, if any
+  int checkpointInterval(getIntegerArgument("checkpointInterval", 0));
+  Checkpoint checkpoint(getTextArgument("checkpointDirectory", "."),
+                        getAbbreviation());
+  F e(0), previousE(0);
+  int i(0);
+  if (checkpointInterval > 0) {
+    EMIT() << YAML::Key << "checkpointInterval" << YAML::Value
+           << checkpointInterval;
+    i = readCheckpoint(checkpoint, amplitudes, mixer, previousE);
+    e = previousE;
+  }
+
   EMIT() << YAML::Key << "iterations" << YAML::Value;
   EMIT() << YAML::BeginSeq;
 
-  F e(0), previousE(0);
-  int i(0);
   for (; i < maxIterationsCount; ++i) {
     EMIT() << YAML::BeginMap;
     LOG(0, getCapitalizedAbbreviation()) << "iteration: " << i + 1 << std::endl;
@@ -94,6 +106,9 @@ F ClusterSinglesDoublesTriplesAlgorithm::run() {
       break;
     }
     previousE = e;
+    if (checkpointInterval > 0 && (i + 1) % checkpointInterval == 0) {
+      writeCheckpoint(checkpoint, i + 1, mixer, previousE);
+    }
     EMIT() << YAML::EndMap;
   }
   EMIT() << YAML::EndSeq;
@@ -106,6 +121,9 @@ F ClusterSinglesDoublesTriplesAlgorithm::run() {
     LOG(0, getCapitalizedAbbreviation())
         << "WARNING: energy or amplitudes convergence not reached."
         << std::endl;
+  } else if (checkpointInterval > 0) {
+    // converged, not to be continued by a later calculation
+    checkpoint.remove();
   }
 
   storeAmplitudes(amplitudes, {"Singles", "Doubles", "Triples"});
@@ -60,8 +60,17 @@ F ClusterSinglesDoublesTriplesQuadruplesAlgorithm::run() {
   int maxIterationsCount(
       getIntegerArgument("maxIterations", DEFAULT_MAX_ITERATIONS));
 
+  // write a checkpoint every checkpointInterval iterations, if positive,
+  // and continue from the last one, if any
+  int checkpointInterval(getIntegerArgument("checkpointInterval", 0));
+  Checkpoint checkpoint(getTextArgument("checkpointDirectory", "."),
+                        getAbbreviation());
   F e(0);
-  for (int i(0); i < maxIterationsCount; ++i) {
+  int i(0);
+  if (checkpointInterval > 0) {
+    i = readCheckpoint(checkpoint, amplitudes, mixer, e);
+  }
+  for (; i < maxIterationsCount; ++i) {
     LOG(0, getCapitalizedAbbreviation()) << "iteration: " << i + 1 << std::endl;
     // call the getResiduum of the actual algorithm,
     // which will be specified by inheriting classes
@@ -73,7 +82,12 @@ F ClusterSinglesDoublesTriplesQuadruplesAlgorithm::run() {
     // get mixer's best guess for amplitudes
     amplitudes = mixer->get();
     e = getEnergy(amplitudes);
+    if (checkpointInterval > 0 && (i + 1) % checkpointInterval == 0) {
+      writeCheckpoint(checkpoint, i + 1, mixer, e);
+    }
   }
+  // all iterations done, not to be continued by a later calculation
+  if (checkpointInterval > 0) checkpoint.remove();
 
   if (maxIterationsCount == 0) {
     LOG(0, getCapitalizedAbbreviation())
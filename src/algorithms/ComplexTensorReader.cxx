@@ -34,7 +34,12 @@ void ComplexTensorReader::run() {
     std::string fileName(getTextArgument("file", dataName + ".dat"));
     std::string delimiter(getTextArgument("delimiter", " "));
     int64_t bufferSize(getIntegerArgument("bufferSize", 128l * 1024 * 1024));
-    A = TensorIo::readText<complex>(fileName, delimiter, bufferSize);
+    // the file is only accessible by the root, e.g. on its local disk
+    bool localOnly(getIntegerArgument("localOnly", 0) == 1);
+    A = TensorIo::readText<complex>(fileName,
+                                    delimiter,
+                                    bufferSize,
+                                    localOnly);
     EMIT() << YAML::Key << "file" << YAML::Value << fileName;
   }
   A->set_name(dataName.c_str());
@@ -25,7 +25,12 @@ void ComplexTensorWriter::run() {
   if (mode == "binary") {
     // write binary
     std::string fileName(getTextArgument("file", dataName + ".bin"));
-    TensorIo::writeBinary<complex>(fileName, *A);
+    TensorIo::writeBinary<complex>(
+        fileName,
+        *A,
+        BinaryTensorHeaderBase::getVersion(getIntegerArgument("version", 1)),
+        BinaryTensorCodec::getFilters(getTextArgument("compression", "none")),
+        getIntegerArgument("elementsPerChunk", 1024 * 1024));
     EMIT() << YAML::Key << "file" << YAML::Value << fileName;
   } else {
     // write text
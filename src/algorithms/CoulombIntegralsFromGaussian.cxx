@@ -6,15 +6,19 @@
 #include <algorithm>
 
 #include <util/Libint.hpp>
+#include <util/SchwarzScreening.hpp>
+#include <util/OpenMp.hpp>
 #include <algorithms/CoulombIntegralsFromGaussian.hpp>
 #include <util/Tensor.hpp>
 #include <Sisi4s.hpp>
 #include <util/Log.hpp>
+#include <util/Timer.hpp>
 #include <util/Integrals.hpp>
 #include <iostream>
 #include <util/Tensor.hpp>
 #include <util/Emitter.hpp>
 #include <math/MathFunctions.hpp>
+#include <math/QuarterTransformation.hpp>
 
 #define LOGGER(_l) LOG(_l, "CoulombIntegralsFromGaussian")
 
@@ -39,40 +43,40 @@ struct ShellInfo {
 };
 
 struct CoulombIntegralsProvider {
-  enum Distribution { SIMPLE, ROUND_ROBIN };
+  enum Distribution { SIMPLE, ROUND_ROBIN, COST };
   CoulombIntegralsProvider(const libint2::BasisSet &shells_,
                            const Operator op_,
-                           const Distribution d,
-                           const size_t maxElementsWrite_)
+                           const Distribution d_,
+                           const size_t maxElementsWrite_,
+                           const double screeningThreshold_,
+                           const int threads_)
       : Np(shells_.nbf())
       , shells(shells_)
       , op(op_)
+      , distribution(d_)
       , maxElementsWrite(maxElementsWrite_)
       , maxShellNbf(2 * shells.max_l() + 1)
       , maxShellElements(maxShellNbf * Np * Np * Np)
-      , writesPerShell(maxShellElements / maxElementsWrite + 1) {
+      , screeningThreshold(screeningThreshold_)
+      , threads(threads_)
+      , computedQuartets(0)
+      , screenedQuartets(0) {
 
-    const auto toCtfIdx([&](const size_t i) { return i * Np * Np * Np; });
-
-    // set mpiShells
-    if (d == SIMPLE) doSimpleDistribution();
-    else doRoundRobinDistribution();
-
-    // How many writes will we make per shells is controlled by the
-    // ratio of maxShellElements / maxElementsWrite
-    LOGGER(1) << "writes per shell   : " << writesPerShell << std::endl;
     LOGGER(1) << "max shell l        : " << shells.max_l() << std::endl;
     LOGGER(1) << "max shell nbf      : " << maxShellNbf << std::endl;
     LOGGER(1) << "max shell elements : " << maxShellElements << std::endl;
     LOGGER(1) << "max elem write     : " << maxElementsWrite << std::endl;
+    LOGGER(1) << "screening threshold: " << screeningThreshold << std::endl;
+    LOGGER(1) << "threads            : " << threads << std::endl;
+  }
 
-    const size_t np(Sisi4s::world->np);
-    // this we need to be able to tell every np how many times
-    // it should perform an mpi operation in the case it is necessary
-    maxSize =
-        (shells.size() < np) ? 1 : shells.size() / np + shells.size() % np;
-
-    LOGGER(1) << "maxSize: " << maxSize << std::endl;
+  // set mpiShells, the leading shells K computed by this rank.
+  // No is the number of transformed orbitals for the half contraction.
+  void distribute(const bool halfContract, const size_t No = 0) {
+    mpiShells.clear();
+    if (distribution == SIMPLE) doSimpleDistribution();
+    else if (distribution == ROUND_ROBIN) doRoundRobinDistribution();
+    else doCostDistribution(halfContract, No);
 
     {
       std::stringstream s; // print the mpiShells
@@ -80,27 +84,67 @@ struct CoulombIntegralsProvider {
       LOGGER(1) << "shells: {" << s.str() << "}" << std::endl;
     }
 
-    // to store information about the shells
-    std::vector<ShellInfo> _shells;
-
-    // fill in the shells information
-    std::transform(mpiShells.begin(),
-                   mpiShells.end(),
-                   std::back_inserter(_shells),
-                   [&](const size_t &i) { return ShellInfo(shells, i); });
-
-    // get the ctf indices
-    for (auto &s : _shells) {
-      const size_t bx(toCtfIdx(s.begin)), ex(toCtfIdx(s.end));
-      // LOGGER(1) << "sb: "<< s.begin << " se: "<< s.end << std::endl;
-      // LOGGER(1) << "bx: "<< bx << " ex: "<< ex << std::endl;
-      std::vector<int64_t> idxctf(ex - bx);
-      std::iota(idxctf.begin(), idxctf.end(), toCtfIdx(s.begin));
-      ctfIndices.push_back(idxctf);
+    LOGGER(1) << "#shells        :" << mpiShells.size() << std::endl;
+  }
+
+  // estimated cost of a shell within a shell quartet:
+  // number of primitive functions, i.e. primitives times the
+  // number of angular momentum components
+  double getShellCost(const size_t i) const {
+    return static_cast<double>(shells[i].nprim()) * shells[i].size();
+  }
+
+  // estimated cost of computing all quartets (KL|MN) of the leading shell K
+  std::vector<double> getLeadingShellCosts(const bool halfContract,
+                                           const size_t No) const {
+    const size_t nShells(shells.size());
+    std::vector<double> c(nShells), costs(nShells);
+    for (size_t i(0); i < nShells; i++) c[i] = getShellCost(i);
+    // prefix[i] = sum_{j<i} c[j], pairs[i] = sum_{M<i} c[M] prefix[M+1]
+    std::vector<double> prefix(nShells + 1, 0.0), pairs(nShells + 1, 0.0);
+    for (size_t i(0); i < nShells; i++) {
+      prefix[i + 1] = prefix[i] + c[i];
+      pairs[i + 1] = pairs[i] + c[i] * prefix[i + 1];
     }
+    for (size_t K(0); K < nShells; K++) {
+      if (halfContract) {
+        // all L, all pairs N <= M and the first quarter transformation
+        costs[K] = c[K] * prefix[nShells] * pairs[nShells]
+                 + static_cast<double>(shells[K].size()) * Np * Np * Np * No;
+      } else {
+        // unique quartets L <= K, N <= M < K or M == K, N <= L
+        for (size_t L(0); L <= K; L++) {
+          costs[K] += c[K] * c[L] * (pairs[K] + c[K] * prefix[L + 1]);
+        }
+      }
+    }
+    return costs;
+  }
 
-    LOGGER(1) << "#shells        :" << mpiShells.size() << std::endl;
-    LOGGER(1) << "#indices       :" << ctfIndices.size() << std::endl;
+  // longest processing time first: assign the most expensive leading
+  // shells first, always to the rank with the lowest load so far
+  void doCostDistribution(const bool halfContract, const size_t No) {
+    const size_t np(Sisi4s::world->np), rank(Sisi4s::world->rank);
+    const std::vector<double> costs(getLeadingShellCosts(halfContract, No));
+    std::vector<size_t> order(shells.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return costs[a] > costs[b];
+    });
+    std::vector<double> loads(np, 0.0);
+    for (const size_t K : order) {
+      const size_t r(std::min_element(loads.begin(), loads.end())
+                     - loads.begin());
+      loads[r] += costs[K];
+      if (r == rank) mpiShells.push_back(K);
+    }
+    // the shells of a rank have to be ascending for readHalfContract
+    std::sort(mpiShells.begin(), mpiShells.end());
+
+    const double maxLoad(*std::max_element(loads.begin(), loads.end())),
+        meanLoad(std::accumulate(loads.begin(), loads.end(), 0.0) / np);
+    LOGGER(1) << "estimated load of rank: " << loads[rank] << std::endl;
+    LOGGER(1) << "estimated imbalance   : " << maxLoad / meanLoad << std::endl;
   }
 
   void doRoundRobinDistribution() {
@@ -132,8 +176,41 @@ struct CoulombIntegralsProvider {
 #endif
   }
 
+  // scatter the integrals vklmn of the shell quartet (KL|MN) to
+  // all of its distinct permutationally equivalent positions
+  void scatter(const double *vklmn,
+               const size_t _K,
+               const size_t _L,
+               const size_t _M,
+               const size_t _N,
+               std::vector<double> &values,
+               std::vector<int64_t> &indices) {
+    const ShellInfo K(shells, _K), L(shells, _L), M(shells, _M),
+        N(shells, _N);
+    for (const auto &p : getDistinctQuartetPermutations(_K, _L, _M, _N)) {
+      std::array<size_t, 4> a;
+      for (size_t k(K.begin), Inmlk = 0; k < K.end; ++k) {
+        a[0] = k;
+        for (size_t l(L.begin); l < L.end; ++l) {
+          a[1] = l;
+          for (size_t m(M.begin); m < M.end; ++m) {
+            a[2] = m;
+            for (size_t n(N.begin); n < N.end; ++n, ++Inmlk) {
+              a[3] = n;
+              indices.push_back(a[p[3]] + a[p[2]] * Np + a[p[1]] * Np * Np
+                                + a[p[0]] * Np * Np * Np);
+              values.push_back(vklmn[Inmlk]);
+            } // n
+          }   // m
+        }     // l
+      }       // k
+    }
+  }
+
   void compute() {
     libint2::initialize();
+    distribute(false);
+    Timer timer(&computeTime);
 
     const size_t NpNpNpNp(Np * Np * Np * Np);
     LOGGER(1) << "Np**4   :  " << NpNpNpNp << std::endl;
@@ -141,57 +218,84 @@ struct CoulombIntegralsProvider {
               << sizeof(double) * NpNpNpNp / 1024 / 1024 / 1024 << " GB)"
               << std::endl;
 
-    libint2::Engine engine(op, shells.max_nprim(), shells.max_l(), 0);
+    const SchwarzScreening screening(shells, op, screeningThreshold);
 
-    // store shell by shell calculation in this buffer
-    const auto &vsrqp = engine.results();
+    // every thread drives its own engine and collects the integrals
+    // of its quartets in its own buffers
+    std::vector<libint2::Engine> engines(
+        threads,
+        libint2::Engine(op, shells.max_nprim(), shells.max_l(), 0));
+    std::vector<std::vector<double>> threadValues(threads);
+    std::vector<std::vector<int64_t>> threadIndices(threads);
 
     // the outside loops will loop over the shells.
-    // This will create a block of Vpqrs, where pqrs are contracted
-    // gaussian indices belonging to their respective shells.
-    int mpiShellIdx(-1);
+    // Only the unique quartets with K >= L, K >= M >= N and (MN) <= (KL)
+    // are computed, every block is then scattered to all of
+    // its permutationally equivalent blocks of Vpqrs.
     for (const size_t _K : mpiShells) {
-      ++mpiShellIdx;
-      LOGGER(1) << "shell: " << mpiShells[mpiShellIdx]
-                << "    #: " << ctfIndices[mpiShellIdx].size() << std::endl;
-      Vklmn.push_back(std::vector<double>(ctfIndices[mpiShellIdx].size(), 0));
-      for (size_t _L(0); _L < shells.size(); ++_L) {     // lambda
-        for (size_t _M(0); _M < shells.size(); ++_M) {   // mu
-          for (size_t _N(0); _N < shells.size(); ++_N) { // nu
-            const ShellInfo K(shells, _K), L(shells, _L), M(shells, _M),
-                N(shells, _N);
+      int64_t computed(0), screened(0);
+#pragma omp parallel for schedule(dynamic) collapse(2) num_threads(threads)   \
+    reduction(+ : computed, screened)
+      for (size_t _L = 0; _L <= _K; ++_L) {   // lambda
+        for (size_t _M = 0; _M <= _K; ++_M) { // mu
+          const int t(getThreadNumber());
+          // store shell by shell calculation in this buffer
+          const auto &vsrqp = engines[t].results();
+          const size_t maxN(_M == _K ? _L : _M);
+          for (size_t _N(0); _N <= maxN; ++_N) { // nu
+
+            if (!screening.isSignificant(_K, _L, _M, _N)) {
+              ++screened;
+              continue;
+            }
 
             // compute integrals (K L , M N)
-            engine.compute(shells[_K], shells[_L], shells[_M], shells[_N]);
+            engines[t].compute(shells[_K], shells[_L], shells[_M], shells[_N]);
+            ++computed;
 
             if (vsrqp[0] == nullptr) continue;
 
-            for (size_t k(K.begin), Inmlk = 0; k < K.end; ++k) {
-              for (size_t l(L.begin); l < L.end; ++l) {
-                for (size_t m(M.begin); m < M.end; ++m) {
-                  for (size_t n(N.begin); n < N.end; ++n, ++Inmlk) {
-
-                    const size_t bigI(n + m * Np + l * Np * Np
-                                      + k * Np * Np * Np),
-                        idx(bigI - ctfIndices[mpiShellIdx].front());
-
-                    Vklmn.back()[idx] += vsrqp[0][Inmlk];
-
-                  } // n
-                }   // m
-              }     // l
-            }       // k
+            scatter(vsrqp[0],
+                    _K,
+                    _L,
+                    _M,
+                    _N,
+                    threadValues[t],
+                    threadIndices[t]);
 
           } // N
         }   // M
       }     // L
-    }       // K
+      computedQuartets += computed;
+      screenedQuartets += screened;
+
+      // gather the buffers of all threads for the shell K
+      size_t elements(0);
+      for (const auto &v : threadValues) elements += v.size();
+      Vklmn.push_back(std::vector<double>());
+      ctfIndices.push_back(std::vector<int64_t>());
+      Vklmn.back().reserve(elements);
+      ctfIndices.back().reserve(elements);
+      for (int t(0); t < threads; t++) {
+        Vklmn.back().insert(Vklmn.back().end(),
+                            threadValues[t].begin(),
+                            threadValues[t].end());
+        ctfIndices.back().insert(ctfIndices.back().end(),
+                                 threadIndices[t].begin(),
+                                 threadIndices[t].end());
+        std::vector<double>().swap(threadValues[t]);
+        std::vector<int64_t>().swap(threadIndices[t]);
+      }
+      LOGGER(1) << "shell: " << _K << "    #: " << elements << std::endl;
+    } // K
 
     libint2::finalize();
   }
 
   void computeHalfContract(size_t No, Tensor<double> *coeff) {
     libint2::initialize();
+    distribute(true, No);
+    Timer timer(&computeTime);
 
     size_t orbs(coeff->lens[1]);
     LOGGER(1) << "dimensions: " << coeff->lens[0] << " " << coeff->lens[1]
@@ -208,40 +312,52 @@ struct CoulombIntegralsProvider {
     LOGGER(1) << "Largest buffer size for indiviual mpi rank: "
               << (double)sizeof(double) * maxShellElements / 1024 / 1024 / 1024
               << " GB\n";
-    libint2::Engine engine(op, shells.max_nprim(), shells.max_l(), 0);
+    const SchwarzScreening screening(shells, op, screeningThreshold);
+    std::vector<libint2::Engine> engines(
+        threads,
+        libint2::Engine(op, shells.max_nprim(), shells.max_l(), 0));
 
-    // store shell by shell calculation in this buffer
-    const auto &vsrqp = engine.results();
     // store the values Vklmn values in pppp
-    // half-transform pppp -> pppo -> ppoo
+    // half-transform pppp -> pppo -> Vklmn
     std::vector<double> pppp(maxShellElements);
     std::vector<double> pppo(maxShellNbf * Np * Np * No);
-    std::vector<double> ppoo(maxShellNbf * Np * No * No);
-    offset.resize(ctfIndices.size(), -1);
+    offset.resize(mpiShells.size(), -1);
     // the outside loops will loop over the shells.
     // This will create a block of Vpqrs, where pqrs are contracted
     // gaussian indices belonging to their respective shells.
     int mpiShellIdx(-1);
     for (const size_t _K : mpiShells) {
       ++mpiShellIdx;
-      LOGGER(1) << "shell: " << mpiShells[mpiShellIdx]
-                << "    #: " << ctfIndices[mpiShellIdx].size() << std::endl;
       const ShellInfo K(shells, _K);
+      LOGGER(1) << "shell: " << _K << "    #: " << K.size * Np * Np * Np
+                << std::endl;
       offset[mpiShellIdx] = K.begin * Np * No * No;
       //      std::cout << "offset " << K.begin*Np*No*No << std::endl;
       Vklmn.push_back(std::vector<double>(K.size * Np * No * No, 0.));
       std::fill(pppp.begin(), pppp.end(), 0.);
-      std::fill(pppo.begin(), pppo.end(), 0.);
-      std::fill(ppoo.begin(), ppoo.end(), 0.);
-      //      Vklmn.push_back(std::vector<double>(ctfIndices[mpiShellIdx].size(),
-      //      0));
-      for (size_t _L(0); _L < shells.size(); ++_L) {     // lambda
-        for (size_t _M(0); _M < shells.size(); ++_M) {   // mu
-          for (size_t _N(0); _N < shells.size(); ++_N) { // nu
+      // the whole block of K is needed on this rank, hence only the
+      // symmetry (KL|MN) = (KL|NM) is used.
+      // Every element of pppp is written by exactly one (L,M) pair,
+      // so the threads can write into pppp concurrently.
+      int64_t computed(0), screened(0);
+#pragma omp parallel for schedule(dynamic) collapse(2) num_threads(threads)   \
+    reduction(+ : computed, screened)
+      for (size_t _L = 0; _L < shells.size(); ++_L) {   // lambda
+        for (size_t _M = 0; _M < shells.size(); ++_M) { // mu
+          // store shell by shell calculation in this buffer
+          auto &engine(engines[getThreadNumber()]);
+          const auto &vsrqp = engine.results();
+          for (size_t _N(0); _N <= _M; ++_N) { // nu
             const ShellInfo L(shells, _L), M(shells, _M), N(shells, _N);
 
+            if (!screening.isSignificant(_K, _L, _M, _N)) {
+              ++screened;
+              continue;
+            }
+
             // compute integrals (K L , M N)
             engine.compute(shells[_K], shells[_L], shells[_M], shells[_N]);
+            ++computed;
 
             if (vsrqp[0] == nullptr) continue;
 
@@ -250,11 +366,11 @@ struct CoulombIntegralsProvider {
                 for (size_t m(M.begin); m < M.end; ++m) {
                   for (size_t n(N.begin); n < N.end; ++n, ++Inmlk) {
 
-                    const size_t bigI(n + m * Np + l * Np * Np
-                                      + k * Np * Np * Np),
-                        idx(bigI - ctfIndices[mpiShellIdx].front());
+                    const size_t kl((k - K.begin) * Np * Np * Np
+                                    + l * Np * Np);
 
-                    pppp[idx] += vsrqp[0][Inmlk];
+                    pppp[kl + m * Np + n] += vsrqp[0][Inmlk];
+                    if (_M != _N) pppp[kl + n * Np + m] += vsrqp[0][Inmlk];
 
                   } // n
                 }   // m
@@ -264,52 +380,40 @@ struct CoulombIntegralsProvider {
           } // N
         }   // M
       }     // L
+      computedQuartets += computed;
+      screenedQuartets += screened;
       // Now we finished writing Vklmn, i.e. the AO Coulomb Matrix for the shell
       // K We can now contract Vklmn.back() with the Orbital coefficient C_li
       // C_nj
 
-      // contract:    V(klmi) = V(klmn) * C(ni);
-      for (size_t k(0); k < K.size; k++)
-        for (size_t l(0); l < Np; l++)
-          for (size_t m(0); m < Np; m++) {
-            size_t offi(k * Np * Np * Np + l * Np * Np + m * Np);
-            size_t offo(k * Np * Np * No + l * Np * No + m * No);
-            for (size_t n(0); n < Np; n++) {
-              for (size_t i(0); i < No; i++) {
-                pppo[offo + i] += pppp[offi + n] * C[i * Np + n];
-              } // i
-            }   // n
-          }     // m
-
-      // rearrange pppo: V(klmi) -> V(kmil)
+      // contract: V(iklm) = V(klmn) * C(ni)
+      // the transformed index i becomes the slowest one
+      const size_t X(K.size * Np * Np);
+      transformFastestIndex(pppp.data(),
+                            X,
+                            Np,
+                            C.data(),
+                            Np,
+                            0,
+                            No,
+                            pppo.data());
+
+      // contract: V(kmij) = V(iklm) * C(lj)
       // this means: 1.) particle index l getting the fastest index
       //             2.) chemists integral changes to physics notation
-      // we use pppp as a scratch array
-      for (size_t s(0); s < K.size * Np * No * Np; s++) pppp[s] = pppo[s];
-      std::fill(pppo.begin(), pppo.end(), 0.);
-
-      for (size_t k(0); k < K.size; k++)
-        for (size_t m(0); m < Np; m++)
-          for (size_t i(0); i < No; i++)
-            for (size_t l(0); l < Np; l++)
-              pppo[k * Np * No * Np + m * Np * No + i * Np + l] =
-                  pppp[k * Np * No * Np + l * Np * No + m * No + i];
-
-      // contract: V(kmij) = V(kmil) * C(lj)
-      for (size_t k(0); k < K.size; k++)
-        for (size_t m(0); m < Np; m++)
-          for (size_t i(0); i < No; i++) {
-            size_t offi(k * Np * Np * No + m * Np * No + i * Np);
-            size_t offo(k * Np * No * No + m * No * No + i * No);
-            for (size_t l(0); l < Np; l++) {
-              for (size_t j(0); j < No; j++) {
-                ppoo[offo + j] += pppo[offi + l] * C[j * Np + l];
-              } // j
-            }   // l
-          }     // i
-
-      for (size_t s(0); s < K.size * Np * No * No; s++)
-        Vklmn.back()[s] = ppoo[s];
+      for (size_t i(0); i < No; i++) {
+        for (size_t k(0); k < K.size; k++) {
+          transformSlowerIndex(pppo.data() + i * X + k * Np * Np,
+                               Np,
+                               Np,
+                               C.data(),
+                               Np,
+                               0,
+                               No,
+                               Vklmn.back().data() + k * Np * No * No + i * No,
+                               No * No);
+        }
+      }
 
     } // K
 
@@ -317,80 +421,84 @@ struct CoulombIntegralsProvider {
   }
 
   struct IndexRange {
-    size_t begin, end, size;
-    IndexRange()
-        : begin(0)
-        , end(0)
-        , size(0){};
+    size_t shell, begin, size;
+    IndexRange(size_t shell_, size_t begin_, size_t size_)
+        : shell(shell_)
+        , begin(begin_)
+        , size(size_){};
   };
-  std::vector<IndexRange> getWriteRangesForShell(size_t i) {
-
-    std::vector<IndexRange> r(writesPerShell);
-
-    if (i >= ctfIndices.size()) return r;
-    const auto &indices(ctfIndices[i]);
-
-    const size_t chunks = indices.size() / maxElementsWrite,
-                 rest = indices.size() % maxElementsWrite;
-
-    size_t j(0);
-    for (j = 0; j < chunks; j++) {
-      r[j].begin = maxElementsWrite * j;
-      r[j].end = maxElementsWrite * (j + 1) - 1;
-      r[j].size = r[j].end - r[j].begin + 1;
-    }
-
-    if (rest != 0) {
-      r[j].begin = maxElementsWrite * j;
-      r[j].end = r[j].begin + rest - 1;
-      r[j].size = r[j].end - r[j].begin + 1;
+  // split the computed values of all shells in ranges of at most
+  // maxElementsWrite elements
+  std::vector<IndexRange> getWriteRanges() {
+    std::vector<IndexRange> r;
+    for (size_t i(0); i < ctfIndices.size(); i++) {
+      for (size_t begin(0); begin < ctfIndices[i].size();
+           begin += maxElementsWrite) {
+        r.push_back(IndexRange(
+            i,
+            begin,
+            std::min(maxElementsWrite, ctfIndices[i].size() - begin)));
+      }
     }
-
-    return std::move(r);
+    return r;
   }
 
   void write(Tensor<double> *t) {
 
-    // loop over engine.maxSize to ensure the same number of mpi calls
-    // on every rank
-    for (size_t i(0); i < maxSize; i++) {
-      int64_t *indices;
-      size_t N;
-      double *data;
-      if (i < ctfIndices.size()) {
-        N = ctfIndices[i].size();
-        indices = ctfIndices[i].data();
-        data = Vklmn[i].data();
-      } else {
-        N = 0;
-        indices = nullptr;
-        data = nullptr;
-      }
-#ifdef DEBUG
-      std::cout << Sisi4s::world->rank << "::"
-                << "writing " << N << " values "
-                << "into ctf tensor" << std::endl;
-#endif
-      LOGGER(1) << "writing " << N << " values "
-                << "into ctf tensor" << std::endl;
-
-      // ip is an index pair
-      for (const auto &ip : getWriteRangesForShell(i)) {
+    const auto ranges(getWriteRanges());
+
+    // every rank has to take part in the same number of writes
+    int64_t localWrites(ranges.size()), writes;
+    MPI_Allreduce(&localWrites,
+                  &writes,
+                  1,
+                  MPI_INT64_T,
+                  MPI_MAX,
+                  Sisi4s::world->comm);
+    LOGGER(1) << "writes into ctf tensor: " << writes << std::endl;
+
+    for (int64_t i(0); i < writes; i++) {
+      if (i < localWrites) {
+        const auto &ip(ranges[i]);
 #ifdef DEBUG
         std::cout << Sisi4s::world->rank << "::"
-                  << "\t|"
                   << "writing " << ip.size << " values "
                   << "into ctf tensor" << std::endl;
 #endif
         LOGGER(1) << "writing " << ip.size << " values "
                   << "into ctf tensor" << std::endl;
         t->write(ip.size,
-                 N ? indices + ip.begin : nullptr,
-                 N ? data + ip.begin : nullptr);
+                 ctfIndices[ip.shell].data() + ip.begin,
+                 Vklmn[ip.shell].data() + ip.begin);
+      } else {
+        t->write(0, nullptr, nullptr);
       }
     }
   }
 
+  // wall times of the computation on each rank, only valid on rank 0
+  std::vector<double> getRankTimes() const {
+    double local(computeTime.getFractionalSeconds());
+    std::vector<double> times(Sisi4s::world->np);
+    MPI_Gather(&local,
+               1,
+               MPI_DOUBLE,
+               times.data(),
+               1,
+               MPI_DOUBLE,
+               0,
+               Sisi4s::world->comm);
+    return times;
+  }
+
+  // number of computed and screened shell quartets on all ranks
+  void getQuartetCounts(int64_t &computed, int64_t &screened) const {
+    int64_t local[] = {computedQuartets, screenedQuartets}, global[2];
+    MPI_Allreduce(local, global, 2, MPI_INT64_T, MPI_SUM, Sisi4s::world->comm);
+    computed = global[0];
+    screened = global[1];
+  }
+
   void readHalfContract(Tensor<double> *t) {
     // loop over engine.maxSize to ensure the same number of mpi calls
     // on every rank
@@ -426,12 +534,10 @@ struct CoulombIntegralsProvider {
   }
 
 private:
-  // mpi max size of Vklmn and ctfIndices
-  // to be able to write Kosher with regard to mpi
-  size_t maxSize;
   const size_t Np;
   const libint2::BasisSet &shells;
   const Operator op;
+  const Distribution distribution;
   std::vector<size_t> mpiShells;
   std::vector<size_t> offset;
   std::vector<std::vector<double>> Vklmn;
@@ -441,7 +547,12 @@ private:
   // maximum number of primitives in the basis set
   const size_t maxShellNbf;
   const size_t maxShellElements;
-  const size_t writesPerShell;
+  // quartets (KL|MN) with a Schwarz bound below are not computed
+  const double screeningThreshold;
+  // number of OpenMP threads computing the quartets of a rank
+  const int threads;
+  int64_t computedQuartets, screenedQuartets;
+  Time computeTime;
 };
 
 void CoulombIntegralsFromGaussian::run() {
@@ -453,6 +564,8 @@ void CoulombIntegralsFromGaussian::run() {
                        "chemistNotation",
                        "maxElementsWrite",
                        "shellDistribution",
+                       "screeningThreshold",
+                       "threads",
                        "CoulombIntegrals",
                        "HHHHCoulombIntegrals",
                        "PPHHCoulombIntegrals",
@@ -465,11 +578,15 @@ void CoulombIntegralsFromGaussian::run() {
       xyz_structure_string(getTextArgument("xyzStructureString", "")),
       kernel(getTextArgument("kernel", "coulomb"));
   const bool chemistNotation(getIntegerArgument("chemistNotation", 1) == 1);
+  const double screeningThreshold(getRealArgument("screeningThreshold", 1e-14));
+  const int threads(getIntegerArgument("threads", getMaxThreads()));
+  if (threads < 1) throw new EXCEPTION("threads must be at least 1");
   const CoulombIntegralsProvider::Distribution mpiDistribution = [&] {
-    auto mode(this->getTextArgument("shellDistribution", "simple"));
+    auto mode(this->getTextArgument("shellDistribution", "cost"));
     CoulombIntegralsProvider::Distribution r;
     if (mode == "simple") r = CoulombIntegralsProvider::SIMPLE;
     else if (mode == "roundRobin") r = CoulombIntegralsProvider::ROUND_ROBIN;
+    else if (mode == "cost") r = CoulombIntegralsProvider::COST;
     else throw "Incorrect mode given: " + mode;
     LOGGER(1) << "mpi mode: " << mode << " (" << r << ")" << std::endl;
     return r;
@@ -512,13 +629,16 @@ void CoulombIntegralsFromGaussian::run() {
          << YAML::Value << xyzStructureFile << YAML::Key << "basis-set"
          << YAML::Value << basisSet << YAML::Key << "kernel" << YAML::Value
          << kernel << YAML::Key << "chemist-notation" << YAML::Value
-         << chemistNotation;
+         << chemistNotation << YAML::Key << "threads" << YAML::Value
+         << threads;
 
   CoulombIntegralsProvider engine(
       shells,
       op,
       mpiDistribution,
-      getIntegerArgument("maxElementsWrite", 67108864));
+      getIntegerArgument("maxElementsWrite", 67108864),
+      screeningThreshold,
+      threads);
 
   if (isArgumentGiven("CoulombIntegrals")) {
 
@@ -674,4 +794,26 @@ void CoulombIntegralsFromGaussian::run() {
     throw "Output either CoulombIntegrals or \
            PPHH && HHHH && OrbitalCoefficients && HoleEigenEnergies";
   }
+
+  int64_t computedQuartets, screenedQuartets;
+  engine.getQuartetCounts(computedQuartets, screenedQuartets);
+  LOGGER(1) << "computed quartets: " << computedQuartets << std::endl;
+  LOGGER(1) << "screened quartets: " << screenedQuartets << std::endl;
+  EMIT() << YAML::Key << "quartets" << YAML::Value << YAML::BeginMap
+         << YAML::Key << "screening-threshold" << YAML::Value
+         << screeningThreshold << YAML::Key
+         << "computed" << YAML::Value << computedQuartets << YAML::Key
+         << "screened" << YAML::Value << screenedQuartets << YAML::EndMap;
+
+  // make the load imbalance between the ranks visible
+  const std::vector<double> rankTimes(engine.getRankTimes());
+  if (Sisi4s::world->rank == 0) {
+    const double maxTime(*std::max_element(rankTimes.begin(), rankTimes.end())),
+        meanTime(std::accumulate(rankTimes.begin(), rankTimes.end(), 0.0)
+                 / rankTimes.size());
+    LOGGER(1) << "max rank time : " << maxTime << " s" << std::endl;
+    LOGGER(1) << "mean rank time: " << meanTime << " s" << std::endl;
+  }
+  EMIT() << YAML::Key << "rank-times" << YAML::Value << YAML::Flow
+         << rankTimes;
 }
@@ -13,6 +13,7 @@
 #include <map>
 #include <util/Emitter.hpp>
 #include <math/MathFunctions.hpp>
+#include <math/QuarterTransformation.hpp>
 
 using namespace sisi4s;
 ALGORITHM_REGISTRAR_DEFINITION(CoulombIntegralsFromRotatedCoulombIntegrals);
@@ -91,103 +92,22 @@ struct VectorIntegralProvider : public IntegralProvider<std::vector<double>> {
     const Limit pLim(indexToLimits(P)), qLim(indexToLimits(Q)),
         rLim(indexToLimits(R)), sLim(indexToLimits(S));
 
-    const size_t dimension(pLim.size * qLim.size * rLim.size * sLim.size);
-    std::vector<double> result(dimension, 0.0);
-
-    std::vector<double> Vpmlk(Np * Np * Np * pLim.size, 0.0),
-        Vprlk(Np * Np * pLim.size * rLim.size, 0.0),
-        Vprqk(Np * pLim.size * rLim.size * qLim.size, 0.0);
-
-    // COMPUTE Vpmlk =====================
-    for (size_t p(pLim.lower); p < pLim.upper; ++p) {
-      for (size_t k(0), Inmlk = 0; k < Np; ++k) {
-        for (size_t l(0); l < Np; ++l) {
-          for (size_t m(0); m < Np; ++m) {
-
-            const size_t Ipmlk = pLim[p] + m * pLim.size + l * pLim.size * Np
-                               + k * pLim.size * Np * Np;
-
-            for (size_t n(0); n < Np; ++n, ++Inmlk) {
-
-              Vpmlk[Ipmlk] += C[n + p * Np] * Vklmn[Inmlk];
-
-            } /* n */
-          }   /* m */
-        }     /* l */
-      }       /* k */
-    }
-
-    // COMPUTE Vprlk ======================
-    for (size_t r(rLim.lower); r < rLim.upper; ++r) {
-      for (size_t p(pLim.lower); p < pLim.upper; ++p) {
-        for (size_t k(0); k < Np; ++k) {
-          for (size_t l(0); l < Np; ++l) {
-
-            const size_t Iprlk = pLim[p] + rLim[r] * pLim.size
-                               + l * pLim.size * rLim.size
-                               + k * pLim.size * rLim.size * Np;
-
-            for (size_t m(0); m < Np; ++m) {
-
-              const size_t Ipmlk = pLim[p] + m * pLim.size + l * pLim.size * Np
-                                 + k * pLim.size * Np * Np;
-
-              Vprlk[Iprlk] += C[m + r * Np] * Vpmlk[Ipmlk];
-
-            } /* m */
-          }   /* l */
-        }     /* k */
-      }
-    }
-
-    for (size_t r(rLim.lower); r < rLim.upper; ++r) {
-      for (size_t q(qLim.lower); q < qLim.upper; ++q) {
-        for (size_t p(pLim.lower); p < pLim.upper; ++p) {
-          // COMPUTE Vprqk =====================
-          for (size_t k(0); k < Np; ++k) {
-
-            const size_t Iprqk = pLim[p] + rLim[r] * pLim.size
-                               + qLim[q] * pLim.size * rLim.size
-                               + k * pLim.size * rLim.size * qLim.size;
-
-            for (size_t l(0); l < Np; ++l) {
-
-              const size_t Iprlk = pLim[p] + rLim[r] * pLim.size
-                                 + l * pLim.size * rLim.size
-                                 + k * pLim.size * rLim.size * Np;
-
-              Vprqk[Iprqk] += C[l + q * Np] * Vprlk[Iprlk];
-            }
-          }
-        }
-      }
-    }
-
-    // COMPUTE Vpqrs =====================
-    for (size_t s(sLim.lower); s < sLim.upper; ++s) {
-      for (size_t r(rLim.lower); r < rLim.upper; ++r) {
-        for (size_t q(qLim.lower); q < qLim.upper; ++q) {
-          for (size_t p(pLim.lower); p < pLim.upper; ++p) {
-
-            const size_t IPQRS = pLim[p] + qLim[q] * pLim.size
-                               + rLim[r] * pLim.size * qLim.size
-                               + sLim[s] * pLim.size * qLim.size * rLim.size;
-
-            for (size_t k(0); k < Np; ++k) {
-
-              const size_t Iprqk = pLim[p] + rLim[r] * pLim.size
-                                 + qLim[q] * pLim.size * rLim.size
-                                 + k * pLim.size * rLim.size * qLim.size;
-
-              result[IPQRS] += C[k + s * Np] * Vprqk[Iprqk];
-
-            } // k
-          }
-        }
-      }
-    }
+    // only rank 0 holds the integrals and writes the result
+    if (C.empty()) return std::vector<double>();
 
-    return result;
+    // < P Q | R S > = (P R | Q S)
+    return transformChemistToPhysics(Vklmn.data(),
+                                     Np,
+                                     C.data(),
+                                     Np,
+                                     pLim.lower,
+                                     pLim.size,
+                                     qLim.lower,
+                                     qLim.size,
+                                     rLim.lower,
+                                     rLim.size,
+                                     sLim.lower,
+                                     sLim.size);
   }
   std::vector<double> C;
   std::vector<double> Vklmn;
@@ -238,6 +158,127 @@ struct SlowVectorIntegralProvider : public VectorIntegralProvider {
   }
 };
 
+// Every rank transforms a block of the slowest index k of the chemist
+// integrals V(n,m,l,k) = (nm|lk) locally, such that the memory per rank
+// scales as Np**4 / #ranks. The three quarter transformed integrals
+// T(k,p,r,q) are stored in a distributed tensor and the last quarter
+// transformation over k is done by ctf for each requested block.
+struct DistributedVectorIntegralProvider
+    : public IntegralProvider<Tensor<double>> {
+
+  DistributedVectorIntegralProvider(size_t no,
+                                    size_t nv,
+                                    bool chemistNotation_,
+                                    bool unrestricted_,
+                                    Tensor<double> &coeffs,
+                                    Tensor<double> &coulombIntegrals)
+      : IntegralProvider(no, nv, chemistNotation_, unrestricted_)
+      , C(coeffs) {
+    if (!chemistNotation_)
+      throw EXCEPTION("Physics notation not supported for this provider");
+
+    if (unrestricted_)
+      throw EXCEPTION("Unrestricted not supported for this provider");
+
+    const size_t np(Sisi4s::world->np), rank(Sisi4s::world->rank),
+        NpNpNp(Np * Np * Np), blockSize((Np + np - 1) / np),
+        begin(std::min(Np, rank * blockSize)),
+        end(std::min(Np, begin + blockSize)), B(end - begin);
+    LOGGER(1) << "k block per rank: " << blockSize << std::endl;
+    LOGGER(1) << "memory per rank: "
+              << 2.0 * sizeof(double) * B * NpNpNp / 1024 / 1024 / 1024
+              << " GB" << std::endl;
+
+    // every rank needs all orbital coefficients
+    std::vector<double> c(Np * Np);
+    coeffs.read_all(c.data());
+
+    // read in the integrals of the k block, one k at a time,
+    // every rank has to take part in the same number of reads
+    std::vector<double> v(B * NpNpNp), w(B * NpNpNp);
+    {
+      std::vector<int64_t> indices(NpNpNp);
+      for (size_t k(0); k < blockSize; k++) {
+        const bool isLocal(begin + k < end);
+        if (isLocal) {
+          std::iota(indices.begin(), indices.end(), (begin + k) * NpNpNp);
+        }
+        coulombIntegrals.read(isLocal ? NpNpNp : 0,
+                              indices.data(),
+                              isLocal ? v.data() + k * NpNpNp : nullptr);
+      }
+    }
+
+    // (n m l k) -> (m l k p) -> (l k p r) -> (k p r q)
+    transformFastestIndex(v.data(),
+                          Np * Np * B,
+                          Np,
+                          c.data(),
+                          Np,
+                          0,
+                          Np,
+                          w.data());
+    transformFastestIndex(w.data(),
+                          Np * B * Np,
+                          Np,
+                          c.data(),
+                          Np,
+                          0,
+                          Np,
+                          v.data());
+    transformFastestIndex(v.data(),
+                          B * Np * Np,
+                          Np,
+                          c.data(),
+                          Np,
+                          0,
+                          Np,
+                          w.data());
+
+    std::vector<int> lens(4, Np), syms(4, NS);
+    T = new Tensor<double>(4, lens.data(), syms.data(), *Sisi4s::world, "T");
+    {
+      // the local element x = k + B * (p + Np * (r + Np * q))
+      // is T(begin + k, p, r, q)
+      std::vector<int64_t> indices(NpNpNp);
+      for (size_t chunk(0); chunk < blockSize; chunk++) {
+        const bool isLocal(chunk < B);
+        if (isLocal) {
+          for (size_t i(0), x(chunk * NpNpNp); i < NpNpNp; i++, x++) {
+            indices[i] = begin + x % B + x / B * Np;
+          }
+        }
+        T->write(isLocal ? NpNpNp : 0,
+                 indices.data(),
+                 isLocal ? w.data() + chunk * NpNpNp : nullptr);
+      }
+    }
+  }
+  ~DistributedVectorIntegralProvider() { delete T; }
+
+  Tensor<double> compute(Index P, Index Q, Index R, Index S) {
+    const Limit p(indexToLimits(P)), q(indexToLimits(Q)), r(indexToLimits(R)),
+        s(indexToLimits(S));
+
+    int ta[] = {0, (int)p.lower, (int)r.lower, (int)q.lower},
+        te[] = {(int)Np, (int)p.upper, (int)r.upper, (int)q.upper},
+        ca[] = {0, (int)s.lower}, ce[] = {(int)Np, (int)s.upper};
+    auto Tkprq(T->slice(ta, te));
+    auto Cks(C.slice(ca, ce));
+
+    int lens[] = {(int)p.size, (int)q.size, (int)r.size, (int)s.size},
+        syms[] = {NS, NS, NS, NS};
+    Tensor<double> result(4, lens, syms, *Sisi4s::world, "V");
+    // < P Q | R S > = (P R | Q S)
+    result["pqrs"] = Tkprq["kprq"] * Cks["ks"];
+    return result;
+  }
+
+private:
+  Tensor<double> &C;
+  Tensor<double> *T = nullptr;
+};
+
 struct CtfIntegralProvider : public IntegralProvider<Tensor<double>> {
   CtfIntegralProvider(size_t no,
                       size_t nv,
@@ -470,11 +511,12 @@ void CoulombIntegralsFromRotatedCoulombIntegrals::run() {
   LOGGER(1) << "Nv: " << Nv << std::endl;
 
   struct EngineInfo {
-    enum Name { CTF, VECTOR_SLOW, VECTOR_FAST };
+    enum Name { CTF, VECTOR_SLOW, VECTOR_FAST, VECTOR_DISTRIBUTED };
     static Name fromString(const std::string name) {
       if (name == "ctf") return CTF;
       if (name == "VectorSlow") return VECTOR_SLOW;
       if (name == "VectorFast") return VECTOR_FAST;
+      if (name == "VectorDistributed") return VECTOR_DISTRIBUTED;
       throw new EXCEPTION("Engine name not recognised");
     }
   };
@@ -494,6 +536,14 @@ void CoulombIntegralsFromRotatedCoulombIntegrals::run() {
                                   *C,
                                   *V);
     computeAndExport(*this, engine, integralInfos);
+  } else if (engineType == EngineInfo::VECTOR_DISTRIBUTED) {
+    DistributedVectorIntegralProvider engine(No,
+                                             Nv,
+                                             chemistNotation,
+                                             unrestricted,
+                                             *C,
+                                             *V);
+    computeAndExport(*this, engine, integralInfos);
   } else if (engineType == EngineInfo::VECTOR_SLOW) {
     SlowVectorIntegralProvider engine(No,
                                       Nv,
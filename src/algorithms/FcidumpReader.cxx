@@ -4,10 +4,14 @@
 #include <Sisi4s.hpp>
 #include <util/Exception.hpp>
 #include <util/Integrals.hpp>
+#include <util/MappedFile.hpp>
+#include <util/OpenMp.hpp>
 #include <fstream>
 #include <regex>
 #include <algorithm>
 #include <numeric>
+#include <cstdlib>
+#include <cstring>
 
 using namespace sisi4s;
 
@@ -20,7 +24,7 @@ FcidumpReader::parseHeader(const std::string &filePath) {
                                       .uhf = 0,
                                       .ms2 = 0};
   std::regex rnorb{"NORB\\s*=\\s*([0-9]+)"}, rnelec{"NELEC\\s*=\\s*([0-9]+)"},
-      ruhf{"UHF\\s*=\\s*([01])"}, rms2{"MS2\\s*=\\s*([0-9]+)"},
+      ruhf{"UHF\\s*=\\s*([01]|\\.?[TtFf])"}, rms2{"MS2\\s*=\\s*([0-9]+)"},
       rend{"^\\s*([/]|&END|\\$)\\s*$"};
   std::string line;
   std::ifstream file(filePath);
@@ -32,7 +36,11 @@ FcidumpReader::parseHeader(const std::string &filePath) {
       std::regex_search(line, matches, rnelec); // parse nelec
       if (matches.size()) header.nelec = atoi(std::string{matches[1]}.c_str());
       std::regex_search(line, matches, ruhf); // parse uhf
-      if (matches.size()) header.uhf = atoi(std::string{matches[1]}.c_str());
+      if (matches.size()) {
+        const char uhf(matches.str(1)[0] == '.' ? matches.str(1)[1]
+                                                : matches.str(1)[0]);
+        header.uhf = uhf == '1' || uhf == 'T' || uhf == 't';
+      }
       std::regex_search(line, matches, rms2); // parse ms2
       if (matches.size()) header.ms2 = atoi(std::string{matches[1]}.c_str());
       std::regex_match(line, matches, rend); // parse end of header
@@ -57,6 +65,108 @@ int indexToLenght(const char a, const int No, const int Nv) {
   }
 }
 
+inline bool isBlank(const char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+/**
+ * \brief Parses the line starting at p into entry and returns whether
+ * the line is a valid integral line. p is advanced to the beginning of the
+ * next line. Neither regular expressions nor string copies are involved,
+ * only the value token is copied to a small buffer for strtod since the
+ * mapped file is not null terminated. Fortran exponents like 1.0D-3 are
+ * accepted.
+ */
+bool parseFcidumpLine(const char *&p, const char *end, FcidumpEntry &entry) {
+  const char *lineEnd(static_cast<const char *>(memchr(p, '\n', end - p)));
+  if (!lineEnd) lineEnd = end;
+  const char *c(p);
+  p = lineEnd == end ? end : lineEnd + 1;
+
+  while (c < lineEnd && isBlank(*c)) ++c;
+  // value
+  char buffer[64];
+  size_t length(0);
+  while (c < lineEnd && !isBlank(*c)) {
+    if (length + 1 == sizeof(buffer)) return false;
+    buffer[length++] = (*c == 'D' || *c == 'd') ? 'E' : *c;
+    ++c;
+  }
+  if (length == 0) return false;
+  buffer[length] = '\0';
+  char *valueEnd;
+  entry.value = std::strtod(buffer, &valueEnd);
+  if (valueEnd != buffer + length) return false;
+  // indices
+  for (int i(0); i < 4; i++) {
+    if (c == lineEnd || !isBlank(*c)) return false;
+    while (c < lineEnd && isBlank(*c)) ++c;
+    if (c == lineEnd || *c < '0' || *c > '9') return false;
+    int index(0);
+    while (c < lineEnd && *c >= '0' && *c <= '9') {
+      index = 10 * index + *c++ - '0';
+    }
+    entry.indices[i] = index;
+  }
+  while (c < lineEnd && isBlank(*c)) ++c;
+  return c == lineEnd;
+}
+
+/**
+ * \brief Returns the beginning of the integral section, i.e. the line after
+ * the end of the namelist header, or the beginning of the file if the
+ * header is not terminated.
+ */
+const char *findIntegralSection(const char *begin, const char *end) {
+  for (const char *line(begin); line < end;) {
+    const char *lineEnd(
+        static_cast<const char *>(memchr(line, '\n', end - line)));
+    if (!lineEnd) lineEnd = end;
+    const char *first(line), *last(lineEnd);
+    while (first < last && isBlank(*first)) ++first;
+    while (last > first && isBlank(last[-1])) --last;
+    const std::string token(first, last);
+    if (token == "/" || token == "&END" || token == "$") {
+      return lineEnd == end ? end : lineEnd + 1;
+    }
+    line = lineEnd + 1;
+  }
+  return begin;
+}
+
+size_t sisi4s::getSymmetryImages(const FcidumpEntry &entry,
+                                 FcidumpEntry images[8]) {
+  static const int twoBody[8][4] = {{0, 1, 2, 3},
+                                    {1, 0, 2, 3},
+                                    {0, 1, 3, 2},
+                                    {1, 0, 3, 2},
+                                    {2, 3, 0, 1},
+                                    {3, 2, 0, 1},
+                                    {2, 3, 1, 0},
+                                    {3, 2, 1, 0}};
+  static const int oneBody[2][4] = {{0, 1, 2, 3}, {1, 0, 2, 3}};
+  const int *idx(entry.indices);
+  size_t count(0), permutations(1);
+  const int(*p)[4](twoBody);
+  if (idx[0] && idx[1] && idx[2] && idx[3]) {
+    permutations = 8;
+  } else if (idx[0] && idx[1] && !idx[2] && !idx[3]) {
+    permutations = 2;
+    p = oneBody;
+  }
+  for (size_t i(0); i < permutations; i++) {
+    FcidumpEntry &image(images[count]);
+    image.value = entry.value;
+    for (int j(0); j < 4; j++) image.indices[j] = idx[p[i][j]];
+    bool distinct(true);
+    for (size_t k(0); k < count && distinct; k++) {
+      distinct = !std::equal(image.indices,
+                             image.indices + 4,
+                             images[k].indices);
+    }
+    if (distinct) ++count;
+  }
+  return count;
+}
+
 struct IntegralParser {
   // how many index columns are there in the fcidump
   static const size_t index_columns{4};
@@ -64,8 +174,6 @@ struct IntegralParser {
   std::string name;
   // e.g. hh in chemist notation
   std::string chemistName;
-  // regex for a single line
-  std::regex regex;
   // actual values of the tensor
   std::vector<double> values;
   // actual indices
@@ -74,6 +182,8 @@ struct IntegralParser {
   std::vector<int> lens;
   // ctf syms
   std::vector<int> syms;
+  // strides of the indices in physics notation (1, N_1, N_1 * N_2, ...)
+  std::vector<int64_t> strides;
   bool uhf;
   int No, Nv;
   // general size of the tensor
@@ -81,7 +191,7 @@ struct IntegralParser {
   IntegralParser(std::string name_, const FcidumpReader::FcidumpHeader &header)
       : name(name_) {
 
-    if (!std::regex_match(name, std::regex{"^[hpt]*$"})) {
+    if (name.find_first_not_of("hpt") != std::string::npos) {
       throw new EXCEPTION("Name should be a combination of [hpt] or empty");
     }
 
@@ -100,95 +210,101 @@ struct IntegralParser {
     // build dimensio
     dimension =
         std::accumulate(lens.begin(), lens.end(), 1, std::multiplies<int>());
-    // start to build regex for the numbers
-    // it starts with the numerical value of the integral
-    std::string regex_str{"^\\s*(\\S+)"};
-    // and then so many indices as lens we have
-    std::for_each(lens.begin(), lens.end(), [&](int) {
-      regex_str += "\\s+([1-9][0-9]*)";
-    });
-    // if lens is less that the number of columns available, the rest should
-    // be zeros
-    for (size_t i(0); i < (index_columns - lens.size()); ++i) {
-      regex_str += "\\s+0";
+    // build the strides
+    int64_t stride(1);
+    for (const auto len : lens) {
+      strides.push_back(stride);
+      stride *= len;
     }
-    // end with possible padding zeros
-    regex_str += "\\s*$";
-    regex = std::regex{regex_str};
   }
 
-  bool match(const std::string &line) {
-    std::smatch matches;
-    std::regex_match(line, matches, regex);
-    std::vector<int> gIndices(lens.size());
-    std::vector<int> gIndexLens(lens.size());
-    const int spin_uhf(uhf ? 1 : 2);
-
-    // matches = {line, value, index1, index2, ...}
-    if (matches.size() == 0) return false;
-
-    // check if the line relates to this integral
-    for (unsigned int i(2); i < matches.size(); i++) {
-      int k = std::atoi(std::string{matches[i]}.c_str());
+  /**
+   * \brief Checks if the given fcidump entry belongs to this integral and
+   * writes its global index in physics notation to index if it does.
+   */
+  bool match(const FcidumpEntry &entry, int64_t &index) const {
+    // the indices beyond the order of this integral have to be zeros
+    for (size_t i(lens.size()); i < index_columns; i++) {
+      if (entry.indices[i] != 0) return false;
+    }
+    int gIndices[index_columns];
+    for (size_t i(0); i < lens.size(); i++) {
+      const int k(entry.indices[i]);
+      if (k == 0) return false;
       // what is the corresponding index in our integrals, H or P?
-      const char _HorPorT(chemistName[i - 2]);
+      const char _HorPorT(chemistName[i]);
       // if the index is not what we're expecting then return false
       if ((k <= No && _HorPorT == 'p') || (k > No && _HorPorT == 'h'))
         return false;
-      if (_HorPorT == 'p') {
-        gIndices[i - 2] = k - No - 1;
-      } else if (_HorPorT == 'h') {
-        gIndices[i - 2] = k - 1;
-      } else {
-        // just get the pure index if
-        gIndices[i - 2] = k - 1;
-      }
-    }
-    // LOG(1, "FcidumpReader") << name << ":(" << chemistName << "):"
-    //<< line << std::endl;
-
-    // this will be in physics notation
-    { // build up gIndexLens (1, N_1, N_1 * N_2, ..., N_1 *...* N_n-1)
-      // copy lens into tempLens
-      std::vector<int> tempLens(lens);
-      // remove the last lens, the last element
-      tempLens.pop_back();
-      // insert at the beginning a 1
-      tempLens.insert(tempLens.begin(), 1);
-      // create the list with the partial products of the elements
-      // in tempLens, and store them in gIndexLens.begin()
-      std::partial_sum(tempLens.begin(),
-                       tempLens.end(),
-                       gIndexLens.begin(),
-                       std::multiplies<int>());
+      gIndices[i] = _HorPorT == 'p' ? k - No - 1 : k - 1;
     }
     // gIndices was read in chemist notation since it comes from a chemistName
     // so we have to change it back to physics notation to store the index
     // correctly
-    if (gIndices.size() == 4) gIndices = permuteIndices(gIndices, 1, 2);
-    values.push_back(std::atof(std::string{matches[1]}.c_str()));
-    indices.push_back(std::inner_product(gIndexLens.begin(),
-                                         gIndexLens.end(),
-                                         gIndices.begin(),
-                                         0));
+    if (lens.size() == 4) std::swap(gIndices[1], gIndices[2]);
+    index = 0;
+    for (size_t i(0); i < lens.size(); i++) index += gIndices[i] * strides[i];
     return true;
   }
 
+  /**
+   * \brief Allocates the tensor, every rank writes the entries it parsed.
+   */
   Tensor<double> *allocateTensor() {
-    const int rank_m = int(Sisi4s::world->rank == 0); // rank mask
     auto t(new Tensor<double>(lens.size(),
                               lens.data(),
                               syms.data(),
                               *Sisi4s::world));
-    t->write(rank_m * indices.size(), indices.data(), values.data());
+    t->write(indices.size(), indices.data(), values.data());
     return t;
   }
 };
 
+/**
+ * \brief Parses all lines starting within [first, last) of the integral
+ * section beginning at sectionBegin and appends every entry to all parsers
+ * it belongs to. A line starting before first is left to the preceding
+ * range. If expandSymmetry is set, every entry is also appended at all
+ * positions related by permutational symmetry.
+ */
+void parseIntegralRange(const char *sectionBegin,
+                        const char *first,
+                        const char *last,
+                        const char *end,
+                        const bool expandSymmetry,
+                        const std::vector<IntegralParser> &parsers,
+                        std::vector<std::vector<double>> &values,
+                        std::vector<std::vector<int64_t>> &indices) {
+  const char *p(first);
+  if (p != sectionBegin && p[-1] != '\n') {
+    p = static_cast<const char *>(memchr(p, '\n', end - p));
+    p = p ? p + 1 : end;
+  }
+  FcidumpEntry entry, images[8];
+  int64_t index;
+  while (p < last) {
+    if (!parseFcidumpLine(p, end, images[0])) continue;
+    entry = images[0];
+    const size_t count(expandSymmetry ? getSymmetryImages(entry, images) : 1);
+    for (size_t i(0); i < parsers.size(); i++) {
+      for (size_t k(0); k < count; k++) {
+        if (!parsers[i].match(images[k], index)) continue;
+        values[i].push_back(images[k].value);
+        indices[i].push_back(index);
+      }
+    }
+  }
+}
+
 void FcidumpReader::run() {
   const auto filePath(getTextArgument("file", "FCIDUMP"));
   // override the header of the fcidump
   const int nelec(getIntegerArgument("nelec", -1));
+  const int threads(getIntegerArgument("threads", getMaxThreads()));
+  if (threads < 1) throw new EXCEPTION("threads must be at least 1");
+  // fcidump files only list the symmetry unique integrals, set to 0 for
+  // files listing all of them
+  const bool expandSymmetry(getIntegerArgument("expandSymmetry", 1) == 1);
   FcidumpReader::FcidumpHeader header(parseHeader(filePath));
   if (nelec != -1) header.nelec = nelec;
   const int No((header.uhf == 1 ? 1 : 0.5) * header.nelec);
@@ -203,26 +319,8 @@ void FcidumpReader::run() {
   LOG(0, "FcidumpReader") << "UHF     = " << header.uhf << std::endl;
   LOG(0, "FcidumpReader") << "No      = " << No << std::endl;
   LOG(0, "FcidumpReader") << "Nv      = " << Nv << std::endl;
-
-  const std::vector<IntegralInfo> twoBody({
-      {"tttt", {NP, NP, NP, NP}, "pqrs"},
-      {"hhhh", {NO, NO, NO, NO}, "ijkl"},
-      {"hhhp", {NO, NO, NO, NV}, "ijka"},
-      {"hhph", {NO, NO, NV, NO}, "ijak"},
-      {"hhpp", {NO, NO, NV, NV}, "ijab"},
-      {"hphh", {NO, NV, NO, NO}, "iajk"},
-      {"hphp", {NO, NV, NO, NV}, "iajb"},
-      {"hpph", {NO, NV, NV, NO}, "iabj"},
-      {"hppp", {NO, NV, NV, NV}, "iabc"},
-      {"phhh", {NV, NO, NO, NO}, "aijk"},
-      {"phhp", {NV, NO, NO, NV}, "aijb"},
-      {"phph", {NV, NO, NV, NO}, "aibj"},
-      {"phpp", {NV, NO, NV, NV}, "aibc"},
-      {"pphh", {NV, NV, NO, NO}, "abij"},
-      {"pphp", {NV, NV, NO, NV}, "abic"},
-      {"ppph", {NV, NV, NV, NO}, "abci"},
-      {"pppp", {NV, NV, NV, NV}, "abcd"},
-  });
+  LOG(0, "FcidumpReader") << "expandSymmetry = " << expandSymmetry
+                          << std::endl;
 
   const std::vector<std::string> integralNames{
       "tt",   "tttt", "hh",   "pp",   "hp",   "ph",   "hhhh", "hhhp",
@@ -237,24 +335,47 @@ void FcidumpReader::run() {
     }
   }
 
-  std::ifstream file(filePath);
-  std::string line;
-  if (file.is_open()) {
-    while (std::getline(file, line)) {
-      for (auto it = integralParsers.begin(); it != integralParsers.end();
-           ++it) {
-        if ((*it).match(line)) {
-          // Swap position of the first element in the parsers because
-          // it's highly probable that the line in the fcidump also referes
-          // to this integral, for large files and many integrals this will
-          // be beneficial
-          std::iter_swap(integralParsers.begin(), it);
-          break;
-        }
+  {
+    // every rank parses its own contiguous chunk of the integral section,
+    // which is again split among the threads
+    const MappedFile file(filePath);
+    const char *sectionBegin(findIntegralSection(file.begin(), file.end()));
+    const size_t sectionSize(file.end() - sectionBegin),
+        rank(Sisi4s::world->rank), np(Sisi4s::world->np),
+        chunks(np * std::max(threads, 1));
+    std::vector<std::vector<std::vector<double>>> values(
+        chunks / np,
+        std::vector<std::vector<double>>(integralParsers.size()));
+    std::vector<std::vector<std::vector<int64_t>>> indices(
+        chunks / np,
+        std::vector<std::vector<int64_t>>(integralParsers.size()));
+    const auto chunkBegin = [&](const size_t chunk) {
+      return sectionBegin + sectionSize * chunk / chunks;
+    };
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for (size_t t = 0; t < chunks / np; t++) {
+      const size_t chunk(rank * (chunks / np) + t);
+      parseIntegralRange(sectionBegin,
+                         chunkBegin(chunk),
+                         chunkBegin(chunk + 1),
+                         file.end(),
+                         expandSymmetry,
+                         integralParsers,
+                         values[t],
+                         indices[t]);
+    }
+    for (size_t t(0); t < chunks / np; t++) {
+      for (size_t i(0); i < integralParsers.size(); i++) {
+        auto &parser(integralParsers[i]);
+        parser.values.insert(parser.values.end(),
+                             values[t][i].begin(),
+                             values[t][i].end());
+        parser.indices.insert(parser.indices.end(),
+                              indices[t][i].begin(),
+                              indices[t][i].end());
       }
     }
   }
-  file.close();
   LOG(0, "FcidumpReader") << "parsing done" << std::endl;
 
   for (auto &parser : integralParsers) {
@@ -2,9 +2,30 @@
 #define FCIDUMP_READER_DEFINED
 
 #include <algorithms/Algorithm.hpp>
+#include <cstddef>
 
 namespace sisi4s {
 
+/**
+ * \brief A single line of the integral section of an fcidump file,
+ * a value followed by four orbital indices, where unused indices are 0.
+ */
+struct FcidumpEntry {
+  double value;
+  int indices[4];
+};
+
+/**
+ * \brief Writes the distinct entries related to the given one by the
+ * permutational symmetry of real integrals to images and returns their
+ * number, the entry itself being the first one.
+ * Two-body entries (ij|kl) have up to 8 images
+ *   (ij|kl) = (ji|kl) = (ij|lk) = (ji|lk) = (kl|ij) = (lk|ij) = (kl|ji)
+ *   = (lk|ji),
+ * one-body entries (ij| have up to 2, i.e. (ij| and (ji|.
+ */
+size_t getSymmetryImages(const FcidumpEntry &entry, FcidumpEntry images[8]);
+
 class FcidumpReader : public Algorithm {
 public:
   struct FcidumpHeader {
@@ -10,7 +10,13 @@
 #include <algorithm>
 #include <numeric>
 #include <ostream>
+#include <sstream>
 #include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <set>
+#include <tuple>
+#include <mpi.h>
 
 using namespace sisi4s;
 
@@ -22,13 +28,77 @@ struct TensorInfo {
   const std::vector<Index> indices;
 };
 
+namespace sisi4s {
 inline std::ostream &operator<<(std::ostream &s,
                                 const FcidumpReader::FcidumpHeader &h) {
-  return s << "&FCI" << std::endl
-           << " NORB=" << h.norb << std::endl
-           << " NELEC=" << h.nelec << std::endl
-           << " MS2=" << h.ms2 << std::endl
-           << "/" << std::endl;
+  s << " &FCI NORB=" << h.norb << ",NELEC=" << h.nelec << ",MS2=" << h.ms2
+    << "," << std::endl
+    << "  ORBSYM=";
+  for (size_t i(0); i < h.norb; i++) {
+    s << "1,";
+    if ((i + 1) % 32 == 0 && i + 1 < h.norb) s << std::endl << "  ";
+  }
+  return s << std::endl
+           << "  ISYM=1," << std::endl
+           << "  UHF=" << (h.uhf ? ".TRUE." : ".FALSE.") << "," << std::endl
+           << " &END" << std::endl;
+}
+} // namespace sisi4s
+
+inline int64_t getPairIndex(const int64_t i, const int64_t j) {
+  return i >= j ? i * (i - 1) / 2 + j : j * (j - 1) / 2 + i;
+}
+
+typedef std::tuple<bool, int64_t, int64_t, int, int, int, int> CanonicalKey;
+
+/**
+ * \brief Orders the symmetry images of an entry, the image with the
+ * largest key is the one written. For complete integrals this is the
+ * usual (ij|kl) with i>=j, k>=l and ij>=kl.
+ */
+inline CanonicalKey getCanonicalKey(const FcidumpEntry &e) {
+  const int *c(e.indices);
+  return CanonicalKey(c[0] >= c[1] && c[2] >= c[3],
+                      getPairIndex(c[0], c[1]),
+                      getPairIndex(c[2], c[3]),
+                      c[0],
+                      c[1],
+                      c[2],
+                      c[3]);
+}
+
+/**
+ * \brief Writes the local data of all ranks one after another, in the
+ * order of the ranks, starting at offset. Returns the offset after the
+ * data of the last rank.
+ */
+int64_t writeOrdered(MPI_File &file,
+                     const int64_t offset,
+                     const char *data,
+                     const int64_t size) {
+  int64_t localOffset(0), totalSize(0);
+  MPI_Exscan(&size, &localOffset, 1, MPI_INT64_T, MPI_SUM, Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) localOffset = 0;
+  MPI_Allreduce(&size,
+                &totalSize,
+                1,
+                MPI_INT64_T,
+                MPI_SUM,
+                Sisi4s::world->comm);
+  // write in chunks fitting into the int counts of mpi
+  const int64_t maxChunkSize(int64_t(1) << 30);
+  MPI_Status status;
+  for (int64_t written(0); written < size;) {
+    const int64_t chunkSize(std::min(maxChunkSize, size - written));
+    MPI_File_write_at(file,
+                      offset + localOffset + written,
+                      data + written,
+                      int(chunkSize),
+                      MPI_BYTE,
+                      &status);
+    written += chunkSize;
+  }
+  return offset + totalSize;
 }
 
 void FcidumpWriter::run() {
@@ -36,6 +106,9 @@ void FcidumpWriter::run() {
   size_t uhf(getIntegerArgument("uhf", 0));
   size_t ms2(getIntegerArgument("ms2", 0));
   const double threshold(getRealArgument("threshold", 1e-6));
+  const double coreEnergy(getRealArgument("coreEnergy", 0.0));
+  // write the binary variant instead of the text fcidump
+  const bool binary(getIntegerArgument("binary", 0) == 1);
   int No(NxUndefined);
   int Nv(NxUndefined);
   FcidumpReader::FcidumpHeader header;
@@ -95,20 +168,176 @@ void FcidumpWriter::run() {
   LOG(0, "FcidumpWriter") << "UHF       = " << header.uhf << std::endl;
   LOG(0, "FcidumpWriter") << "No        = " << No << std::endl;
   LOG(0, "FcidumpWriter") << "Nv        = " << Nv << std::endl;
+  LOG(0, "FcidumpWriter") << "binary    = " << binary << std::endl;
 
-  // TODO: do this really well, now it's kind of a hack
-  // TODO: also write the header into the file
+  // the integrals given, in which the symmetry images of an element may lie
+  std::set<std::string> givenIntegrals;
   for (const auto &integral : allIntegrals) {
-    if (!isArgumentGiven(integral.name)) continue;
+    if (isArgumentGiven(integral.name)) givenIntegrals.insert(integral.name);
+  }
+  const bool fullTwoBody(givenIntegrals.count("PPPP"));
+  // whether the given entry (ij|kl) or (ij| lies in one of the given
+  // integrals, which are in physics notation <ik|jl>
+  const auto isPresent = [&](const FcidumpEntry &e) {
+    const bool twoBody(e.indices[2] != 0);
+    if (twoBody && fullTwoBody) return true;
+    const int physics[4] = {0, 2, 1, 3};
+    std::string name;
+    for (int d(0); d < (twoBody ? 4 : 2); d++) {
+      name += e.indices[twoBody ? physics[d] : d] <= No ? 'h' : 'p';
+    }
+    return givenIntegrals.count(name) > 0;
+  };
+
+  MPI_File file;
+  int mpiError(MPI_File_open(Sisi4s::world->comm,
+                             filePath.c_str(),
+                             MPI_MODE_CREATE | MPI_MODE_WRONLY,
+                             MPI_INFO_NULL,
+                             &file));
+  if (mpiError) {
+    throw new EXCEPTION("Failed to open file \"" + filePath + "\"");
+  }
+  // truncate possibly existing file
+  MPI_File_set_size(file, 0);
+  MPI_Status status;
+  int64_t offset(0);
+
+  // every rank selects the symmetry unique elements above the threshold
+  // from its local data of each integral
+  std::vector<std::vector<BinaryFcidumpEntry>> entries;
+  for (const auto &integral : allIntegrals) {
+    if (!givenIntegrals.count(integral.name)) continue;
+    const bool twoBody(integral.indices.size() == 4);
+    if (twoBody && fullTwoBody && integral.name != "PPPP") {
+      LOG(0, "FcidumpWriter") << "Skipping " << integral.name
+                              << ", contained in PPPP" << std::endl;
+      continue;
+    }
     auto tensor(getTensorArgument<double>(integral.name));
-    FILE *fd;
-    fd = std::fopen(_FORMAT("%s.fcidump", integral.name.c_str()).c_str(), "w+");
-    tensor->print(fd);
-    std::fclose(fd);
+    int64_t valuesCount, *globalIndices;
+    double *values;
+    tensor->read_local(&valuesCount, &globalIndices, &values);
+    entries.push_back(std::vector<BinaryFcidumpEntry>());
+    FcidumpEntry images[8];
+    for (int64_t l(0); l < valuesCount; l++) {
+      if (std::abs(values[l]) < threshold) continue;
+      // orbitals of the tensor indices, starting from 1
+      int orbitals[4] = {0, 0, 0, 0};
+      int64_t g(globalIndices[l]);
+      for (int d(0); d < tensor->order; d++) {
+        const int64_t index(g % tensor->lens[d]);
+        g /= tensor->lens[d];
+        orbitals[d] = integral.name[d] == 'p' ? No + index + 1 : index + 1;
+      }
+      FcidumpEntry entry;
+      entry.value = values[l];
+      entry.indices[0] = orbitals[0];
+      entry.indices[1] = twoBody ? orbitals[2] : orbitals[1];
+      entry.indices[2] = twoBody ? orbitals[1] : 0;
+      entry.indices[3] = twoBody ? orbitals[3] : 0;
+      // only write the element if it is the canonical one among its
+      // images present in the given integrals
+      const size_t count(getSymmetryImages(entry, images));
+      const CanonicalKey key(getCanonicalKey(entry));
+      bool canonical(true);
+      for (size_t k(1); k < count && canonical; k++) {
+        canonical = !(isPresent(images[k]) && getCanonicalKey(images[k]) > key);
+      }
+      if (!canonical) continue;
+      BinaryFcidumpEntry e;
+      e.value = entry.value;
+      for (int d(0); d < 4; d++) e.indices[d] = entry.indices[d];
+      entries.back().push_back(e);
+    }
+    free(globalIndices);
+    free(values);
   }
 
-  std::ifstream file(filePath);
-  std::string line;
-  if (file.is_open()) {}
-  file.close();
+  BinaryFcidumpEntry core;
+  core.value = coreEnergy;
+  for (int d(0); d < 4; d++) core.indices[d] = 0;
+  const bool root(Sisi4s::world->rank == 0);
+
+  if (binary) {
+    int64_t localCount(0), count(0);
+    for (const auto &block : entries) localCount += block.size();
+    MPI_Allreduce(&localCount,
+                  &count,
+                  1,
+                  MPI_INT64_T,
+                  MPI_SUM,
+                  Sisi4s::world->comm);
+    BinaryFcidumpHeader binaryHeader;
+    std::memcpy(binaryHeader.magic, "FCIDUMPB", sizeof(binaryHeader.magic));
+    binaryHeader.version = 1;
+    binaryHeader.norb = header.norb;
+    binaryHeader.nelec = header.nelec;
+    binaryHeader.ms2 = header.ms2;
+    binaryHeader.uhf = header.uhf;
+    binaryHeader.reserved = 0;
+    // including the core energy
+    binaryHeader.entriesCount = count + 1;
+    if (root) {
+      MPI_File_write_at(file,
+                        offset,
+                        &binaryHeader,
+                        sizeof(binaryHeader),
+                        MPI_BYTE,
+                        &status);
+    }
+    offset += sizeof(binaryHeader);
+    for (const auto &block : entries) {
+      offset = writeOrdered(file,
+                            offset,
+                            reinterpret_cast<const char *>(block.data()),
+                            block.size() * sizeof(BinaryFcidumpEntry));
+    }
+    if (root) {
+      MPI_File_write_at(file, offset, &core, sizeof(core), MPI_BYTE, &status);
+    }
+  } else {
+    const auto format = [](const BinaryFcidumpEntry &e, std::string &text) {
+      char line[96];
+      const int length(std::snprintf(line,
+                                     sizeof(line),
+                                     "%24.16E%5d%5d%5d%5d\n",
+                                     e.value,
+                                     e.indices[0],
+                                     e.indices[1],
+                                     e.indices[2],
+                                     e.indices[3]));
+      text.append(line, length);
+    };
+    std::stringstream headerStream;
+    headerStream << header;
+    const std::string headerText(headerStream.str());
+    if (root) {
+      MPI_File_write_at(file,
+                        offset,
+                        headerText.data(),
+                        headerText.size(),
+                        MPI_BYTE,
+                        &status);
+    }
+    offset += headerText.size();
+    for (auto &block : entries) {
+      std::string text;
+      for (const auto &e : block) format(e, text);
+      // free the entries early
+      std::vector<BinaryFcidumpEntry>().swap(block);
+      offset = writeOrdered(file, offset, text.data(), text.size());
+    }
+    std::string coreText;
+    format(core, coreText);
+    if (root) {
+      MPI_File_write_at(file,
+                        offset,
+                        coreText.data(),
+                        coreText.size(),
+                        MPI_BYTE,
+                        &status);
+    }
+  }
+  MPI_File_close(&file);
 }
@@ -2,9 +2,29 @@
 #define FCIDUMP_WRITER_DEFINED
 
 #include <algorithms/Algorithm.hpp>
+#include <cstdint>
 
 namespace sisi4s {
 
+/**
+ * \brief Header of the binary fcidump variant written with binary=1.
+ * It is followed by entriesCount records of BinaryFcidumpEntry, holding
+ * the same entries as the text variant, such that the whole integral
+ * list can be loaded with a single read. All numbers are in the native
+ * byte order of the writing machine.
+ */
+struct BinaryFcidumpHeader {
+  char magic[8]; // "FCIDUMPB"
+  int32_t version, norb, nelec, ms2, uhf, reserved;
+  int64_t entriesCount;
+};
+
+struct BinaryFcidumpEntry {
+  double value;
+  // orbital indices starting from 1, unused ones are 0
+  int32_t indices[4];
+};
+
 class FcidumpWriter : public Algorithm {
 public:
   ALGORITHM_REGISTRAR_DECLARATION(FcidumpWriter);
@@ -7,6 +7,8 @@
 #include <util/Log.hpp>
 #include <iostream>
 #include <util/Tensor.hpp>
+#include <util/Emitter.hpp>
+#include <math/ScfDiis.hpp>
 #include <numeric>
 #define IF_GIVEN(_l, ...)                                                      \
   if (isArgumentGiven(_l)) { __VA_ARGS__ }
@@ -73,7 +75,8 @@ void HartreeFockFromCoulombIntegrals::run() {
                        "HartreeFockEnergy",
                        "HoleEigenEnergies",
                        "ParticleEigenEnergies",
-                       "linearMixer"});
+                       "linearMixer",
+                       "diisSubspaceSize"});
 
   const auto ctfH(getTensorArgument<double>("h"));
   const auto H(sisi4s::toEigenMatrix(*ctfH));
@@ -84,9 +87,12 @@ void HartreeFockFromCoulombIntegrals::run() {
   const unsigned int maxIterations(getIntegerArgument("maxIterations", 16));
   const double electronicConvergence(getRealArgument("energyDifference", 1e-4)),
       linearMixer(getRealArgument("linearMixer", 1.0));
+  // a subspace size smaller than 2 disables the DIIS extrapolation
+  const int diisSubspaceSize(getIntegerArgument("diisSubspaceSize", 6));
 
   LOGGER(1) << "maxIterations: " << maxIterations << std::endl;
   LOGGER(1) << "ediff: " << electronicConvergence << std::endl;
+  LOGGER(1) << "diisSubspaceSize: " << diisSubspaceSize << std::endl;
   LOGGER(1) << "No: " << No << std::endl;
   LOGGER(1) << "Nv: " << Nv << std::endl;
   LOGGER(1) << "Calculating overlaps" << std::endl;
@@ -126,6 +132,7 @@ void HartreeFockFromCoulombIntegrals::run() {
   double ehf(0);
   double ehfLast(0);
   MatrixColumnMajor eps, C;
+  ScfDiis<MatrixColumnMajor> diis(std::max(diisSubspaceSize, 0));
 
   const auto updateHamiltonian = [&] {
     F = H;
@@ -143,9 +150,9 @@ void HartreeFockFromCoulombIntegrals::run() {
 
   const auto updateDensity = [&] {
     LOGGER(1) << "Diagonalize" << std::endl;
-    // solve F C = e S C
+    // solve F C = e S C for the extrapolated Fock matrix
     Eigen::GeneralizedSelfAdjointEigenSolver<MatrixColumnMajor> gen_eig_solver(
-        F,
+        diis.extrapolate(F, D, S),
         S);
     eps = gen_eig_solver.eigenvalues();
 
@@ -165,6 +172,8 @@ void HartreeFockFromCoulombIntegrals::run() {
   updateEnergy();
   LOGGER(1) << "initial guess energy = " << ehf << std::endl;
 
+  EMIT() << YAML::Key << "iterations" << YAML::Value << YAML::BeginSeq;
+
   do {
 
     ++iter;
@@ -183,16 +192,31 @@ void HartreeFockFromCoulombIntegrals::run() {
                 << "\t"
                 << "DeltaE"
                 << "\t"
-                << "RMS(D)" << std::endl;
+                << "RMS(D)"
+                << "\t"
+                << "DIIS" << std::endl;
     }
 
     LOGGER_IT(1) << iter << "\t" << ehf << "\t" << energyDifference << "\t"
-                 << rmsd << "\t" << std::endl;
+                 << rmsd << "\t" << diis.getErrorNorm() << "\t" << std::endl;
+
+    EMIT() << YAML::BeginMap << YAML::Key << "iteration" << YAML::Value << iter
+           << YAML::Key << "energy" << YAML::Value << YAML::BeginMap
+           << YAML::Key << "value" << YAML::Value << ehf << YAML::EndMap
+           << YAML::Key << "diis" << YAML::Value << YAML::BeginMap
+           << YAML::Key << "error-norm" << YAML::Value << diis.getErrorNorm()
+           << YAML::Key << "subspace-size" << YAML::Value
+           << diis.getSubspaceSize() << YAML::EndMap << YAML::EndMap;
 
   } while (((fabs(energyDifference) > electronicConvergence)
             || (fabs(rmsd) > electronicConvergence))
            && (iter < maxIterations));
 
+  EMIT() << YAML::EndSeq;
+  EMIT() << YAML::Key << "iterations-count" << YAML::Value << iter
+         << YAML::Key << "diis-error-norm" << YAML::Value
+         << diis.getErrorNorm();
+
   for (unsigned int e; e < eps.size(); e++) {
     LOGGER(1) << "band " << e + 1 << " = " << eps(e, 0) << std::endl;
   }
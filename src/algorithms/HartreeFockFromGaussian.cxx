@@ -34,6 +34,9 @@
 #include <vector>
 #include <numeric> // std::iota
 #include <util/Libint.hpp>
+#include <util/OpenMp.hpp>
+#include <util/SchwarzScreening.hpp>
+#include <math/ScfDiis.hpp>
 #include <algorithms/HartreeFockFromGaussian.hpp>
 #include <algorithms/OneBodyFromGaussian.hpp>
 #include <util/Tensor.hpp>
@@ -94,7 +97,8 @@ struct ShellInfo {
 
 Eigen::MatrixXd getOneBodyIntegrals_(const libint2::BasisSet &shells,
                                      const libint2::Operator obtype,
-                                     const std::vector<libint2::Atom> &atoms) {
+                                     const std::vector<libint2::Atom> &atoms,
+                                     const int threads) {
 
   // Get number of basis set functions
   const size_t Np = shells.nbf();
@@ -112,10 +116,14 @@ Eigen::MatrixXd getOneBodyIntegrals_(const libint2::BasisSet &shells,
     engine.set_params(q);
   }
 
-  const auto &resultBuffer = engine.results();
+  // one engine per thread
+  std::vector<libint2::Engine> engines(threads, engine);
 
-  // loop over unique shell pairs p>=q
+  // loop over unique shell pairs p>=q, every pair writes its own blocks
+#pragma omp parallel for schedule(dynamic) num_threads(threads)
   for (size_t p = 0; p < shells.size(); ++p) {
+    auto &engine(engines[getThreadNumber()]);
+    const auto &resultBuffer = engine.results();
     for (size_t q = 0; q <= p; ++q) {
 
       const ShellInfo P(shells, p), Q(shells, q);
@@ -141,71 +149,103 @@ Eigen::MatrixXd getOneBodyIntegrals_(const libint2::BasisSet &shells,
   return result;
 }
 
+/**
+ * \brief Two-electron part G = 2J - K of the Fock matrix for the density
+ * matrix D, calculated integral-driven over the unique shell quartets.
+ * Every quartet is computed once and scattered to all Coulomb and exchange
+ * elements it contributes to, using the 8-fold permutational symmetry.
+ * Quartets whose density weighted Schwarz bound falls below the
+ * screening threshold are skipped. Since D may also be a density
+ * difference, the screening then becomes tighter as the SCF converges.
+ */
 Eigen::MatrixXd getTwoBodyFock(const libint2::BasisSet &shells,
-                               const Eigen::MatrixXd &D) {
+                               const Eigen::MatrixXd &D,
+                               SchwarzScreening &screening,
+                               const int threads,
+                               size_t &computed,
+                               size_t &screened) {
 
   const size_t Np = shells.nbf();
-  Eigen::MatrixXd G = Eigen::MatrixXd::Zero(Np, Np);
+  screening.setDensity(D);
 
-  // turn on the engine
-  libint2::Engine engine(libint2::Operator::coulomb,
-                         shells.max_nprim(),
-                         shells.max_l(),
-                         0);
+  // turn on the engines, one per thread
+  std::vector<libint2::Engine> engines(
+      threads,
+      libint2::Engine(libint2::Operator::coulomb,
+                      shells.max_nprim(),
+                      shells.max_l(),
+                      0));
 
-  // integrals[0] points to the target shell set after every call to
-  // engine.compute
-  const auto &integrals = engine.results();
+  // every thread accumulates into its own G, which are summed up at the end
+  std::vector<Eigen::MatrixXd> Gs(threads, Eigen::MatrixXd::Zero(Np, Np));
 
+  // the unique leading shell pairs _Q <= _P distributed among the threads
+  std::vector<std::pair<size_t, size_t>> pairs;
   for (size_t _P = 0; _P < shells.size(); ++_P) {
-    for (size_t _Q = 0; _Q < shells.size(); ++_Q) {
-      for (size_t _R = 0; _R < shells.size(); ++_R) {
-        for (size_t _S = 0; _S < shells.size(); ++_S) {
-          // Fock matrix loop indices: _P, _Q
-          // dens matrix loop indices: _R, _S
-          // TODO: use simmetry for _R and _S
-          // TODO: angular momentum checking
-          const ShellInfo P(shells, _P), Q(shells, _Q), R(shells, _R),
-              S(shells, _S);
-
-          // Coulomb contribution to the Fock matrix is from {_P,_Q,_R,_S} ints
-          engine.compute(shells[_P], shells[_Q], shells[_R], shells[_S]);
-          const double *Vprqs = integrals[0];
-          // if all integrals screened out, skip to next quartet
-          if (Vprqs == nullptr) continue;
-
-          // Hartree part
-          for (size_t p(P.begin), Iprqs = 0; p < P.end; ++p) {
-            for (size_t q(Q.begin); q < Q.end; ++q) {
-              for (size_t r(R.begin); r < R.end; ++r) {
-                for (size_t s(S.begin); s < S.end; ++s, ++Iprqs) {
-                  G(p, q) += D(r, s) * 2.0 * Vprqs[Iprqs];
-                } // s
-              }   // r
-            }     // q
-          }       // p
-
-          // exchange contribution to the Fock matrix is from {_P,_R,_Q,_S} ints
-          engine.compute(shells[_P], shells[_R], shells[_Q], shells[_S]);
-          const double *Vprsq = integrals[0];
-
-          // Exchange part
-          for (size_t p(P.begin), Iprsq = 0; p < P.end; ++p) {
+    for (size_t _Q = 0; _Q <= _P; ++_Q) pairs.push_back({_P, _Q});
+  }
+
+  size_t computedQuartets(0), screenedQuartets(0);
+#pragma omp parallel for schedule(dynamic) num_threads(threads)                \
+    reduction(+ : computedQuartets, screenedQuartets)
+  for (size_t pq = 0; pq < pairs.size(); ++pq) {
+    const size_t _P(pairs[pq].first), _Q(pairs[pq].second);
+    const int t(getThreadNumber());
+    auto &engine(engines[t]);
+    auto &G(Gs[t]);
+    // integrals[0] points to the target shell set after every call to
+    // engine.compute
+    const auto &integrals = engine.results();
+    const ShellInfo P(shells, _P), Q(shells, _Q);
+    const double PQdegeneracy(_P == _Q ? 1.0 : 2.0);
+    for (size_t _R = 0; _R <= _P; ++_R) {
+      const size_t _Smax(_R == _P ? _Q : _R);
+      for (size_t _S = 0; _S <= _Smax; ++_S) {
+        if (!screening.isSignificantWeighted(_P, _Q, _R, _S)) {
+          screenedQuartets++;
+          continue;
+        }
+        computedQuartets++;
+        const ShellInfo R(shells, _R), S(shells, _S);
+
+        engine.compute(shells[_P], shells[_Q], shells[_R], shells[_S]);
+        const double *Vpqrs = integrals[0];
+        // if all integrals screened out, skip to next quartet
+        if (Vpqrs == nullptr) continue;
+
+        // number of equivalent quartets (PQ|RS) represents
+        const double RSdegeneracy(_R == _S ? 1.0 : 2.0),
+            PQRSdegeneracy(_P == _R ? (_Q == _S ? 1.0 : 2.0) : 2.0),
+            degeneracy(PQdegeneracy * RSdegeneracy * PQRSdegeneracy);
+
+        for (size_t p(P.begin), Ipqrs = 0; p < P.end; ++p) {
+          for (size_t q(Q.begin); q < Q.end; ++q) {
             for (size_t r(R.begin); r < R.end; ++r) {
-              for (size_t q(Q.begin); q < Q.end; ++q) {
-                for (size_t s(S.begin); s < S.end; ++s, ++Iprsq) {
-                  G(p, q) -= D(r, s) * Vprsq[Iprsq];
-                } // s
-              }   // q
-            }     // r
-          }       // p
-
-        } // _S
-      }   // _R
-    }     // _Q
-  }       // _P
-
-  return G;
+              for (size_t s(S.begin); s < S.end; ++s, ++Ipqrs) {
+                const double v(Vpqrs[Ipqrs] * degeneracy);
+                // Hartree part
+                G(p, q) += D(r, s) * v;
+                G(r, s) += D(p, q) * v;
+                // exchange part
+                G(p, r) -= 0.25 * D(q, s) * v;
+                G(q, s) -= 0.25 * D(p, r) * v;
+                G(p, s) -= 0.25 * D(q, r) * v;
+                G(q, r) -= 0.25 * D(p, s) * v;
+              } // s
+            }   // r
+          }     // q
+        }       // p
+
+      } // _S
+    }   // _R
+  }     // pq
+
+  for (int t(1); t < threads; t++) Gs[0] += Gs[t];
+  computed += computedQuartets;
+  screened += screenedQuartets;
+
+  // symmetrize, only one of the images of each element has been accumulated
+  return 0.5 * (Gs[0] + Gs[0].transpose());
 }
 
 void HartreeFockFromGaussian::run() {
@@ -222,7 +262,12 @@ void HartreeFockFromGaussian::run() {
                                            "initialOrbitalCoefficients",
                                            "HartreeFockEnergy",
                                            "HoleEigenEnergies",
-                                           "ParticleEigenEnergies"};
+                                           "ParticleEigenEnergies",
+                                           "threads",
+                                           "screeningThreshold",
+                                           "incrementalFock",
+                                           "fockRebuildIterations",
+                                           "diisSubspaceSize"};
   checkArgumentsOrDie(allArguments);
 
   const std::string xyzStructureFile(getTextArgument("xyzStructureFile", "")),
@@ -232,9 +277,26 @@ void HartreeFockFromGaussian::run() {
   int numberOfElectrons(getIntegerArgument("numberOfElectrons", -1));
   unsigned int maxIterations(getIntegerArgument("maxIterations", 16)), i,
       nBasisFunctions, No, Nv, Np;
+  const int threads(getIntegerArgument("threads", getMaxThreads()));
+  if (threads < 1) throw new EXCEPTION("threads must be at least 1");
+  const double screeningThreshold(getRealArgument("screeningThreshold", 1e-12));
+  // build the two-electron part of the Fock matrix from the density
+  // difference to the previous iteration, rebuilding it from the full
+  // density every fockRebuildIterations to avoid accumulating errors
+  const bool incrementalFock(getIntegerArgument("incrementalFock", 1) == 1);
+  const int fockRebuildIterations(
+      getIntegerArgument("fockRebuildIterations", 8));
+  // a subspace size smaller than 2 disables the DIIS extrapolation
+  const int diisSubspaceSize(getIntegerArgument("diisSubspaceSize", 6));
 
   LOGGER(1) << "maxIterations: " << maxIterations << std::endl;
   LOGGER(1) << "ediff: " << electronicConvergence << std::endl;
+  LOGGER(1) << "threads: " << threads << std::endl;
+  LOGGER(1) << "screeningThreshold: " << screeningThreshold << std::endl;
+  LOGGER(1) << "incrementalFock: " << incrementalFock << std::endl;
+  LOGGER(1) << "fockRebuildIterations: " << fockRebuildIterations
+            << std::endl;
+  LOGGER(1) << "diisSubspaceSize: " << diisSubspaceSize << std::endl;
 
   // Initialize libint
   LOGGER(1) << "libint2: " << LIBINT_VERSION << std::endl;
@@ -293,16 +355,16 @@ void HartreeFockFromGaussian::run() {
 
   LOGGER(1) << "Calculating overlaps" << std::endl;
   Eigen::MatrixXd S =
-      getOneBodyIntegrals_(shells, libint2::Operator::overlap, atoms);
+      getOneBodyIntegrals_(shells, libint2::Operator::overlap, atoms, threads);
 
   LOGGER(1) << "Calculating kinetic integrals" << std::endl;
   Eigen::MatrixXd T =
-      getOneBodyIntegrals_(shells, libint2::Operator::kinetic, atoms);
+      getOneBodyIntegrals_(shells, libint2::Operator::kinetic, atoms, threads);
   LOGGER(1) << "T(" << T.rows() << "," << T.cols() << ")" << std::endl;
 
   LOGGER(1) << "Compute nuclear repulsion integrals" << std::endl;
   Eigen::MatrixXd V =
-      getOneBodyIntegrals_(shells, libint2::Operator::nuclear, atoms);
+      getOneBodyIntegrals_(shells, libint2::Operator::nuclear, atoms, threads);
   LOGGER(1) << "V(" << V.rows() << "," << V.cols() << ")" << std::endl;
 
   LOGGER(1) << "Calculating the core hamiltonian" << std::endl;
@@ -347,6 +409,16 @@ void HartreeFockFromGaussian::run() {
   double ehfLast(0);
   Eigen::MatrixXd eps, C;
 
+  LOGGER(1) << "Calculating Schwarz bounds" << std::endl;
+  SchwarzScreening screening(shells,
+                             libint2::Operator::coulomb,
+                             screeningThreshold);
+  // two-electron part of the Fock matrix and the density it was built from
+  Eigen::MatrixXd G(Eigen::MatrixXd::Zero(nBasisFunctions, nBasisFunctions));
+  Eigen::MatrixXd D_built(G);
+  size_t totalComputed(0), totalScreened(0);
+  ScfDiis<Eigen::MatrixXd> diis(std::max(diisSubspaceSize, 0));
+
   EMIT() << YAML::Key << "iterations" << YAML::Value << YAML::BeginSeq;
 
   do {
@@ -356,13 +428,31 @@ void HartreeFockFromGaussian::run() {
     ehfLast = ehf;
     D_last = D;
 
-    F = H;
-    LOGGER(2) << "calculating fock matrix" << std::endl;
-    F += getTwoBodyFock(shells, D);
-
-    // solve F C = e S C
-    Eigen::GeneralizedSelfAdjointEigenSolver<Eigen::MatrixXd> gen_eig_solver(F,
-                                                                             S);
+    size_t computed(0), screened(0);
+    const bool rebuild(!incrementalFock || fockRebuildIterations <= 1
+                       || (iter - 1) % fockRebuildIterations == 0);
+    if (rebuild) {
+      LOGGER(2) << "calculating fock matrix" << std::endl;
+      G = getTwoBodyFock(shells, D, screening, threads, computed, screened);
+    } else {
+      LOGGER(2) << "updating fock matrix" << std::endl;
+      const Eigen::MatrixXd deltaD(D - D_built);
+      G += getTwoBodyFock(shells,
+                          deltaD,
+                          screening,
+                          threads,
+                          computed,
+                          screened);
+    }
+    D_built = D;
+    totalComputed += computed;
+    totalScreened += screened;
+    F = H + G;
+
+    // solve F C = e S C for the extrapolated Fock matrix
+    Eigen::GeneralizedSelfAdjointEigenSolver<Eigen::MatrixXd> gen_eig_solver(
+        diis.extrapolate(F, D, S),
+        S);
     eps = gen_eig_solver.eigenvalues();
 
     // C now has all eigenvectors from the shell of course
@@ -391,22 +481,37 @@ void HartreeFockFromGaussian::run() {
           << "\t"
           << "DeltaE"
           << "\t"
-          << "RMS(D)" << std::endl;
+          << "RMS(D)"
+          << "\t"
+          << "DIIS" << std::endl;
     }
 
     LOG(1, "HartreeFockIt") << iter << "\t" << ehf << "\t" << energyDifference
-                            << "\t" << rmsd << "\t" << std::endl;
+                            << "\t" << rmsd << "\t" << diis.getErrorNorm()
+                            << "\t" << std::endl;
 
     EMIT() << YAML::BeginMap << YAML::Key << "iteration" << YAML::Value << iter
            << YAML::Key << "energy" << YAML::Value << YAML::BeginMap
            << YAML::Key << "value" << YAML::Value << ehf << YAML::EndMap
-           << YAML::EndMap;
+           << YAML::Key << "fock-rebuild" << YAML::Value << rebuild
+           << YAML::Key << "quartets" << YAML::Value << YAML::BeginMap
+           << YAML::Key << "computed" << YAML::Value << computed << YAML::Key
+           << "screened" << YAML::Value << screened << YAML::EndMap
+           << YAML::Key << "diis" << YAML::Value << YAML::BeginMap
+           << YAML::Key << "error-norm" << YAML::Value << diis.getErrorNorm()
+           << YAML::Key << "subspace-size" << YAML::Value
+           << diis.getSubspaceSize() << YAML::EndMap << YAML::EndMap;
 
   } while (((fabs(energyDifference) > electronicConvergence)
             || (fabs(rmsd) > electronicConvergence))
            && (iter < maxIterations));
 
   EMIT() << YAML::EndSeq;
+  EMIT() << YAML::Key << "iterations-count" << YAML::Value << iter
+         << YAML::Key << "diis-error-norm" << YAML::Value
+         << diis.getErrorNorm();
+  LOGGER(1) << "quartets computed: " << totalComputed
+            << ", screened: " << totalScreened << std::endl;
   for (unsigned int e; e < eps.size(); e++) {
     LOGGER(1) << "band " << e + 1 << " = " << eps(e, 0) << std::endl;
   }
@@ -9,7 +9,10 @@
 #include <math/ComplexTensor.hpp>
 #include <numeric>
 #include <util/Timer.hpp>
+#include <util/Emitter.hpp>
+#include <util/Exception.hpp>
 #include <algorithm>
+#include <mpi.h>
 
 using namespace sisi4s;
 
@@ -48,6 +51,9 @@ IrmlerTensor<F> readBinaryTensorSerial(std::string filename,
   f.open(filename, std::ios::in | std::ios::binary);
   if (!f) throw EXCEPTION("file not found");
   f.read((char *)&header, sizeof(header));
+  // the dense data are read directly
+  if (header.version > BinaryTensorHeaderBase::DENSE_VERSION)
+    throw EXCEPTION("serial reading requires binary tensor format version 1");
 
   if (talk) LOG(1, "SerialReader") << "order " << header.order << std::endl;
 
@@ -641,61 +647,75 @@ void ParenthesisTriples::getVpppijkFromVertex(const std::array<int64_t, 3> &ijk,
 }
 
 IJKPointer
-ParenthesisTriples::getVpppijkOnTheFly(const std::array<int64_t, 3> &ijk,
-                                       VectorTensor<double> &vtensor) {
-  // what do we need for ijk and its order
-  std::list<int64_t> intersection;
-  std::list<int64_t> difference;
-  std::map<int64_t, IrmlerTensor<double> *> tensorMap;
-
-  std::set_intersection(ijk.begin(),
-                        ijk.end(),
-                        vtensor.refs.begin(),
-                        vtensor.refs.end(),
-                        std::back_inserter(intersection));
-
-  std::set_difference(vtensor.refs.begin(),
-                      vtensor.refs.end(),
-                      intersection.begin(),
-                      intersection.end(),
-                      std::back_inserter(difference));
-
-  difference.unique();
-  // only delete the tensor if it is not needed anyways
-  // {006}->{011} have a difference of {06}
-  for (const auto &ref : difference) {
-    auto *p = std::find(ijk.begin(), ijk.end(), ref);
-    if (std::distance(ijk.begin(), p) == 3) {
-      delete vtensor.withReference(ref);
+ParenthesisTriples::getVpppijkOnTheFly(const std::array<int64_t, 3> &ijk) {
+  // release first, such that a cache of three slabs suffices
+  for (const auto s : acquiredSlabs) ppphCache->release(s);
+  acquiredSlabs.clear();
+  std::array<const double *, 3> slabs;
+  for (int n(0); n < 3; n++) {
+    const auto previous(std::find(ijk.begin(), ijk.begin() + n, ijk[n]));
+    if (previous != ijk.begin() + n) {
+      slabs[n] = slabs[previous - ijk.begin()];
+    } else {
+      slabs[n] = ppphCache->acquire(ijk[n]);
+      acquiredSlabs.push_back(ijk[n]);
     }
   }
+  // the slabs are only read by the contractions
+  return {const_cast<double *>(slabs[0]),
+          const_cast<double *>(slabs[1]),
+          const_cast<double *>(slabs[2])};
+}
 
-  for (const auto &ref : intersection) {
-    tensorMap[ref] = vtensor.withReference(ref);
-  }
+/**
+ * \brief Returns the offset in bytes of the data of a tensor in the binary
+ * format, i.e. the size of its headers.
+ */
+int64_t getBinaryTensorDataOffset(const std::string &filename) {
+  std::fstream f(filename, std::ios::in | std::ios::binary);
+  if (!f) throw EXCEPTION("file not found");
+  BinaryTensorHeader header;
+  f.read((char *)&header, sizeof(header));
+  if (header.version > BinaryTensorHeaderBase::DENSE_VERSION)
+    throw EXCEPTION("serial reading requires binary tensor format version 1");
+  return sizeof(header) + header.order * sizeof(BinaryTensorDimensionHeader);
+}
 
-  int64_t c = 0;
-  for (const auto &i : ijk) {
-    vtensor.refs[c] = i;
-    if (tensorMap[i] == nullptr) {
-      const int64_t offset = i * NvCube;
-      vtensor.tensors[c] =
-          new IrmlerTensor<double>(readBinaryTensorSerial<double>(
-              getTextArgument("PPPHCoulombIntegralsFile",
-                              "PPPHCoulombIntegrals.bin"),
-              offset,
-              NvCube,
-              false));
-      tensorMap[i] = vtensor.withReference(i);
-    } else {
-      vtensor.tensors[c] = tensorMap[i];
+/**
+ * \brief Estimated relative cost of a tuple. The contractions are the same
+ * for all tuples, but the energy of tuples with two equal indices needs
+ * only half of the permutations.
+ */
+inline double getTupleCost(const std::array<int64_t, 3> &ijk) {
+  return (ijk[0] == ijk[1] || ijk[1] == ijk[2]) ? 0.75 : 1.0;
+}
+
+/**
+ * \brief Splits the tuples into contiguous ranges of equal estimated cost,
+ * one per rank, and returns the range [first, last) of the given rank.
+ * Contiguous ranges keep consecutive tuples, sharing most of their
+ * indices, on the same rank.
+ */
+void getTupleRange(const std::vector<std::array<int64_t, 3>> &tuplesList,
+                   const int64_t rank,
+                   const int64_t np,
+                   int64_t &first,
+                   int64_t &last) {
+  double totalCost(0.0);
+  for (const auto &ijk : tuplesList) totalCost += getTupleCost(ijk);
+  const double begin(totalCost * rank / np), end(totalCost * (rank + 1) / np);
+  double cost(0.0);
+  first = last = tuplesList.size();
+  for (size_t t(0); t < tuplesList.size(); t++) {
+    // a tuple belongs to the rank whose cost range contains its start
+    if (cost >= begin && first == int64_t(tuplesList.size())) first = t;
+    if (cost >= end && rank + 1 < np) {
+      last = t;
+      break;
     }
-    c++;
+    cost += getTupleCost(tuplesList[t]);
   }
-
-  return {vtensor.tensors[0]->data.data(),
-          vtensor.tensors[1]->data.data(),
-          vtensor.tensors[2]->data.data()};
+  if (first > last) first = last;
 }
 
 void ParenthesisTriples::run() {
@@ -734,8 +754,6 @@ void ParenthesisTriples::run() {
 
   PTR(IrmlerTensor<double>) VppphT;
 
-  VectorTensor<double> vtensor;
-
   bool fullPPPH(false);
   bool PPPHOnTheFly(false);
   if (isArgumentGiven("readPPPH")) {
@@ -748,6 +766,20 @@ void ParenthesisTriples::run() {
     fullPPPH = true;
   } else if (isArgumentGiven("PPPHOnTheFly")) {
     PPPHOnTheFly = true;
+    // keep as many slabs as fit into the given memory, at least the three
+    // of a tuple
+    const std::string fileName(getTextArgument("PPPHCoulombIntegralsFile",
+                                               "PPPHCoulombIntegrals.bin"));
+    const double cacheBytes(
+        getRealArgument("PPPHCacheMemory", 4.0 * 1024 * 1024 * 1024));
+    const size_t capacity(
+        std::max<size_t>(3, cacheBytes / (NvCube * sizeof(double))));
+    LOG(0, "PPPHOnTheFly") << "caching " << capacity << " slabs" << std::endl;
+    ppphCache = NEW(SlabCache<double>,
+                    fileName,
+                    getBinaryTensorDataOffset(fileName),
+                    NvCube,
+                    capacity);
   } else {
     LOG(0, "Read and slice CoulombVertex") << std::endl;
     Tensor<complex> *GammaGqr(getTensorArgument<complex>("CoulombVertex"));
@@ -831,14 +863,44 @@ void ParenthesisTriples::run() {
   if (!fullPPPH && !PPPHOnTheFly) {
     Vpppijk = new double[3 * NvCube]; // stores the needed Vppph for given tuple
   }
+  // distribute the tuples among the ranks, either statically in contiguous
+  // ranges of equal estimated cost or dynamically in chunks of tuples
+  // taken from a shared counter
+  const std::string tupleDistribution(
+      getTextArgument("tupleDistribution", "static"));
+  const int64_t chunkSize(getIntegerArgument("tupleChunkSize", 16));
+  const int64_t rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  if (tupleDistribution != "static" && tupleDistribution != "dynamic") {
+    throw new EXCEPTION("Unknown tupleDistribution " + tupleDistribution
+                        + ", use static or dynamic");
+  }
+  LOG(0, "ParenthesisTriples")
+      << "tupleDistribution: " << tupleDistribution << std::endl;
+
   LOG(0, "START LOOP OVER") << u << " TUPLES " << std::endl;
   IJKPointer integralContainer;
   double VppphSeconds(0.0), doublesSeconds(0.0), permuteSeconds(0.0);
   double energySeconds(0.0), singlesSeconds(0.0);
-  for (int64_t i = 0; i < nTuples; i++) {
-    //  for (int64_t i = 0; i < 100; i++){
+  int64_t localTuples(0);
+  // tuples of the current range whose slabs are read ahead in the background
+  const int64_t prefetchTuples(getIntegerArgument("PPPHPrefetchTuples", 4));
+  int64_t prefetchEnd(0), prefetched(0);
+  const auto prefetchSlabs = [&](const int64_t i) {
+    std::vector<int64_t> slabs;
+    for (prefetched = std::max(prefetched, i + 1);
+         prefetched < std::min(i + 1 + prefetchTuples, prefetchEnd);
+         prefetched++) {
+      for (const auto s : tuplesList[prefetched]) {
+        if (std::find(slabs.begin(), slabs.end(), s) == slabs.end()) {
+          slabs.push_back(s);
+        }
+      }
+    }
+    if (slabs.size()) ppphCache->prefetch(slabs);
+  };
+  const auto computeTuple = [&](const int64_t i) {
     // just provide some stdout
-    if (i == messages.back()) {
+    if (!messages.empty() && i >= messages.back()) {
       LOG(1, "Finished") << i << " out of total " << nTuples << " tuples"
                          << std::endl;
       messages.pop_back();
@@ -859,23 +921,9 @@ void ParenthesisTriples::run() {
         integralContainer.i = &Vppph[ijk[0] * NvCube];
         integralContainer.j = &Vppph[ijk[1] * NvCube];
         integralContainer.k = &Vppph[ijk[2] * NvCube];
-        // #pragma omp parallel for
-        //  for(int64_t v(0); v<NvCube; v++){
-        //   Vpppijk = Vppph + ijk[0]*NvCube;
-        //   Vpppijk + NvCube = Vppph + ijk[1]*NvCube;
-        //   Vpppijk + NvCube + NvCube = Vppph + ijk[2]*NvCube;
-        //   Vpppijk[v]          = Vppph[v + ijk[0]*NvCube];
-        //   Vpppijk[v+NvCube]   = Vppph[v + ijk[1]*NvCube];
-        //   Vpppijk[v+2*NvCube] = Vppph[v + ijk[2]*NvCube];
-        // }
       } else if (PPPHOnTheFly) {
-        integralContainer = getVpppijkOnTheFly(ijk, vtensor);
-        // #pragma omp parallel for
-        //  for (int64_t v(0); v<NvCube; v++){
-        //   Vpppijk[v]          = integralContainer.i[v];
-        //   Vpppijk[v+NvCube]   = integralContainer.j[v];
-        //   Vpppijk[v+2*NvCube] = integralContainer.k[v];
-        // }
+        integralContainer = getVpppijkOnTheFly(ijk);
+        prefetchSlabs(i);
       } else {
         getVpppijkFromVertex(ijk, scratch, Vpppijk);
         integralContainer.i = Vpppijk;
@@ -910,12 +958,103 @@ void ParenthesisTriples::run() {
     }
     energySeconds += energyTime.getFractionalSeconds();
     energy += tupleEnergy;
+    localTuples++;
+  };
+
+  if (tupleDistribution == "static") {
+    int64_t first, last;
+    getTupleRange(tuplesList, rank, np, first, last);
+    prefetchEnd = last;
+    for (int64_t i = first; i < last; i++) computeTuple(i);
+  } else {
+    // the counter of the next chunk lives on rank 0
+    int64_t counter(0);
+    MPI_Win window;
+    MPI_Win_create(&counter,
+                   rank == 0 ? sizeof(counter) : 0,
+                   sizeof(counter),
+                   MPI_INFO_NULL,
+                   Sisi4s::world->comm,
+                   &window);
+    const auto nextChunk = [&]() {
+      int64_t first;
+      MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, window);
+      MPI_Fetch_and_op(&chunkSize,
+                       &first,
+                       MPI_INT64_T,
+                       0,
+                       0,
+                       MPI_SUM,
+                       window);
+      MPI_Win_unlock(0, window);
+      return first;
+    };
+    for (int64_t first(nextChunk()); first < nTuples; first = nextChunk()) {
+      const int64_t last(std::min(first + chunkSize, nTuples));
+      prefetchEnd = last;
+      for (int64_t i = first; i < last; i++) computeTuple(i);
+    }
+    MPI_Win_free(&window);
   }
+
+  // reduce the energy and gather the timings of all ranks
+  double localEnergy(energy);
+  MPI_Allreduce(&localEnergy,
+                &energy,
+                1,
+                MPI_DOUBLE,
+                MPI_SUM,
+                Sisi4s::world->comm);
+  const int timesCount(6);
+  double localTimes[timesCount] = {double(localTuples),
+                                   VppphSeconds,
+                                   doublesSeconds,
+                                   singlesSeconds,
+                                   energySeconds,
+                                   VppphSeconds + doublesSeconds
+                                       + singlesSeconds + energySeconds};
+  std::vector<double> rankTimes(timesCount * np);
+  MPI_Gather(localTimes,
+             timesCount,
+             MPI_DOUBLE,
+             rankTimes.data(),
+             timesCount,
+             MPI_DOUBLE,
+             0,
+             Sisi4s::world->comm);
+
   LOG(0, "LOOP FINISHED, energy") << energy << std::endl;
   LOG(0, "  Vppph Time") << VppphSeconds << std::endl;
   LOG(0, "doubles Time") << doublesSeconds << std::endl;
   LOG(0, "energy  Time") << energySeconds << std::endl;
   LOG(0, "singles Time") << singlesSeconds << std::endl;
+  EMIT() << YAML::Key << "tuple-distribution" << YAML::Value
+         << tupleDistribution;
+  EMIT() << YAML::Key << "rank-times" << YAML::Value << YAML::BeginSeq;
+  for (int64_t r(0); r < np; r++) {
+    const double *times(&rankTimes[r * timesCount]);
+    EMIT() << YAML::Flow << YAML::BeginMap << YAML::Key << "rank"
+           << YAML::Value << r << YAML::Key << "tuples" << YAML::Value
+           << int64_t(times[0]) << YAML::Key << "vppph" << YAML::Value
+           << times[1] << YAML::Key << "doubles" << YAML::Value << times[2]
+           << YAML::Key << "singles" << YAML::Value << times[3] << YAML::Key
+           << "energy" << YAML::Value << times[4] << YAML::Key << "total"
+           << YAML::Value << times[5] << YAML::EndMap;
+  }
+  EMIT() << YAML::EndSeq;
+  if (PPPHOnTheFly) {
+    for (const auto s : acquiredSlabs) ppphCache->release(s);
+    acquiredSlabs.clear();
+    LOG(0, "PPPHOnTheFly") << "slabs read: " << ppphCache->getReads()
+                           << ", cache hits: " << ppphCache->getHits()
+                           << std::endl;
+    EMIT() << YAML::Key << "ppph-cache" << YAML::Value << YAML::BeginMap
+           << YAML::Key << "capacity" << YAML::Value
+           << ppphCache->getCapacity() << YAML::Key << "reads" << YAML::Value
+           << ppphCache->getReads() << YAML::Key << "hits" << YAML::Value
+           << ppphCache->getHits() << YAML::EndMap;
+    ppphCache.reset();
+  }
   Scalar<double> ctfEnergy(*Sisi4s::world);
   ctfEnergy[""] = energy;
   // ctfEnergy.set_val(energy);  // ctfBug
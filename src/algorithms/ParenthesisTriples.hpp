@@ -2,6 +2,10 @@
 #define PARENTHESIS_TRIPLES
 
 #include <algorithms/Algorithm.hpp>
+#include <util/SlabCache.hpp>
+#include <util/SharedPointer.hpp>
+#include <array>
+#include <vector>
 
 namespace sisi4s {
 /**
@@ -23,22 +27,6 @@ struct IrmlerTensor {
       , data(data_) {}
 };
 
-template <typename F>
-struct VectorTensor {
-  static const int64_t NO_REF = -1;
-  std::array<IrmlerTensor<F> *, 3> tensors;
-  std::array<int64_t, 3> refs;
-  IrmlerTensor<F> *withReference(int64_t r) {
-    auto *p = std::find(refs.begin(), refs.end(), r);
-    //      if (p == refs.size()) {/* panic */}
-    const int64_t idx(std::distance(refs.begin(), p));
-    return tensors[idx];
-  }
-  VectorTensor()
-      : tensors({nullptr, nullptr, nullptr})
-      , refs({NO_REF, NO_REF, NO_REF}) {}
-};
-
 class ParenthesisTriples : public Algorithm {
 public:
   ALGORITHM_REGISTRAR_DECLARATION(ParenthesisTriples);
@@ -81,8 +69,16 @@ protected:
                             double *scratchO,
                             double *output);
 
-  IJKPointer getVpppijkOnTheFly(const std::array<int64_t, 3> &ijk,
-                                VectorTensor<double> &vtensor);
+  /**
+   * \brief Acquires the PPPH slabs of the given tuple from the cache,
+   * releasing the slabs of the previous tuple.
+   */
+  IJKPointer getVpppijkOnTheFly(const std::array<int64_t, 3> &ijk);
+
+  // PPPH slabs V[abc](i) read from file in PPPHOnTheFly mode
+  PTR(SlabCache<double>) ppphCache;
+  // slabs acquired for the current tuple
+  std::vector<int64_t> acquiredSlabs;
 };
 } // namespace sisi4s
 
@@ -5,6 +5,9 @@
 #include <util/Exception.hpp>
 #include <Sisi4s.hpp>
 #include <util/Tensor.hpp>
+#include <algorithm>
+#include <cmath>
+#include <string>
 
 using namespace sisi4s;
 
@@ -181,6 +184,12 @@ void PerturbativeTriples::run() {
   int No(epsi->lens[0]);
   int Nv(epsa->lens[0]);
 
+  const int batchSize(getBatchSize(No, Nv));
+  if (batchSize > 0) {
+    runBatched(batchSize);
+    return;
+  }
+
   int vvvooo[] = {Nv, Nv, Nv, No, No, No};
   int syms[] = {NS, NS, NS, NS, NS, NS};
   Tensor<double> SVabcijk(6, vvvooo, syms, *Vabij->wrld, "SVabcijk");
@@ -239,6 +248,169 @@ void PerturbativeTriples::run() {
   setRealArgument("PerturbativeTriplesEnergy", e);
 }
 
+// number of Nv^3*B^3 slabs held at the same time when batched:
+// D.V in all permutations of the batches, S.V and T
+static const int BATCH_SLABS_COUNT(8);
+
+int PerturbativeTriples::getBatchSize(const int No, const int Nv) {
+  int batchSize(getIntegerArgument("batchSize", 0));
+  if (batchSize == 0 && isArgumentGiven("batchMemory")) {
+    const double batchMemory(getRealArgument("batchMemory"));
+    const double slabBytes(BATCH_SLABS_COUNT * sizeof(double) * double(Nv)
+                           * Nv * Nv);
+    batchSize = std::max(1, int(std::cbrt(batchMemory / slabBytes)));
+  }
+  return std::min(batchSize, No);
+}
+
+PTR(Tensor<double>)
+PerturbativeTriples::getDoublesBatch(const std::array<int, 3> &batches,
+                                     const int batchSize) {
+  Tensor<double> *Vijka(getTensorArgument("HHHPCoulombIntegrals"));
+  Tensor<double> *Vabci(getTensorArgument("PPPHCoulombIntegrals"));
+  Tensor<double> *Tabij(getTensorArgument("CcsdDoublesAmplitudes"));
+  const int No(Tabij->lens[2]);
+  const int Nv(Tabij->lens[0]);
+  int start[3], end[3];
+  for (int n(0); n < 3; ++n) {
+    start[n] = batches[n] * batchSize;
+    end[n] = std::min(start[n] + batchSize, No);
+  }
+
+  int lens[] = {Nv,
+                Nv,
+                Nv,
+                end[0] - start[0],
+                end[1] - start[1],
+                end[2] - start[2]};
+  int syms[] = {NS, NS, NS, NS, NS, NS};
+  auto DVabcijk(NEW(Tensor<double>, 6, lens, syms, *Tabij->wrld, "DVabcijk"));
+
+  int TadijStart[] = {0, 0, start[0], start[1]};
+  int TadijEnd[] = {Nv, Nv, end[0], end[1]};
+  int VbcdkStart[] = {0, 0, 0, start[2]};
+  int VbcdkEnd[] = {Nv, Nv, Nv, end[2]};
+  (*DVabcijk)["abcijk"] = Vabci->slice(VbcdkStart, VbcdkEnd)["bcdk"]
+                        * Tabij->slice(TadijStart, TadijEnd)["adij"];
+
+  int VjklcStart[] = {start[1], start[2], 0, 0};
+  int VjklcEnd[] = {end[1], end[2], No, Nv};
+  int TabilStart[] = {0, 0, start[0], 0};
+  int TabilEnd[] = {Nv, Nv, end[0], No};
+  (*DVabcijk)["abcijk"] -= Vijka->slice(VjklcStart, VjklcEnd)["jklc"]
+                         * Tabij->slice(TabilStart, TabilEnd)["abil"];
+  return DVabcijk;
+}
+
+void PerturbativeTriples::runBatched(const int batchSize) {
+  Tensor<double> *epsi(getTensorArgument("HoleEigenEnergies"));
+  Tensor<double> *epsa(getTensorArgument("ParticleEigenEnergies"));
+  Tensor<double> *Vabij(getTensorArgument("PPHHCoulombIntegrals"));
+  Tensor<double> *Tai(getTensorArgument("CcsdSinglesAmplitudes"));
+
+  int No(epsi->lens[0]);
+  int Nv(epsa->lens[0]);
+  const int batchesCount((No + batchSize - 1) / batchSize);
+  LOG(1, "PerturbativeTriples")
+      << "batches of " << batchSize << " occupied indices, " << batchesCount
+      << " batches" << std::endl;
+
+  // the permutations of a,b,c together with i,j,k entering the energy
+  const std::string permutations[] =
+      {"abcijk", "bacjik", "acbikj", "cbakji", "cabkij", "bcajki"};
+  Bivar_Function<> fDivide(&divide<double>);
+  Scalar<> energy(*Sisi4s::world);
+  energy[""] = 0.0;
+
+  // go through all batches I<=J<=K and all their distinct permutations,
+  // reusing D.V of each permutation of the batches
+  for (int I(0); I < batchesCount; ++I) {
+    for (int J(I); J < batchesCount; ++J) {
+      for (int K(J); K < batchesCount; ++K) {
+        std::map<std::array<int, 3>, PTR(Tensor<double>)> DVabcijk;
+        const std::array<int, 3> IJK = {{I, J, K}};
+        for (const auto &s : permutations) {
+          std::array<int, 3> batches;
+          for (int n(0); n < 3; ++n) batches[n] = IJK[s[n + 3] - 'i'];
+          if (!DVabcijk.count(batches)) {
+            DVabcijk[batches] = getDoublesBatch(batches, batchSize);
+          }
+        }
+
+        for (const auto &DV : DVabcijk) {
+          const std::array<int, 3> &batches(DV.first);
+          int start[3], end[3];
+          for (int n(0); n < 3; ++n) {
+            start[n] = batches[n] * batchSize;
+            end[n] = std::min(start[n] + batchSize, No);
+          }
+          Tensor<double> &DVabc(*DV.second);
+          Tensor<double> SVabcijk(false, DVabc);
+          SVabcijk.set_name("SVabcijk");
+          int TaiStart[] = {0, start[0]};
+          int TaiEnd[] = {Nv, end[0]};
+          int VbcjkStart[] = {0, 0, start[1], start[2]};
+          int VbcjkEnd[] = {Nv, Nv, end[1], end[2]};
+          SVabcijk["abcijk"] = 0.5 * Tai->slice(TaiStart, TaiEnd)["ai"]
+                             * Vabij->slice(VbcjkStart, VbcjkEnd)["bcjk"];
+
+          Tensor<double> Tabcijk(false, DVabc);
+          Tabcijk.set_name("Tabcijk");
+          Tabcijk["abcijk"] = (+8.0) * DVabc["abcijk"];
+          Tabcijk["abcijk"] += (-4.0) * DVabc["acbijk"];
+          Tabcijk["abcijk"] += (-4.0) * DVabc["bacijk"];
+          Tabcijk["abcijk"] += (+2.0) * DVabc["bcaijk"];
+          Tabcijk["abcijk"] += (+2.0) * DVabc["cabijk"];
+          Tabcijk["abcijk"] += (-4.0) * DVabc["cbaijk"];
+
+          Tabcijk["abcijk"] += (+8.0) * SVabcijk["abcijk"];
+          Tabcijk["abcijk"] += (-4.0) * SVabcijk["acbijk"];
+          Tabcijk["abcijk"] += (-4.0) * SVabcijk["bacijk"];
+          Tabcijk["abcijk"] += (+2.0) * SVabcijk["bcaijk"];
+          Tabcijk["abcijk"] += (+2.0) * SVabcijk["cabijk"];
+          Tabcijk["abcijk"] += (-4.0) * SVabcijk["cbaijk"];
+
+          int epsiStart[3][1] = {{start[0]}, {start[1]}, {start[2]}};
+          int epsiEnd[3][1] = {{end[0]}, {end[1]}, {end[2]}};
+          SVabcijk["abcijk"] = epsi->slice(epsiStart[0], epsiEnd[0])["i"];
+          SVabcijk["abcijk"] += epsi->slice(epsiStart[1], epsiEnd[1])["j"];
+          SVabcijk["abcijk"] += epsi->slice(epsiStart[2], epsiEnd[2])["k"];
+          SVabcijk["abcijk"] -= (*epsa)["a"];
+          SVabcijk["abcijk"] -= (*epsa)["b"];
+          SVabcijk["abcijk"] -= (*epsa)["c"];
+          Tabcijk.contract(1.0,
+                           Tabcijk,
+                           "abcijk",
+                           SVabcijk,
+                           "abcijk",
+                           0.0,
+                           "abcijk",
+                           fDivide);
+
+          for (const auto &s : permutations) {
+            // D.V of the batches permuted along with i,j,k
+            std::array<int, 3> piBatches;
+            for (int n(0); n < 3; ++n) piBatches[n] = batches[s[n + 3] - 'i'];
+            energy[""] += (*DVabcijk[piBatches])[s.c_str()] * Tabcijk["abcijk"];
+          }
+        }
+        LOG(1, "PerturbativeTriples")
+            << "batches (" << I << "," << J << "," << K << ") done"
+            << std::endl;
+      }
+    }
+  }
+
+  double eTriples(energy.get_val());
+  double eCcsd(getRealArgument("CcsdEnergy"));
+  double e(eCcsd + eTriples);
+  LOG(0, "PerturbativeTriples") << "e=" << e << std::endl;
+  LOG(1, "PerturbativeTriples") << "ccsd=" << eCcsd << std::endl;
+  LOG(1, "PerturbativeTriples") << "triples=" << eTriples << std::endl;
+
+  setRealArgument("PerturbativeTriplesEnergy", e);
+}
+
 void PerturbativeTriples::dryRun() {
   getTensorArgument<double, DryTensor<double>>("PPHHCoulombIntegrals");
   getTensorArgument<double, DryTensor<double>>("HHHPCoulombIntegrals");
@@ -259,6 +431,21 @@ void PerturbativeTriples::dryRun() {
   int No(epsi->lens[0]);
   int Nv(epsa->lens[0]);
 
+  const int batchSize(getBatchSize(No, Nv));
+  if (batchSize > 0) {
+    LOG(1, "PerturbativeTriples")
+        << "batches of " << batchSize << " occupied indices" << std::endl;
+    // D.V in all permutations of the batches, S.V and T
+    int vvvbbb[] = {Nv, Nv, Nv, batchSize, batchSize, batchSize};
+    int syms[] = {NS, NS, NS, NS, NS, NS};
+    std::vector<PTR(DryTensor<>)> slabs;
+    for (int n(0); n < BATCH_SLABS_COUNT; ++n) {
+      slabs.push_back(NEW(DryTensor<>, 6, vvvbbb, syms, SOURCE_LOCATION));
+    }
+    DryScalar<> energy(SOURCE_LOCATION);
+    return;
+  }
+
   // Allocate the doubles amplitudes
   int vvvooo[] = {Nv, Nv, Nv, No, No, No};
   int syms[] = {NS, NS, NS, NS, NS, NS};
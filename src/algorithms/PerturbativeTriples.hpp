@@ -2,6 +2,9 @@
 #define PERTURBATIVE_TRIPLES_DEFINED
 
 #include <algorithms/Algorithm.hpp>
+#include <util/SharedPointer.hpp>
+#include <array>
+#include <map>
 
 namespace sisi4s {
 /**
@@ -33,6 +36,27 @@ public:
    * \brief Dry run for perturbative triples correction based on Piecuch paper.
    */
   virtual void dryRunPiecuch();
+
+protected:
+  /**
+   * \brief Calculates the perturbative triples correction in batches of
+   * occupied indices i,j,k, building only Nv^3*B^3 slabs of the
+   * Nv^3*No^3 intermediates for a batch size B.
+   */
+  void runBatched(const int batchSize);
+
+  /**
+   * \brief Returns the batch size B of occupied indices, given either
+   * directly by batchSize or derived from the memory budget batchMemory
+   * in bytes. Returns 0 if neither is given.
+   */
+  int getBatchSize(const int No, const int Nv);
+
+  /**
+   * \brief Calculates D.V for the occupied indices of the given batches.
+   */
+  PTR(Tensor<double>) getDoublesBatch(const std::array<int, 3> &batches,
+                                      const int batchSize);
 };
 } // namespace sisi4s
 
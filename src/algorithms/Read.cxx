@@ -5,6 +5,7 @@
 #include <algorithms/Read.hpp>
 #include <algorithms/TensorWriter.hpp>
 #include <util/Tensor.hpp>
+#include <util/TensorIo.hpp>
 #include <vendor/filesystem.hpp>
 
 namespace sisi4s {
@@ -22,6 +23,27 @@ static Tensor<F> *new_tensor_from_dimensions(cc4s::Dimensions const &dims) {
   return new Tensor<F>(dims.size(), syms.data(), lens.data(), *Sisi4s::world);
 }
 
+// elements written by Write are in the binary tensor format, of version
+// 1 or 2, others are dense data without header
+template <typename F>
+static Tensor<F> *read_binary_elements(std::string const &fileName,
+                                       cc4s::Dimensions const &dims) {
+  char magic[4] = {0};
+  std::ifstream(fileName.c_str(), std::ios::binary).read(magic, sizeof(magic));
+  if (std::strncmp(magic, BinaryTensorHeaderBase::MAGIC, sizeof(magic)) != 0) {
+    auto t = new_tensor_from_dimensions<F>(dims);
+    t->read_dense_from_file(fileName.c_str());
+    return t;
+  }
+  auto t = TensorIo::readBinary<F>(fileName);
+  bool matching(size_t(t->order) == dims.size());
+  for (size_t i = 0; matching && i < dims.size(); i++)
+    matching = size_t(t->lens[i]) == dims[i].length;
+  if (!matching)
+    throw new EXCEPTION("Dimensions of " + fileName + " differ from header");
+  return t;
+}
+
 IMPLEMENT_ALGORITHM(Read) {
 
   const std::string fileName = getTextArgument("fileName");
@@ -50,12 +72,13 @@ IMPLEMENT_ALGORITHM(Read) {
     LOG(0, "Read") << "Real64 tensor"
                    << "\n";
     using F = typename cc4s::ScalarTypeTraits<cc4s::ScalarType::Real64>::type;
-    auto t = new_tensor_from_dimensions<F>(header.dimensions);
+    Tensor<F> *t(nullptr);
 
     switch (header.elementsType) {
     case cc4s::ElementFileType::TextFile: {
       LOG(0, "Read") << "Text tensor"
                      << "\n";
+      t = new_tensor_from_dimensions<F>(header.dimensions);
       if (Sisi4s::world->rank == 0) {
         std::vector<F> values(count);
         size_t idx = 0;
@@ -77,7 +100,7 @@ IMPLEMENT_ALGORITHM(Read) {
     case cc4s::ElementFileType::IeeeBinaryFile:
       LOG(0, "Read") << "Binary tensor"
                      << "\n";
-      t->read_dense_from_file(dataPath.c_str());
+      t = read_binary_elements<F>(dataPath.string(), header.dimensions);
       break;
     }
 
@@ -89,8 +112,7 @@ IMPLEMENT_ALGORITHM(Read) {
                    << "\n";
     using F =
         typename cc4s::ScalarTypeTraits<cc4s::ScalarType::Complex64>::type;
-    auto t = new_tensor_from_dimensions<F>(header.dimensions);
-    t->read_dense_from_file(dataPath.c_str());
+    auto t = read_binary_elements<F>(dataPath.string(), header.dimensions);
     allocatedTensorArgument<F>("destination", t);
     break;
   }
@@ -18,6 +18,7 @@ he equations in this file are taken from the following sources
 #include <algorithms/SimilarityTransformedHamiltonian.hpp>
 #include <algorithms/StantonIntermediatesUCCSD.hpp>
 #include <math/ComplexTensor.hpp>
+#include <math/FockVectorBlock.hpp>
 #include <math/MathFunctions.hpp>
 #include <mixers/Mixer.hpp>
 #include <util/Exception.hpp>
@@ -67,11 +68,37 @@ SimilarityTransformedHamiltonian<F>::right_apply_CCSD_IP(SDFockVector<F> &R) {
                                           : right_apply_hirata_CCSD_IP(R);
 }
 
+template <typename F>
+std::vector<SDFockVector<F>>
+SimilarityTransformedHamiltonian<F>::right_apply_CCSD_IP(
+    std::vector<SDFockVector<F>> &Rs) {
+  if (!with_right_apply_intermediates()) {
+    std::vector<SDFockVector<F>> HRs;
+    for (auto &R : Rs) HRs.push_back(right_apply_hirata_CCSD_IP(R));
+    return HRs;
+  }
+  return unpackFockVectors(right_apply_Intermediates_CCSD_IP_Block(
+                               packFockVectors<F>(Rs.begin(), Rs.end())),
+                           Rs);
+}
+
 template <typename F>
 SDFockVector<F>
 SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_IP(
     SDFockVector<F> &R) {
   SDFockVector<F> HR(R);
+  unpackFockVector(
+      right_apply_Intermediates_CCSD_IP_Block(packFockVectors<F>(&R, &R + 1)),
+      0,
+      HR);
+  return HR;
+}
+
+template <typename F>
+FockVector<F>
+SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_IP_Block(
+    const FockVector<F> &R) {
+  FockVector<F> HR(R);
   PTR(Tensor<F>) Ri(R.get(0));
   PTR(Tensor<F>) Raij(R.get(1));
   PTR(Tensor<F>) HRi(HR.get(0));
@@ -88,22 +115,22 @@ SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_IP(
   Wiabj = getIABJ();
   Wijkl = getIJKL();
 
-  (*HRi)["i"] = 0.0;
-  (*HRi)["i"] += (-1.0) * (*Wij)["mi"] * (*Ri)["m"];
-  (*HRi)["i"] += (-1.0) * (*Wia)["mc"] * (*Raij)["cim"];
-  (*HRi)["i"] += (-0.5) * (*Wijka)["nmic"] * (*Raij)["cmn"];
+  (*HRi)["iZ"] = 0.0;
+  (*HRi)["iZ"] += (-1.0) * (*Wij)["mi"] * (*Ri)["mZ"];
+  (*HRi)["iZ"] += (-1.0) * (*Wia)["mc"] * (*Raij)["cimZ"];
+  (*HRi)["iZ"] += (-0.5) * (*Wijka)["nmic"] * (*Raij)["cmnZ"];
 
-  (*HRaij)["aij"] = 0.0;
-  (*HRaij)["aij"] += (-1.0) * (*Wiajk)["maji"] * (*Ri)["m"];
-  (*HRaij)["aij"] += (+1.0) * (*Wab)["ac"] * (*Raij)["cij"];
+  (*HRaij)["aijZ"] = 0.0;
+  (*HRaij)["aijZ"] += (-1.0) * (*Wiajk)["maji"] * (*Ri)["mZ"];
+  (*HRaij)["aijZ"] += (+1.0) * (*Wab)["ac"] * (*Raij)["cijZ"];
   // we have to antisymmetrize here
-  (*HRaij)["aij"] += (-1.0) * (*Wij)["mi"] * (*Raij)["amj"];
-  (*HRaij)["aij"] += (+1.0) * (*Wij)["mj"] * (*Raij)["ami"];
+  (*HRaij)["aijZ"] += (-1.0) * (*Wij)["mi"] * (*Raij)["amjZ"];
+  (*HRaij)["aijZ"] += (+1.0) * (*Wij)["mj"] * (*Raij)["amiZ"];
   // also antisymmetrize
-  (*HRaij)["aij"] += (+1.0) * (*Wiabj)["maci"] * (*Raij)["cmj"];
-  (*HRaij)["aij"] += (-1.0) * (*Wiabj)["macj"] * (*Raij)["cmi"];
+  (*HRaij)["aijZ"] += (+1.0) * (*Wiabj)["maci"] * (*Raij)["cmjZ"];
+  (*HRaij)["aijZ"] += (-1.0) * (*Wiabj)["macj"] * (*Raij)["cmiZ"];
 
-  (*HRaij)["aij"] += (+0.5) * (*Wijkl)["mnij"] * (*Raij)["amn"];
+  (*HRaij)["aijZ"] += (+0.5) * (*Wijkl)["mnij"] * (*Raij)["amnZ"];
 
   // three body term
   // WHHPHPH = Wijakbl := Vijbc * Tcakl (page 354 Shavitt 10.88)
@@ -114,8 +141,8 @@ SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_IP(
   //(*Raij)["cmn"];
   // Change order for preformance
   // TODO: Really review this little puppy
-  (*HRaij)["aij"] +=
-      (-0.5) * (*Tabij)["eaji"] * (*Vijab)["mnce"] * (*Raij)["cmn"];
+  (*HRaij)["aijZ"] +=
+      (-0.5) * (*Tabij)["eaji"] * (*Vijab)["mnce"] * (*Raij)["cmnZ"];
 
   return HR;
 }
@@ -293,11 +320,37 @@ SimilarityTransformedHamiltonian<F>::right_apply_CCSD_EA(SDFockVector<F> &R) {
                                           : right_apply_hirata_CCSD_EA(R);
 }
 
+template <typename F>
+std::vector<SDFockVector<F>>
+SimilarityTransformedHamiltonian<F>::right_apply_CCSD_EA(
+    std::vector<SDFockVector<F>> &Rs) {
+  if (!with_right_apply_intermediates()) {
+    std::vector<SDFockVector<F>> HRs;
+    for (auto &R : Rs) HRs.push_back(right_apply_hirata_CCSD_EA(R));
+    return HRs;
+  }
+  return unpackFockVectors(right_apply_Intermediates_CCSD_EA_Block(
+                               packFockVectors<F>(Rs.begin(), Rs.end())),
+                           Rs);
+}
+
 template <typename F>
 SDFockVector<F>
 SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_EA(
     SDFockVector<F> &R) {
   SDFockVector<F> HR(R);
+  unpackFockVector(
+      right_apply_Intermediates_CCSD_EA_Block(packFockVectors<F>(&R, &R + 1)),
+      0,
+      HR);
+  return HR;
+}
+
+template <typename F>
+FockVector<F>
+SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_EA_Block(
+    const FockVector<F> &R) {
+  FockVector<F> HR(R);
   PTR(Tensor<F>) Ra(R.get(0));
   PTR(Tensor<F>) Rabi(R.get(1));
   PTR(Tensor<F>) HRa(HR.get(0));
@@ -315,26 +368,26 @@ SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_CCSD_EA(
   Wij = getIJ();
   Wabci = getABCI();
 
-  (*HRa)["a"] = 0.0;
-  (*HRa)["a"] += (+1.0) * (*Wab)["ae"] * (*Ra)["e"];
-  (*HRa)["a"] += (+1.0) * (*Wia)["me"] * (*Rabi)["eam"];
-  (*HRa)["a"] += (+0.5) * (*Waibc)["amde"] * (*Rabi)["edm"];
+  (*HRa)["aZ"] = 0.0;
+  (*HRa)["aZ"] += (+1.0) * (*Wab)["ae"] * (*Ra)["eZ"];
+  (*HRa)["aZ"] += (+1.0) * (*Wia)["me"] * (*Rabi)["eamZ"];
+  (*HRa)["aZ"] += (+0.5) * (*Waibc)["amde"] * (*Rabi)["edmZ"];
 
-  (*HRabi)["abi"] = 0.0;
-  (*HRabi)["abi"] += (+1.0) * (*Wabci)["baei"] * (*Ra)["e"];
+  (*HRabi)["abiZ"] = 0.0;
+  (*HRabi)["abiZ"] += (+1.0) * (*Wabci)["baei"] * (*Ra)["eZ"];
   // we have to antisymmetrize here
-  (*HRabi)["abi"] += (+1.0) * (*Wab)["ae"] * (*Rabi)["ebi"];
-  (*HRabi)["abi"] += (-1.0) * (*Wab)["be"] * (*Rabi)["eai"];
-  (*HRabi)["abi"] += (-1.0) * (*Wij)["mi"] * (*Rabi)["abm"];
+  (*HRabi)["abiZ"] += (+1.0) * (*Wab)["ae"] * (*Rabi)["ebiZ"];
+  (*HRabi)["abiZ"] += (-1.0) * (*Wab)["be"] * (*Rabi)["eaiZ"];
+  (*HRabi)["abiZ"] += (-1.0) * (*Wij)["mi"] * (*Rabi)["abmZ"];
   // also antisymmetrize
-  (*HRabi)["abi"] += (+1.0) * (*Wiabj)["maei"] * (*Rabi)["ebm"];
-  (*HRabi)["abi"] += (-1.0) * (*Wiabj)["mbei"] * (*Rabi)["eam"];
+  (*HRabi)["abiZ"] += (+1.0) * (*Wiabj)["maei"] * (*Rabi)["ebmZ"];
+  (*HRabi)["abiZ"] += (-1.0) * (*Wiabj)["mbei"] * (*Rabi)["eamZ"];
 
-  (*HRabi)["abi"] += (+0.5) * (*Wabcd)["abef"] * (*Rabi)["efi"];
+  (*HRabi)["abiZ"] += (+0.5) * (*Wabcd)["abef"] * (*Rabi)["efiZ"];
 
   // WPHPPPH = Waibcdj
-  (*HRabi)["abi"] +=
-      (-0.5) * (*Tabij)["abin"] * (*Vijab)["mnef"] * (*Rabi)["efm"];
+  (*HRabi)["abiZ"] +=
+      (-0.5) * (*Tabij)["abin"] * (*Vijab)["mnef"] * (*Rabi)["efmZ"];
 
   return HR;
 }
@@ -1011,10 +1064,33 @@ SimilarityTransformedHamiltonian<F>::right_apply_hirata(SDFockVector<F> &R) {
   return HR;
 }
 
+template <typename F>
+std::vector<SDFockVector<F>> SimilarityTransformedHamiltonian<F>::right_apply(
+    std::vector<SDFockVector<F>> &Rs) {
+  if (!with_right_apply_intermediates()) {
+    std::vector<SDFockVector<F>> HRs;
+    for (auto &R : Rs) HRs.push_back(right_apply_hirata(R));
+    return HRs;
+  }
+  return unpackFockVectors(
+      right_apply_Intermediates_Block(packFockVectors<F>(Rs.begin(), Rs.end())),
+      Rs);
+}
+
 template <typename F>
 SDFockVector<F> SimilarityTransformedHamiltonian<F>::right_apply_Intermediates(
     SDFockVector<F> &R) {
   SDFockVector<F> HR(R);
+  unpackFockVector(
+      right_apply_Intermediates_Block(packFockVectors<F>(&R, &R + 1)), 0, HR);
+  return HR;
+}
+
+template <typename F>
+FockVector<F>
+SimilarityTransformedHamiltonian<F>::right_apply_Intermediates_Block(
+    const FockVector<F> &R) {
+  FockVector<F> HR(R);
   // get pointers to the component tensors
   PTR(Tensor<F>) Rai(R.get(0));
   PTR(Tensor<F>) Rabij(R.get(1));
@@ -1034,83 +1110,83 @@ SDFockVector<F> SimilarityTransformedHamiltonian<F>::right_apply_Intermediates(
   Wijka = getIJKA();
   Wijkl = getIJKL();
 
-  (*HRai)["ai"] = 0.0;
-  (*HRai)["ai"] += (-1.0) * (*Wij)["li"] * (*Rai)["al"];
-  (*HRai)["ai"] += (*Wab)["ad"] * (*Rai)["di"];
-  (*HRai)["ai"] += (*Wiabj)["ladi"] * (*Rai)["dl"];
+  (*HRai)["aiZ"] = 0.0;
+  (*HRai)["aiZ"] += (-1.0) * (*Wij)["li"] * (*Rai)["alZ"];
+  (*HRai)["aiZ"] += (*Wab)["ad"] * (*Rai)["diZ"];
+  (*HRai)["aiZ"] += (*Wiabj)["ladi"] * (*Rai)["dlZ"];
 
-  (*HRai)["ai"] += (*Wia)["ld"] * (*Rabij)["adil"];
+  (*HRai)["aiZ"] += (*Wia)["ld"] * (*Rabij)["adilZ"];
 
-  (*HRai)["ai"] += (-0.5) * (*Wijka)["lmid"] * (*Rabij)["adlm"];
-  (*HRai)["ai"] += (0.5) * (*Waibc)["alde"] * (*Rabij)["deil"];
+  (*HRai)["aiZ"] += (-0.5) * (*Wijka)["lmid"] * (*Rabij)["adlmZ"];
+  (*HRai)["aiZ"] += (0.5) * (*Waibc)["alde"] * (*Rabij)["deilZ"];
 
   // ST_DEBUG("singles done")
 
   //(*HRai)["ai"]  = 0.0; //!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
   // 2 body part
-  (*HRabij)["abij"] = 0.0;
+  (*HRabij)["abijZ"] = 0.0;
 
   // WABCD ===================================================================
-  (*HRabij)["abij"] += (0.5) * (*Wabcd)["abde"] * (*Rabij)["deij"];
+  (*HRabij)["abijZ"] += (0.5) * (*Wabcd)["abde"] * (*Rabij)["deijZ"];
 
   // WIJKL ===================================================================
-  (*HRabij)["abij"] += (0.5) * (*Wijkl)["lmij"] * (*Rabij)["ablm"];
+  (*HRabij)["abijZ"] += (0.5) * (*Wijkl)["lmij"] * (*Rabij)["ablmZ"];
 
   // WAB   ===================================================================
-  (*HRabij)["abij"] += (+1.0) * (*Wab)["bd"] * (*Rabij)["adij"];
+  (*HRabij)["abijZ"] += (+1.0) * (*Wab)["bd"] * (*Rabij)["adijZ"];
   // P(ab)
-  (*HRabij)["abij"] += (-1.0) * (*Wab)["ad"] * (*Rabij)["bdij"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wab)["ad"] * (*Rabij)["bdijZ"];
 
   // WIJ   ===================================================================
-  (*HRabij)["abij"] += (-1.0) * (*Wij)["lj"] * (*Rabij)["abil"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wij)["lj"] * (*Rabij)["abilZ"];
   // P(ij)
-  (*HRabij)["abij"] += (*Wij)["li"] * (*Rabij)["abjl"];
+  (*HRabij)["abijZ"] += (*Wij)["li"] * (*Rabij)["abjlZ"];
 
   // WIABJ ===================================================================
-  (*HRabij)["abij"] += (*Wiabj)["lbdj"] * (*Rabij)["adil"];
+  (*HRabij)["abijZ"] += (*Wiabj)["lbdj"] * (*Rabij)["adilZ"];
   //-P(ij)
-  (*HRabij)["abij"] += (-1.0) * (*Wiabj)["lbdi"] * (*Rabij)["adjl"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wiabj)["lbdi"] * (*Rabij)["adjlZ"];
   //-P(ab)
-  (*HRabij)["abij"] += (-1.0) * (*Wiabj)["ladj"] * (*Rabij)["bdil"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wiabj)["ladj"] * (*Rabij)["bdilZ"];
   // P(ij)P(ab)
-  (*HRabij)["abij"] += (*Wiabj)["ladi"] * (*Rabij)["bdjl"];
+  (*HRabij)["abijZ"] += (*Wiabj)["ladi"] * (*Rabij)["bdjlZ"];
 
   // THREE_BODY_ONE ===========================================================
-  (*HRabij)["abij"] += (*Tabij)["afij"] * (*Rai)["em"] * (*Waibc)["bmfe"];
+  (*HRabij)["abijZ"] += (*Tabij)["afij"] * (*Rai)["emZ"] * (*Waibc)["bmfe"];
   // P(ab)
-  (*HRabij)["abij"] +=
-      (-1.0) * (*Tabij)["bfij"] * (*Rai)["em"] * (*Waibc)["amfe"];
+  (*HRabij)["abijZ"] +=
+      (-1.0) * (*Tabij)["bfij"] * (*Rai)["emZ"] * (*Waibc)["amfe"];
 
   // THREE_BODY_TWO ===========================================================
-  (*HRabij)["abij"] +=
-      (-0.5) * (*Tabij)["fbij"] * (*Rabij)["eamn"] * (*Vijab)["nmfe"];
+  (*HRabij)["abijZ"] +=
+      (-0.5) * (*Tabij)["fbij"] * (*Rabij)["eamnZ"] * (*Vijab)["nmfe"];
   // P(ab)
-  (*HRabij)["abij"] +=
-      (+0.5) * (*Tabij)["faij"] * (*Rabij)["ebmn"] * (*Vijab)["nmfe"];
+  (*HRabij)["abijZ"] +=
+      (+0.5) * (*Tabij)["faij"] * (*Rabij)["ebmnZ"] * (*Vijab)["nmfe"];
 
   // THREE_BODY_THREE =========================================================
-  (*HRabij)["abij"] +=
-      (-1.0) * (*Tabij)["abin"] * (*Rai)["em"] * (*Wijka)["nmje"];
+  (*HRabij)["abijZ"] +=
+      (-1.0) * (*Tabij)["abin"] * (*Rai)["emZ"] * (*Wijka)["nmje"];
   // P(ij)
-  (*HRabij)["abij"] +=
-      (+1.0) * (*Tabij)["abjn"] * (*Rai)["em"] * (*Wijka)["nmie"];
+  (*HRabij)["abijZ"] +=
+      (+1.0) * (*Tabij)["abjn"] * (*Rai)["emZ"] * (*Wijka)["nmie"];
 
   // THREE_BODY_FOUR ==========================================================
-  (*HRabij)["abij"] +=
-      (+0.5) * (*Tabij)["abjn"] * (*Vijab)["nmfe"] * (*Rabij)["feim"];
+  (*HRabij)["abijZ"] +=
+      (+0.5) * (*Tabij)["abjn"] * (*Vijab)["nmfe"] * (*Rabij)["feimZ"];
   // P(ij)
-  (*HRabij)["abij"] +=
-      (-0.5) * (*Tabij)["abin"] * (*Vijab)["nmfe"] * (*Rabij)["fejm"];
+  (*HRabij)["abijZ"] +=
+      (-0.5) * (*Tabij)["abin"] * (*Vijab)["nmfe"] * (*Rabij)["fejmZ"];
 
   // WIAJK ===================================================================
-  (*HRabij)["abij"] += (-1.0) * (*Wiajk)["lbij"] * (*Rai)["al"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wiajk)["lbij"] * (*Rai)["alZ"];
   // P(ab)
-  (*HRabij)["abij"] += (+1.0) * (*Wiajk)["laij"] * (*Rai)["bl"];
+  (*HRabij)["abijZ"] += (+1.0) * (*Wiajk)["laij"] * (*Rai)["blZ"];
 
   // WABCI ===================================================================
-  (*HRabij)["abij"] += (*Wabci)["abej"] * (*Rai)["ei"];
+  (*HRabij)["abijZ"] += (*Wabci)["abej"] * (*Rai)["eiZ"];
   // P(ij)
-  (*HRabij)["abij"] += (-1.0) * (*Wabci)["abei"] * (*Rai)["ej"];
+  (*HRabij)["abijZ"] += (-1.0) * (*Wabci)["abei"] * (*Rai)["ejZ"];
 
   // ST_DEBUG("doubles done")
 
@@ -64,6 +64,10 @@ public:
   SDFockVector<F> leftApplyIntermediates(SDFockVector<F> &v);
   SDFockVector<F> leftApply(SDFockVector<F> &v);
 
+  // blocks of ccsd fock vectors, packed along an additional mode Z
+  std::vector<SDFockVector<F>> right_apply(std::vector<SDFockVector<F>> &v);
+  FockVector<F> right_apply_Intermediates_Block(const FockVector<F> &v);
+
   // ccsdt fok vectors
   SDTFockVector<F> right_apply_hirata(SDTFockVector<F> &v);
   SDTFockVector<F> right_apply(SDTFockVector<F> &v);
@@ -77,6 +81,14 @@ public:
   SDFockVector<F> right_apply_hirata_CCSD_EA(SDFockVector<F> &);
   SDFockVector<F> right_apply_Intermediates_CCSD_EA(SDFockVector<F> &);
 
+  std::vector<SDFockVector<F>>
+  right_apply_CCSD_IP(std::vector<SDFockVector<F>> &);
+  FockVector<F> right_apply_Intermediates_CCSD_IP_Block(const FockVector<F> &);
+
+  std::vector<SDFockVector<F>>
+  right_apply_CCSD_EA(std::vector<SDFockVector<F>> &);
+  FockVector<F> right_apply_Intermediates_CCSD_EA_Block(const FockVector<F> &);
+
   // Structure factor
   struct StructureFactor {
     double energy;
@@ -7,6 +7,7 @@
 #include <Sisi4s.hpp>
 #include <util/Tensor.hpp>
 #include <util/Emitter.hpp>
+#include <util/RangeParser.hpp>
 #include <algorithms/TensorReader.hpp>
 
 namespace sisi4s {
@@ -18,13 +19,33 @@ read(Algorithm &alg, const std::string mode, const std::string &name) {
   if (mode == "binary") {
     std::string fileName(alg.getTextArgument("file", name + ".bin"));
     EMIT() << YAML::Key << "file" << YAML::Value << fileName;
-    A = TensorIo::readBinary<F>(fileName);
+    if (alg.isArgumentGiven("sliceBegin") || alg.isArgumentGiven("sliceEnd")) {
+      // read only the slice given by comma separated begins and ends,
+      // the latter exclusive, of each dimension
+      std::string sliceBegin(alg.getTextArgument("sliceBegin")),
+          sliceEnd(alg.getTextArgument("sliceEnd"));
+      EMIT() << YAML::Key << "slice-begin" << YAML::Value << sliceBegin
+             << YAML::Key << "slice-end" << YAML::Value << sliceEnd;
+      std::vector<int> begins(RangeParser(sliceBegin).getRange()),
+          ends(RangeParser(sliceEnd).getRange());
+      A = TensorIo::readBinary<F>(
+          fileName,
+          std::vector<int64_t>(begins.begin(), begins.end()),
+          std::vector<int64_t>(ends.begin(), ends.end()));
+    } else {
+      A = TensorIo::readBinary<F>(fileName);
+    }
   } else {
+    if (alg.isArgumentGiven("sliceBegin") || alg.isArgumentGiven("sliceEnd")) {
+      throw new EXCEPTION("Slices can only be read in binary mode");
+    }
     std::string fileName(alg.getTextArgument("file", name + ".dat").c_str());
     std::string delimiter(alg.getTextArgument("delimiter", " "));
     int64_t bufferSize(
         alg.getIntegerArgument("bufferSize", 128l * 1024 * 1024));
-    A = TensorIo::readText<F>(fileName, delimiter, bufferSize);
+    // the file is only accessible by the root, e.g. on its local disk
+    bool localOnly(alg.getIntegerArgument("localOnly", 0) == 1);
+    A = TensorIo::readText<F>(fileName, delimiter, bufferSize, localOnly);
     EMIT() << YAML::Key << "file" << YAML::Value << fileName;
   }
   A->set_name(name.c_str());
@@ -29,6 +29,13 @@ IMPLEMENT_ALGORITHM(TensorWriter) {
       rowIndexOrder(getTextArgument("rowIndexOrder", "")),
       columnIndexOrder(getTextArgument("columnIndexOrder", "")),
       delimiter(getTextArgument("delimiter", " "));
+  // version and chunk encoding of the binary format
+  const int32_t binaryVersion(
+      BinaryTensorHeaderBase::getVersion(getIntegerArgument("version", 1)));
+  const int32_t binaryFilters(
+      BinaryTensorCodec::getFilters(getTextArgument("compression", "none")));
+  const int64_t elementsPerChunk(
+      getIntegerArgument("elementsPerChunk", 1024 * 1024));
 
   if (typeid(double) == TensorWriter::check_type(getArgumentData("Data"))) {
     LOG(1, "TensorWriter") << "Writing real tensor" << std::endl;
@@ -38,7 +45,10 @@ IMPLEMENT_ALGORITHM(TensorWriter) {
                                  binary_p,
                                  rowIndexOrder,
                                  columnIndexOrder,
-                                 delimiter);
+                                 delimiter,
+                                 binaryVersion,
+                                 binaryFilters,
+                                 elementsPerChunk);
   } else {
     LOG(1, "TensorWriter") << "Writing complex tensor" << std::endl;
     TensorWriter::write<sisi4s::complex>(
@@ -48,7 +58,10 @@ IMPLEMENT_ALGORITHM(TensorWriter) {
         binary_p,
         rowIndexOrder,
         columnIndexOrder,
-        delimiter);
+        delimiter,
+        binaryVersion,
+        binaryFilters,
+        elementsPerChunk);
   }
 }
 
@@ -59,12 +72,19 @@ void TensorWriter::write(const std::string &name,
                          const bool binary_p,
                          const std::string rowIndexOrder,
                          const std::string columnIndexOrder,
-                         const std::string delimiter) {
+                         const std::string delimiter,
+                         const int32_t binaryVersion,
+                         const int32_t binaryFilters,
+                         const int64_t elementsPerChunk) {
 
   A->set_name(name.c_str());
   EMIT() << YAML::Key << "Data" << YAML::Value << name;
   if (binary_p) {
-    TensorIo::writeBinary<F>(fileName, *A);
+    TensorIo::writeBinary<F>(fileName,
+                             *A,
+                             binaryVersion,
+                             binaryFilters,
+                             elementsPerChunk);
     EMIT() << YAML::Key << "file" << YAML::Value << fileName;
   } else {
     TensorIo::writeText<F>(fileName,
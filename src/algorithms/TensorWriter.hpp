@@ -2,6 +2,7 @@
 #define TENSOR_WRITER_DEFINED
 
 #include <algorithms/Algorithm.hpp>
+#include <util/BinaryTensorFormat.hpp>
 
 namespace sisi4s {
 
@@ -15,7 +16,11 @@ DEFINE_ALGORITHM_HEADER(
                       const bool binary_p,
                       const std::string rowIndexOrder,
                       const std::string columnIndexOrder,
-                      const std::string delimiter);
+                      const std::string delimiter,
+                      const int32_t binaryVersion =
+                          BinaryTensorHeaderBase::VERSION,
+                      const int32_t binaryFilters = BinaryTensorCodec::NONE,
+                      const int64_t elementsPerChunk = 1024 * 1024);
 
     static const std::type_info &check_type(Data *tensor_data);
 
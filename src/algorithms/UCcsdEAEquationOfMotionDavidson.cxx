@@ -45,6 +45,10 @@ void UCcsdEAEquationOfMotionDavidson::run() {
   // Arguments
   bool refreshOnMaxBasisSize(getIntegerArgument("refreshOnMaxBasisSize", 0)
                              == 1);
+  unsigned int blockSize(getIntegerArgument("blockSize", 1));
+  unsigned int refreshBasisSize(getIntegerArgument("refreshBasisSize", 0));
+  double subspaceMemory(getRealArgument("subspaceMemory", 0.0));
+  std::string subspaceDirectory(getTextArgument("subspaceDirectory", "."));
   std::vector<int> oneBodyRdmIndices(
       RangeParser(getTextArgument("oneBodyRdmRange", "")).getRange());
   int eigenStates(getIntegerArgument("eigenstates", 1));
@@ -82,6 +86,11 @@ void UCcsdEAEquationOfMotionDavidson::run() {
   LOG(0, "EAEomDavid") << "No: " << No << std::endl;
   LOG(0, "EAEomDavid") << "Nv: " << Nv << std::endl;
   LOG(0, "EAEomDavid") << "maxBasisSize: " << maxBasisSize << std::endl;
+  LOG(0, "EAEomDavid") << "blockSize: " << blockSize << std::endl;
+  if (subspaceMemory > 0.0) {
+    LOG(0, "EAEomDavid") << "subspaceMemory: " << subspaceMemory << " GB in "
+                         << subspaceDirectory << std::endl;
+  }
 
   // EA integrals: Vabcd Vabic Viabc Viajb Vijab Vijka
   // EA integrals for intermediates: Vabci Vaibj Vijak
@@ -296,6 +305,9 @@ void UCcsdEAEquationOfMotionDavidson::run() {
     SDFockVector<F> right_apply(SDFockVector<F> &V) {
       return h->right_apply_CCSD_EA(V);
     }
+    std::vector<SDFockVector<F>> right_apply(std::vector<SDFockVector<F>> &V) {
+      return h->right_apply_CCSD_EA(V);
+    }
   } eaH;
   eaH.h = &H;
 
@@ -320,6 +332,10 @@ void UCcsdEAEquationOfMotionDavidson::run() {
                   maxIterations,
                   minIterations);
   eigenSystem.refreshOnMaxBasisSize(refreshOnMaxBasisSize);
+  eigenSystem.blockSize(blockSize);
+  eigenSystem.refreshBasisSize(refreshBasisSize);
+  eigenSystem.subspaceMemory(subspaceMemory * 1024.0 * 1024.0 * 1024.0,
+                             subspaceDirectory);
   if (eigenSystem.refreshOnMaxBasisSize()) {
     LOG(0, "EAEomDavid") << "Refreshing on max basis size reaching"
                          << std::endl;
@@ -46,6 +46,10 @@ void UCcsdIPEquationOfMotionDavidson::run() {
   // Arguments
   bool refreshOnMaxBasisSize(getIntegerArgument("refreshOnMaxBasisSize", 0)
                              == 1);
+  unsigned int blockSize(getIntegerArgument("blockSize", 1));
+  unsigned int refreshBasisSize(getIntegerArgument("refreshBasisSize", 0));
+  double subspaceMemory(getRealArgument("subspaceMemory", 0.0));
+  std::string subspaceDirectory(getTextArgument("subspaceDirectory", "."));
   std::vector<int> oneBodyRdmIndices(
       RangeParser(getTextArgument("oneBodyRdmRange", "")).getRange());
   int eigenStates(getIntegerArgument("eigenstates", 1));
@@ -83,6 +87,11 @@ void UCcsdIPEquationOfMotionDavidson::run() {
   LOG(0, "IPEomDavid") << "No: " << No << std::endl;
   LOG(0, "IPEomDavid") << "Nv: " << Nv << std::endl;
   LOG(0, "IPEomDavid") << "maxBasisSize: " << maxBasisSize << std::endl;
+  LOG(0, "IPEomDavid") << "blockSize: " << blockSize << std::endl;
+  if (subspaceMemory > 0.0) {
+    LOG(0, "IPEomDavid") << "subspaceMemory: " << subspaceMemory << " GB in "
+                         << subspaceDirectory << std::endl;
+  }
 
   // Get copy of couloumb integrals
 
@@ -154,6 +163,9 @@ void UCcsdIPEquationOfMotionDavidson::run() {
     SDFockVector<F> right_apply(SDFockVector<F> &V) {
       return h->right_apply_CCSD_IP(V);
     }
+    std::vector<SDFockVector<F>> right_apply(std::vector<SDFockVector<F>> &V) {
+      return h->right_apply_CCSD_IP(V);
+    }
   } ipH;
   ipH.h = &H;
 
@@ -177,6 +189,10 @@ void UCcsdIPEquationOfMotionDavidson::run() {
                   maxIterations,
                   minIterations);
   eigenSystem.refreshOnMaxBasisSize(refreshOnMaxBasisSize);
+  eigenSystem.blockSize(blockSize);
+  eigenSystem.refreshBasisSize(refreshBasisSize);
+  eigenSystem.subspaceMemory(subspaceMemory * 1024.0 * 1024.0 * 1024.0,
+                             subspaceDirectory);
   if (eigenSystem.refreshOnMaxBasisSize()) {
     LOG(0, "IPEomDavid") << "Refreshing on max basis size reaching"
                          << std::endl;
@@ -55,6 +55,46 @@ void dsysv_(const char *uplo,
             sisi4s::Float64 *work,
             const int *lwork,
             const int *info);
+void dsysvx_(const char *fact,
+             const char *uplo,
+             const int *n,
+             const int *nrhs,
+             const sisi4s::Float64 *a,
+             const int *lda,
+             sisi4s::Float64 *af,
+             const int *ldaf,
+             int *ipiv,
+             const sisi4s::Float64 *b,
+             const int *ldb,
+             sisi4s::Float64 *x,
+             const int *ldx,
+             sisi4s::Float64 *rcond,
+             sisi4s::Float64 *ferr,
+             sisi4s::Float64 *berr,
+             sisi4s::Float64 *work,
+             const int *lwork,
+             int *iwork,
+             int *info);
+void zhesvx_(const char *fact,
+             const char *uplo,
+             const int *n,
+             const int *nrhs,
+             const sisi4s::Complex64 *a,
+             const int *lda,
+             sisi4s::Complex64 *af,
+             const int *ldaf,
+             int *ipiv,
+             const sisi4s::Complex64 *b,
+             const int *ldb,
+             sisi4s::Complex64 *x,
+             const int *ldx,
+             sisi4s::Float64 *rcond,
+             sisi4s::Float64 *ferr,
+             sisi4s::Float64 *berr,
+             sisi4s::Complex64 *work,
+             const int *lwork,
+             sisi4s::Float64 *rwork,
+             int *info);
 void dgetrf_(const int *m,
              const int *n,
              sisi4s::Float64 *a,
@@ -81,21 +121,19 @@ void zgetri_(const int *n,
              sisi4s::Complex64 *work,
              const int *workSize,
              int *info);
-// void dgemm_(
-//   const char *transa,
-//   const char *transb,
-//   const int *m,
-//   const int *n,
-//   const int *k,
-//   double *alpha,
-//   const double *A,
-//   const int *lda,
-//   const double *B,
-//   const int *ldb,
-//   double *beta,
-//   double *C,
-//   const int *ldc
-// );
+void dgemm_(const char *transa,
+            const char *transb,
+            const int *m,
+            const int *n,
+            const int *k,
+            const double *alpha,
+            const double *A,
+            const int *lda,
+            const double *B,
+            const int *ldb,
+            const double *beta,
+            double *C,
+            const int *ldc);
 void dger_(const int *M,
            const int *N,
            const double *alpha,
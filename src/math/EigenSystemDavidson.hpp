@@ -5,14 +5,40 @@
 #  include <util/LapackGeneralEigenSystem.hpp>
 #  include <math/MathFunctions.hpp>
 #  include <math/Complex.hpp>
+#  include <math/FockVectorBlock.hpp>
+#  include <math/FockVectorStore.hpp>
+#  include <Sisi4s.hpp>
 
 #  include <vector>
 #  include <iomanip>
 #  include <utility>
 #  include <algorithm>
+#  include <cmath>
 #  include <memory>
+#  include <string>
 
 namespace sisi4s {
+
+/**
+ * \brief Applies h to all given vectors at once, if h offers the method
+ * std::vector<V> right_apply(std::vector<V> &v);
+ **/
+template <typename H, typename V>
+auto rightApplyBlock(H *h, std::vector<V> &v, int)
+    -> decltype(h->right_apply(v)) {
+  return h->right_apply(v);
+}
+
+/**
+ * \brief Applies h to each of the given vectors, otherwise.
+ **/
+template <typename H, typename V>
+std::vector<V> rightApplyBlock(H *h, std::vector<V> &v, long) {
+  std::vector<V> result;
+  for (auto &vk : v) result.push_back(h->right_apply(vk));
+  return result;
+}
+
 template <typename H, typename P, typename V>
 class EigenSystemDavidson {
 public:
@@ -23,6 +49,7 @@ public:
    * \param[in] h object representing the matrix whose eigen system is sought
    * offering the following method:
    * V right_apply(V &v);
+   * and optionally its block version, see blockSize.
    * Also, if the dual version of the Davidson algorithm is to be used
    * h should offer the leftApply method
    * V leftApply(V &v);
@@ -92,6 +119,56 @@ public:
    */
   bool refreshOnMaxBasisSize() { return refreshOnMaxBasisSizeValue; }
 
+  /**
+   * \brief Sets the number of vectors h is applied to at once. If h offers
+   * the method
+   * std::vector<V> right_apply(std::vector<V> &v);
+   * blocks of up to this many vectors are passed to it, otherwise h is
+   * applied to the vectors of a block one by one. The reduced matrix
+   * elements are computed by one contraction per pair of blocks.
+   * \param[in] value The block size, 1 by default.
+   */
+  void blockSize(const unsigned int value) {
+    blockSizeValue = std::max(value, 1u);
+  }
+
+  /**
+   * \brief Returns the number of vectors h is applied to at once.
+   */
+  unsigned int blockSize() { return blockSizeValue; }
+
+  /**
+   * \brief Sets the number of Ritz vectors kept when the basis is
+   * refreshed, together with the vectors h applied to them.
+   * \param[in] value The number of Ritz vectors, by default and at least
+   * the number of sought eigenvectors.
+   */
+  void refreshBasisSize(const unsigned int value) {
+    refreshBasisSizeValue = value;
+  }
+
+  /**
+   * \brief Returns the number of Ritz vectors kept on refreshing.
+   */
+  unsigned int refreshBasisSize() {
+    return std::max<unsigned int>(refreshBasisSizeValue,
+                                  this->eigenVectorsCount);
+  }
+
+  /**
+   * \brief Limits the memory of the basis vectors and the vectors h
+   * applied to them on each process. Only the most recent vectors are
+   * kept in memory, each process writes its part of the older ones to
+   * the given directory and reads them back when needed.
+   * \param[in] bytes The memory budget per process in bytes, 0 for no
+   * limit.
+   * \param[in] directory The scratch directory.
+   */
+  void subspaceMemory(const double bytes, const std::string &directory) {
+    subspaceMemoryValue = bytes;
+    subspaceDirectory = directory;
+  }
+
 protected:
   H *h;
   int eigenVectorsCount;
@@ -105,6 +182,10 @@ protected:
   unsigned int minIterations = 1;
   std::vector<int> refreshIterations = std::vector<int>{{}};
   bool refreshOnMaxBasisSizeValue = false;
+  unsigned int blockSizeValue = 1;
+  unsigned int refreshBasisSizeValue = 0;
+  double subspaceMemoryValue = 0.0;
+  std::string subspaceDirectory = ".";
   std::vector<complex> eigenValues;
   std::vector<V> rightEigenVectors;
   std::vector<V> leftEigenVectors;
@@ -143,9 +224,28 @@ public:
       this->rightEigenVectors.assign(initialBasis.begin(), initialBasis.end());
     }
     LOG(1, "Davidson") << "Initial basis retrieved" << std::endl;
-    std::vector<V> rightBasis(this->rightEigenVectors);
-    std::vector<V> leftEigenVectors(this->rightEigenVectors);
+    // the basis and the vectors h applied to each basis vector,
+    // called sigma vectors, which are only known for the basis vectors
+    // of the previous iterations
+    FockVectorStore<V> rightBasis("davidson-basis"),
+        sigmaBasis("davidson-sigma");
+    if (this->subspaceMemoryValue > 0.0) {
+      // the share of a vector stored by each process
+      const double vectorBytes(this->rightEigenVectors[0].get_dimension()
+                               * sizeof(F) / double(Sisi4s::world->np));
+      const size_t maxResident(std::max(
+          1.0,
+          std::floor(this->subspaceMemoryValue / (2.0 * vectorBytes))));
+      rightBasis.setMaxResident(maxResident, this->subspaceDirectory);
+      sigmaBasis.setMaxResident(maxResident, this->subspaceDirectory);
+      LOG(1, "Davidson") << "keeping at most " << maxResident
+                         << " basis and sigma vectors in memory" << std::endl;
+    }
+    for (auto &v : this->rightEigenVectors) rightBasis.push_back(v);
+    // <basis|H|basis> for the basis vectors with known sigma vectors
     std::vector<complex> previousReducedMatrixElements;
+    // the coefficients of the Ritz vectors kept on refreshing
+    std::vector<F> ritzCoefficients;
 
     // begin convergence loop
     double rms;
@@ -177,7 +277,7 @@ public:
       overlapFile += std::to_string(iterationCount);
       for (unsigned int i(0); i < rightBasis.size(); i++) {
         for (unsigned int j(0); j < rightBasis.size(); j++) {
-          complex overlap(rightBasis[i].dot(rightBasis[j]));
+          complex overlap(rightBasis.get(i)->dot(*rightBasis.get(j)));
           FILE(overlapFile) << overlap << " ";
         }
         FILE(overlapFile) << std::endl;
@@ -185,33 +285,18 @@ public:
 #  endif
 
       // Check if a refreshment should be done
-      if (std::find(this->refreshIterations.begin(),
-                    this->refreshIterations.end(),
-                    iterationCount + 1)
-              != this->refreshIterations.end()
-          || (this->refreshOnMaxBasisSize()
-              && rightBasis.size() >= this->maxBasisSize)) {
+      if ((std::find(this->refreshIterations.begin(),
+                     this->refreshIterations.end(),
+                     iterationCount + 1)
+               != this->refreshIterations.end()
+           || (this->refreshOnMaxBasisSize()
+               && rightBasis.size() >= this->maxBasisSize))
+          && !ritzCoefficients.empty()) {
         LOG(1, "Davidson") << "Refreshing current basis!" << std::endl;
-        rightBasis.resize(this->eigenVectorsCount);
-        this->eigenValues.resize(this->eigenVectorsCount);
-        for (unsigned int i(0); i < rightBasis.size(); i++) {
-          rightBasis[i] *= F(0);
-          rightBasis[i] += this->rightEigenVectors[i];
-        }
-
-        LOG(1, "Davidson") << "Orthonormalizing the refreshed basis"
-                           << std::endl;
-        for (unsigned int i(0); i < rightBasis.size(); i++) {
-          for (unsigned int j(0); j < i; j++) {
-            rightBasis[i] -= rightBasis[j] * rightBasis[j].dot(rightBasis[i]);
-          }
-          F refreshedVectorNorm(std::sqrt(rightBasis[i].dot(rightBasis[i])));
-          // TODO: Check if refreshedVectorNorm is 0
-          rightBasis[i] *= 1.0 / refreshedVectorNorm;
-        }
-
-        // handling the caching of the reduced matrix
-        previousReducedMatrixElements.resize(0);
+        refresh(rightBasis,
+                sigmaBasis,
+                previousReducedMatrixElements,
+                ritzCoefficients);
 
 #  ifdef DEBUGG
         LOG(1, "Davidson") << "Writing out overlap matrix" << std::endl;
@@ -219,7 +304,7 @@ public:
         refreshOverlapFile += std::to_string(iterationCount);
         for (unsigned int i(0); i < rightBasis.size(); i++) {
           for (unsigned int j(0); j < rightBasis.size(); j++) {
-            complex roverlap(rightBasis[i].dot(rightBasis[j]));
+            complex roverlap(rightBasis.get(i)->dot(*rightBasis.get(j)));
             FILE(refreshOverlapFile) << roverlap << " ";
           }
           FILE(refreshOverlapFile) << std::endl;
@@ -227,10 +312,10 @@ public:
 #  endif
       }
 
-      unsigned int previousBasisSize(
-          std::sqrt(previousReducedMatrixElements.size()));
+      const unsigned int previousBasisSize(sigmaBasis.size()),
+          basisSize(rightBasis.size()), blockSize(this->blockSize());
       // compute reduced H by projection onto subspace spanned by rightBasis
-      LapackMatrix<complex> reducedH(rightBasis.size(), rightBasis.size());
+      LapackMatrix<complex> reducedH(basisSize, basisSize);
 
       for (unsigned int j(0); j < previousBasisSize; ++j) {
         for (unsigned int i(0); i < previousBasisSize; ++i) {
@@ -239,49 +324,44 @@ public:
         }
       }
 
-      auto previousReducedMatrixElementsCopy(previousReducedMatrixElements);
-      previousReducedMatrixElements.resize(rightBasis.size()
-                                           * rightBasis.size());
-
-      for (unsigned int j(0); j < previousReducedMatrixElements.size(); ++j) {
-        previousReducedMatrixElements[j] = complex(0);
-      }
-
-      for (unsigned int j(0); j < previousBasisSize; ++j) {
-        for (unsigned int i(0); i < previousBasisSize; ++i) {
-          previousReducedMatrixElements[i + rightBasis.size() * j] =
-              previousReducedMatrixElementsCopy[i + previousBasisSize * j];
+      // apply H only to the new basis vectors, a block at once
+      for (unsigned int j0(previousBasisSize); j0 < basisSize;
+           j0 += blockSize) {
+        const unsigned int j1(std::min(j0 + blockSize, basisSize));
+        std::vector<V> block;
+        for (unsigned int j(j0); j < j1; ++j) {
+          block.push_back(*rightBasis.get(j));
         }
-      }
-
-      // LOG(1,"Davidson") << "Computing <basis|H|new>" << std::endl;
-      for (unsigned int j(0); j < rightBasis.size(); ++j) {
-        // LOG(1,"Davidson") << "Computing " << j << std::endl;
-        V HBj(this->h->right_apply(rightBasis[j]));
-        for (unsigned int i(previousBasisSize); i < rightBasis.size(); ++i) {
-          // LOG(1,"Davidson") << i << "," << j << std::endl;
-          reducedH(i, j) = rightBasis[i].dot(HBj);
-          previousReducedMatrixElements[i + rightBasis.size() * j] =
-              reducedH(i, j);
+        for (auto &sigma : rightApplyBlock(this->h, block, 0)) {
+          sigmaBasis.push_back(sigma);
         }
       }
 
-      if (previousBasisSize > 0) {
-        // LOG(1,"Davidson") << "Computing <new|H|basis>" << std::endl;
-        for (unsigned int j(previousBasisSize); j < rightBasis.size(); ++j) {
-          V HBj(this->h->right_apply(rightBasis[j]));
-          for (unsigned int i(0); i < rightBasis.size(); ++i) {
-            // LOG(1,"Davidson") << "Creating " << i << "," << j << std::endl;
-            reducedH(i, j) = rightBasis[i].dot(HBj);
-            previousReducedMatrixElements[i + rightBasis.size() * j] =
-                reducedH(i, j);
-          }
+      // compute <new|H|basis> and <old|H|new>
+      project(rightBasis,
+              previousBasisSize,
+              basisSize,
+              sigmaBasis,
+              0,
+              basisSize,
+              reducedH);
+      project(rightBasis,
+              0,
+              previousBasisSize,
+              sigmaBasis,
+              previousBasisSize,
+              basisSize,
+              reducedH);
+
+      previousReducedMatrixElements.resize(basisSize * basisSize);
+      for (unsigned int j(0); j < basisSize; ++j) {
+        for (unsigned int i(0); i < basisSize; ++i) {
+          previousReducedMatrixElements[i + basisSize * j] = reducedH(i, j);
         }
       }
 
       // compute K lowest reduced eigenvalues and vectors of reduced H
-      LapackMatrix<complex> reducedEigenVectors(rightBasis.size(),
-                                                rightBasis.size());
+      LapackMatrix<complex> reducedEigenVectors(basisSize, basisSize);
       LapackGeneralEigenSystem<complex> reducedEigenSystem(reducedH,
                                                            true,
                                                            true);
@@ -320,35 +400,46 @@ public:
       }
 #  endif
 
-      // begin rightBasis extension loop for each k
-      rms = 0.0;
-      energyDifference = 0.0;
+      // keep the coefficients of the Ritz vectors for refreshing
+      const unsigned int ritzCount(
+          std::min(this->refreshBasisSize(), basisSize));
+      ritzCoefficients.resize(basisSize * ritzCount);
+      for (unsigned int k(0); k < ritzCount; ++k) {
+        for (unsigned int b(0); b < basisSize; ++b) {
+          ritzCoefficients[b + basisSize * k] = Conversion<F, complex>::from(
+              reducedEigenSystem.getRightEigenVectors()(b, k));
+        }
+      }
+
+      // compute the estimated eigenvectors and H applied to them by
+      // expansion in rightBasis and sigmaBasis, retrieving each once
       for (unsigned int k(0); k < this->eigenValues.size(); ++k) {
         // get estimated eigenvalue
         this->eigenValues[k] = reducedEigenSystem.getEigenValues()[k];
-
-        // compute estimated eigenvector by expansion in rightBasis
         this->rightEigenVectors[k] *= F(0);
-        for (int b(0); b < reducedH.getColumns(); ++b) {
-          // complex c(
-          // reducedEigenSystem.getRightEigenVectors()(b,k)
-          //);
-          // this->rightEigenVectors[k] += c * rightBasis[b];
-          this->rightEigenVectors[k] +=
-              rightBasis[b]
-              * Conversion<F, complex>::from(
-                  reducedEigenSystem.getRightEigenVectors()(b, k));
+      }
+      std::vector<V> HEigenVectors(this->rightEigenVectors);
+      for (unsigned int b(0); b < basisSize; ++b) {
+        const PTR(const V) Bb(rightBasis.get(b)), HBb(sigmaBasis.get(b));
+        for (unsigned int k(0); k < this->eigenValues.size(); ++k) {
+          const F c(Conversion<F, complex>::from(
+              reducedEigenSystem.getRightEigenVectors()(b, k)));
+          this->rightEigenVectors[k] += *Bb * c;
+          HEigenVectors[k] += *HBb * c;
         }
+      }
 
-        leftEigenVectors[k] *= F(0);
+#  ifdef DEBUGG
+      for (unsigned int k(0); k < this->eigenValues.size(); ++k) {
+        V leftEigenVector(this->rightEigenVectors[k]);
+        leftEigenVector *= F(0);
         for (int b(0); b < reducedH.getColumns(); ++b) {
-          leftEigenVectors[k] +=
-              rightBasis[b]
+          leftEigenVector +=
+              *rightBasis.get(b)
               * Conversion<F, complex>::from(
                   reducedEigenSystem.getLeftEigenVectors()(b, k));
         }
 
-#  ifdef DEBUGG
         complex lapackNorm(0);
         complex lapackNormConjLR(0);
         complex lapackNormConjRR(0);
@@ -362,16 +453,26 @@ public:
           lapackNorm += reducedEigenSystem.getLeftEigenVectors()(c, k)
                       * reducedEigenSystem.getRightEigenVectors()(c, k);
         }
-#  endif
 
         const F rightNorm(std::sqrt(
             this->rightEigenVectors[k].dot(this->rightEigenVectors[k])));
 
         const F leftRightNorm(
-            std::sqrt(leftEigenVectors[k].dot(this->rightEigenVectors[k])));
+            std::sqrt(leftEigenVector.dot(this->rightEigenVectors[k])));
+
+        OUT() << "                       " << rightNorm << " " << leftRightNorm
+              << " " << lapackNorm << " " << lapackNormConjLR << " "
+              << lapackNormConjRR << " " << std::endl;
+      }
+#  endif
 
+      // begin rightBasis extension loop for each k
+      rms = 0.0;
+      energyDifference = 0.0;
+      std::vector<V> corrections;
+      for (unsigned int k(0); k < this->eigenValues.size(); ++k) {
         // compute residuum
-        V residuum(this->h->right_apply(this->rightEigenVectors[k]));
+        V &residuum(HEigenVectors[k]);
         const double kNorm = std::real(
             this->rightEigenVectors[k].dot(this->rightEigenVectors[k]));
         residuum -= this->rightEigenVectors[k]
@@ -379,31 +480,37 @@ public:
         rms += std::real(residuum.dot(residuum)) / kNorm;
 
         // compute correction using preconditioner
-        V correction(this->p->getCorrection(this->eigenValues[k], residuum));
+        corrections.push_back(
+            this->p->getCorrection(this->eigenValues[k], residuum));
 
-        // orthonormalize and append to rightBasis
-        for (unsigned int b(0); b < rightBasis.size(); ++b) {
-          correction -= rightBasis[b] * rightBasis[b].dot(correction);
-        }
-        const F correction_norm(std::sqrt(correction.dot(correction)));
         energyDifference +=
             std::abs(previousEigenvalues[k] - this->eigenValues[k]);
 
         LOG(0, "DavidsonIt")
-            << iterationCount + 1 << " " << k + 1 << " " << rightBasis.size()
-            << " " << std::setprecision(15) << std::setw(23)
+            << iterationCount + 1 << " " << k + 1 << " " << basisSize << " "
+            << std::setprecision(15) << std::setw(23)
             << this->eigenValues[k].real() << " " << this->eigenValues[k].imag()
             << " " <<
             // rightNorm                   << " "           <<
             rms << " " << energyDifference / this->eigenVectorsCount << " "
             << std::endl;
-
-#  ifdef DEBUGG
-        OUT() << "                       " << rightNorm << " " << leftRightNorm
-              << " " << lapackNorm << " " << lapackNormConjLR << " "
-              << lapackNormConjRR << " " << std::endl;
-#  endif
-
+      }
+      HEigenVectors.clear();
+
+      // orthonormalize and append to rightBasis, retrieving each
+      // previous basis vector once for all corrections
+      for (unsigned int b(0); b < basisSize; ++b) {
+        const PTR(const V) Bb(rightBasis.get(b));
+        for (auto &correction : corrections) {
+          correction -= *Bb * Bb->dot(correction);
+        }
+      }
+      for (auto &correction : corrections) {
+        for (unsigned int b(basisSize); b < rightBasis.size(); ++b) {
+          const PTR(const V) Bb(rightBasis.get(b));
+          correction -= *Bb * Bb->dot(correction);
+        }
+        const F correction_norm(std::sqrt(correction.dot(correction)));
         if (std::abs(correction_norm) < 1E-6) continue;
         correction *= 1.0 / correction_norm;
         rightBasis.push_back(correction);
@@ -426,6 +533,158 @@ public:
                      && iterationCount + 1 <= this->maxIterations)));
     // end convergence loop
   }
+
+protected:
+  /**
+   * \brief Sets M(i,j) to <bras(i)|kets(j)> for i in [iBegin,iEnd) and
+   * j in [jBegin,jEnd). The vectors of the longer range are retrieved
+   * once, those of the shorter range once per block of the longer one.
+   * For a block size larger than one, the matrix elements of a pair of
+   * blocks are computed by one contraction per component.
+   */
+  void project(FockVectorStore<V> &bras,
+               const unsigned int iBegin,
+               const unsigned int iEnd,
+               FockVectorStore<V> &kets,
+               const unsigned int jBegin,
+               const unsigned int jEnd,
+               LapackMatrix<complex> &M) {
+    const unsigned int blockSize(this->blockSize());
+    const bool brasOuter(iEnd - iBegin >= jEnd - jBegin);
+    FockVectorStore<V> &outerStore(brasOuter ? bras : kets),
+        &innerStore(brasOuter ? kets : bras);
+    const unsigned int outerBegin(brasOuter ? iBegin : jBegin),
+        outerEnd(brasOuter ? iEnd : jEnd),
+        innerBegin(brasOuter ? jBegin : iBegin),
+        innerEnd(brasOuter ? jEnd : iEnd);
+    for (unsigned int o0(outerBegin); o0 < outerEnd; o0 += blockSize) {
+      const unsigned int o1(std::min(o0 + blockSize, outerEnd));
+      std::vector<PTR(const V)> outer;
+      for (unsigned int o(o0); o < o1; ++o) outer.push_back(outerStore.get(o));
+      FockVector<F> outerPacked;
+      if (blockSize > 1) {
+        outerPacked = packFockVectors<F>(outer.begin(), outer.end());
+      }
+      for (unsigned int n0(innerBegin); n0 < innerEnd; n0 += blockSize) {
+        const unsigned int n1(std::min(n0 + blockSize, innerEnd));
+        std::vector<PTR(const V)> inner;
+        for (unsigned int n(n0); n < n1; ++n) {
+          inner.push_back(innerStore.get(n));
+        }
+        const unsigned int i0(brasOuter ? o0 : n0), i1(brasOuter ? o1 : n1),
+            j0(brasOuter ? n0 : o0), j1(brasOuter ? n1 : o1);
+        if (blockSize == 1) {
+          M(i0, j0) = brasOuter ? outer[0]->dot(*inner[0])
+                                : inner[0]->dot(*outer[0]);
+          continue;
+        }
+        FockVector<F> innerPacked(
+            packFockVectors<F>(inner.begin(), inner.end()));
+        const std::vector<F> overlaps(
+            brasOuter ? getFockVectorBlockOverlaps(outerPacked, innerPacked)
+                      : getFockVectorBlockOverlaps(innerPacked, outerPacked));
+        for (unsigned int j(j0); j < j1; ++j) {
+          for (unsigned int i(i0); i < i1; ++i) {
+            M(i, j) = overlaps[(i - i0) + (i1 - i0) * (j - j0)];
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief Replaces the basis by the orthonormalized Ritz vectors of
+   * the given coefficients together with the subsequently appended basis
+   * vectors. The sigma vectors and the reduced matrix elements of the
+   * Ritz vectors are formed from the previous ones without applying H,
+   * since the previous basis is orthonormal. The Ritz vectors are formed
+   * one at a time in new stores, keeping the vectors in memory within
+   * the limit of the given stores.
+   */
+  void refresh(FockVectorStore<V> &rightBasis,
+               FockVectorStore<V> &sigmaBasis,
+               std::vector<complex> &reducedMatrixElements,
+               const std::vector<F> &ritzCoefficients) {
+    const unsigned int n(sigmaBasis.size()),
+        ritzCount(ritzCoefficients.size() / n);
+    // Gram-Schmidt orthonormalization of the coefficients, which is
+    // that of the Ritz vectors, dropping linearly dependent ones
+    std::vector<std::vector<F>> C;
+    for (unsigned int k(0); k < ritzCount; ++k) {
+      std::vector<F> c(ritzCoefficients.begin() + n * k,
+                       ritzCoefficients.begin() + n * (k + 1));
+      for (auto &d : C) {
+        F overlap(0);
+        for (unsigned int b(0); b < n; ++b) {
+          overlap += sisi4s::conj(d[b]) * c[b];
+        }
+        for (unsigned int b(0); b < n; ++b) c[b] -= overlap * d[b];
+      }
+      double norm(0);
+      for (unsigned int b(0); b < n; ++b) norm += std::norm(c[b]);
+      norm = std::sqrt(norm);
+      if (norm < 1E-6) continue;
+      for (unsigned int b(0); b < n; ++b) c[b] /= norm;
+      C.push_back(c);
+    }
+    LOG(1, "Davidson") << "Keeping " << C.size() << " Ritz vectors"
+                       << std::endl;
+
+    // form one Ritz vector and its sigma vector at a time in new stores,
+    // whose vectors in memory, together with those of the previous
+    // stores, are within the memory budget
+    const size_t maxResident(rightBasis.getMaxResident());
+    FockVectorStore<V> ritzBasis("davidson-basis"),
+        ritzSigmaBasis("davidson-sigma");
+    if (maxResident > 0) {
+      const size_t resident(rightBasis.size() - rightBasis.getSpilledCount());
+      const size_t available(maxResident - std::min(maxResident, resident));
+      ritzBasis.setMaxResident(std::max<size_t>(1, available),
+                               rightBasis.getDirectory());
+      ritzSigmaBasis.setMaxResident(std::max<size_t>(1, available),
+                                    sigmaBasis.getDirectory());
+    }
+    for (unsigned int k(0); k < C.size(); ++k) {
+      V ritzVector(*rightBasis.get(0)), ritzSigma(*sigmaBasis.get(0));
+      ritzVector *= C[k][0];
+      ritzSigma *= C[k][0];
+      for (unsigned int b(1); b < n; ++b) {
+        ritzVector += *rightBasis.get(b) * C[k][b];
+        ritzSigma += *sigmaBasis.get(b) * C[k][b];
+      }
+      ritzBasis.push_back(ritzVector);
+      ritzSigmaBasis.push_back(ritzSigma);
+    }
+    // the basis vectors appended since are orthogonal to the Ritz vectors
+    for (unsigned int b(n); b < rightBasis.size(); ++b) {
+      ritzBasis.push_back(*rightBasis.get(b));
+    }
+    // the previous vectors are removed with the swapped stores
+    rightBasis.swap(ritzBasis);
+    sigmaBasis.swap(ritzSigmaBasis);
+    if (maxResident > 0) {
+      rightBasis.setMaxResident(maxResident, rightBasis.getDirectory());
+      sigmaBasis.setMaxResident(maxResident, sigmaBasis.getDirectory());
+    }
+
+    // reduced matrix C^H <basis|H|basis> C of the Ritz vectors
+    std::vector<complex> ritzElements(C.size() * C.size());
+    for (unsigned int j(0); j < C.size(); ++j) {
+      std::vector<complex> Hc(n, complex(0));
+      for (unsigned int b(0); b < n; ++b) {
+        for (unsigned int a(0); a < n; ++a) {
+          Hc[a] += reducedMatrixElements[a + n * b] * complex(C[j][b]);
+        }
+      }
+      for (unsigned int i(0); i < C.size(); ++i) {
+        for (unsigned int a(0); a < n; ++a) {
+          ritzElements[i + C.size() * j] +=
+              complex(sisi4s::conj(C[i][a])) * Hc[a];
+        }
+      }
+    }
+    reducedMatrixElements = ritzElements;
+  }
 };
 
 } // namespace sisi4s
@@ -0,0 +1,164 @@
+#ifndef FOCK_VECTOR_BLOCK_DEFINED
+#define FOCK_VECTOR_BLOCK_DEFINED
+
+#include <math/FockVector.hpp>
+#include <math/MathFunctions.hpp>
+#include <util/SharedPointer.hpp>
+#include <util/Tensor.hpp>
+
+#include <cstdlib>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace sisi4s {
+
+template <typename V>
+const V &dereferenceFockVector(const V &v) {
+  return v;
+}
+
+template <typename V>
+const V &dereferenceFockVector(const PTR(V) &v) {
+  return *v;
+}
+
+/**
+ * \brief Packs the Fock vectors in the range [begin,end) into a single
+ * Fock vector, whose components have an additional last mode running
+ * over the vectors of the block. This mode is indexed by Z, which is not
+ * used by the component indices of any Fock vector, such that an operator
+ * can act on all vectors of the block with one contraction per term.
+ * The iterators may also refer to shared pointers to Fock vectors.
+ **/
+template <typename F, typename Iterator>
+FockVector<F> packFockVectors(Iterator begin, Iterator end) {
+  const int count(std::distance(begin, end));
+  std::vector<PTR(Tensor<F>)> tensors;
+  std::vector<std::string> indices;
+  std::vector<int64_t> componentSizes;
+  const FockVector<F> &first(dereferenceFockVector(*begin));
+  for (size_t i(0); i < first.get_components_count(); ++i) {
+    const PTR(Tensor<F>) &component(first.get(i));
+    std::vector<int> lens(component->lens, component->lens + component->order);
+    std::vector<int> syms(component->sym, component->sym + component->order);
+    int64_t componentSize(1);
+    for (auto len : lens) componentSize *= len;
+    componentSizes.push_back(componentSize);
+    lens.push_back(count);
+    syms.push_back(NS);
+    tensors.push_back(
+        NEW(Tensor<F>,
+            lens.size(),
+            lens.data(),
+            syms.data(),
+            *component->wrld,
+            (std::string(component->get_name()) + "Block").c_str()));
+    indices.push_back(first.get_indices(i) + "Z");
+  }
+
+  int64_t k(0);
+  for (Iterator v(begin); v != end; ++v, ++k) {
+    for (size_t i(0); i < tensors.size(); ++i) {
+      int64_t valuesCount;
+      int64_t *valueIndices;
+      F *values;
+      dereferenceFockVector(*v).get(i)->read_local(&valuesCount,
+                                                   &valueIndices,
+                                                   &values);
+      for (int64_t n(0); n < valuesCount; ++n) {
+        valueIndices[n] += k * componentSizes[i];
+      }
+      tensors[i]->write(valuesCount, valueIndices, values);
+      free(valueIndices);
+      free(values);
+    }
+  }
+  return FockVector<F>(tensors, indices);
+}
+
+/**
+ * \brief Returns the number of vectors packed in the given block.
+ **/
+template <typename F>
+int getFockVectorBlockSize(const FockVector<F> &block) {
+  return block.get(0)->lens[block.get(0)->order - 1];
+}
+
+/**
+ * \brief Writes the k-th vector packed in the given block to v,
+ * which must have the shape of the packed vectors.
+ **/
+template <typename F>
+void unpackFockVector(const FockVector<F> &block,
+                      const int k,
+                      FockVector<F> &v) {
+  for (size_t i(0); i < v.get_components_count(); ++i) {
+    int64_t componentSize(1);
+    for (int d(0); d < v.get(i)->order; ++d) componentSize *= v.get(i)->lens[d];
+    // read the locally stored elements of v from the block
+    int64_t valuesCount;
+    int64_t *valueIndices;
+    F *values;
+    v.get(i)->read_local(&valuesCount, &valueIndices, &values);
+    for (int64_t n(0); n < valuesCount; ++n) {
+      valueIndices[n] += k * componentSize;
+    }
+    block.get(i)->read(valuesCount, valueIndices, values);
+    for (int64_t n(0); n < valuesCount; ++n) {
+      valueIndices[n] -= k * componentSize;
+    }
+    v.get(i)->write(valuesCount, valueIndices, values);
+    free(valueIndices);
+    free(values);
+  }
+}
+
+/**
+ * \brief Returns all vectors packed in the given block, unpacked into
+ * copies of the given vectors providing their shapes.
+ **/
+template <typename V>
+std::vector<V> unpackFockVectors(const FockVector<typename V::FieldType> &block,
+                                 const std::vector<V> &shapes) {
+  std::vector<V> result(shapes);
+  for (size_t k(0); k < result.size(); ++k) {
+    unpackFockVector(block, k, result[k]);
+  }
+  return result;
+}
+
+/**
+ * \brief Returns the inner products <bra_y|ket_z> of all vectors packed
+ * in the bra block with all vectors packed in the ket block, with y
+ * running fastest. They are computed by one contraction per component
+ * rather than one reduction per pair of vectors.
+ **/
+template <typename F>
+std::vector<F> getFockVectorBlockOverlaps(const FockVector<F> &bra,
+                                          const FockVector<F> &ket) {
+  const int braCount(getFockVectorBlockSize(bra)),
+      ketCount(getFockVectorBlockSize(ket));
+  const int lens[] = {braCount, ketCount}, syms[] = {NS, NS};
+  Tensor<F> overlaps(2, lens, syms, *bra.get(0)->wrld, "overlaps");
+  CTF::Bivar_Function<F> fDot(&sisi4s::dot<F>);
+  for (size_t i(0); i < bra.get_components_count(); ++i) {
+    std::string braIndices(bra.get_indices(i));
+    braIndices.back() = 'Y';
+    overlaps.contract(1.0,
+                      *bra.get(i),
+                      braIndices.c_str(),
+                      *ket.get(i),
+                      ket.get_indices(i).c_str(),
+                      1.0,
+                      "YZ",
+                      fDot);
+  }
+  std::vector<F> result(braCount * ketCount);
+  overlaps.read_all(result.data());
+  return result;
+}
+
+} // namespace sisi4s
+
+#endif
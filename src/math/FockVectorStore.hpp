@@ -0,0 +1,134 @@
+#ifndef FOCK_VECTOR_STORE_DEFINED
+#define FOCK_VECTOR_STORE_DEFINED
+
+#include <math/LocalFockVector.hpp>
+#include <util/SharedPointer.hpp>
+#include <Sisi4s.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sisi4s {
+
+/**
+ * \brief Holds a growing sequence of Fock vectors of the same shape,
+ * such as the basis of an iterative subspace. Only the most recently
+ * added vectors are kept in memory, if limited. Each process writes its
+ * part of the older ones to its own file in a scratch directory and
+ * reads it back whenever the vector is retrieved.
+ **/
+template <typename V>
+class FockVectorStore {
+public:
+  typedef typename V::FieldType F;
+
+  FockVectorStore(const std::string &name_)
+      : name(name_)
+      , id(nextId++) {}
+
+  FockVectorStore(const FockVectorStore<V> &) = delete;
+  FockVectorStore<V> &operator=(const FockVectorStore<V> &) = delete;
+
+  ~FockVectorStore() { clear(); }
+
+  /**
+   * \brief Keeps at most the given number of the most recently added
+   * vectors in memory, writing older ones to the given directory.
+   * Zero keeps all vectors in memory.
+   **/
+  void setMaxResident(const size_t maxResident_,
+                      const std::string &directory_) {
+    maxResident = maxResident_;
+    directory = directory_;
+  }
+
+  size_t getMaxResident() const { return maxResident; }
+
+  const std::string &getDirectory() const { return directory; }
+
+  size_t size() const { return vectors.size(); }
+
+  /**
+   * \brief Returns the number of vectors currently written to disk.
+   **/
+  size_t getSpilledCount() const {
+    size_t spilledCount(0);
+    for (auto &v : vectors) spilledCount += v ? 0 : 1;
+    return spilledCount;
+  }
+
+  /**
+   * \brief Appends a copy of the given vector, writing the oldest
+   * vector in memory to disk if there are too many.
+   **/
+  void push_back(const V &v) {
+    vectors.push_back(NEW(V, v));
+    if (maxResident == 0 || vectors.size() <= maxResident) return;
+    const size_t oldest(vectors.size() - maxResident - 1);
+    // already on disk if the limit was raised
+    if (!vectors[oldest]) return;
+    saveLocalFockVector(getFileName(oldest),
+                        readLocalFockVector(*vectors[oldest]));
+    vectors[oldest] = nullptr;
+  }
+
+  /**
+   * \brief Returns the i-th vector, read from disk if not in memory.
+   * The returned vector is shared with the store if in memory.
+   **/
+  PTR(const V) get(const size_t i) const {
+    if (vectors[i]) return vectors[i];
+    // the newest vector is always in memory and provides the shape
+    auto v(NEW(V, *vectors.back()));
+    writeLocalFockVector(loadLocalFockVector<F>(getFileName(i)), *v);
+    return v;
+  }
+
+  /**
+   * \brief Exchanges the vectors, their files and the limits with the
+   * given store.
+   **/
+  void swap(FockVectorStore<V> &other) {
+    std::swap(name, other.name);
+    std::swap(directory, other.directory);
+    std::swap(maxResident, other.maxResident);
+    vectors.swap(other.vectors);
+    std::swap(id, other.id);
+  }
+
+  /**
+   * \brief Removes all vectors and their files.
+   **/
+  void clear() {
+    for (size_t i(0); i < vectors.size(); ++i) {
+      if (!vectors[i]) std::remove(getFileName(i).c_str());
+    }
+    vectors.clear();
+  }
+
+protected:
+  std::string getFileName(const size_t i) const {
+    std::stringstream fileName;
+    fileName << directory << "/" << name << "-" << id << "-" << i << "."
+             << Sisi4s::world->rank;
+    return fileName.str();
+  }
+
+  std::string name, directory;
+  size_t maxResident = 0;
+  // null for vectors written to disk
+  std::vector<PTR(V)> vectors;
+  // distinguishes the files of different stores
+  int64_t id;
+  static int64_t nextId;
+};
+
+template <typename V>
+int64_t FockVectorStore<V>::nextId(0);
+
+} // namespace sisi4s
+
+#endif
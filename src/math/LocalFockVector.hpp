@@ -0,0 +1,99 @@
+#ifndef LOCAL_FOCK_VECTOR_DEFINED
+#define LOCAL_FOCK_VECTOR_DEFINED
+
+#include <math/FockVector.hpp>
+#include <util/Exception.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace sisi4s {
+
+/**
+ * \brief The index-value pairs of each component of a FockVector
+ * stored locally by a process.
+ **/
+template <typename F>
+struct LocalFockVector {
+  std::vector<std::vector<int64_t>> indices;
+  std::vector<std::vector<F>> values;
+};
+
+template <typename F>
+LocalFockVector<F> readLocalFockVector(const FockVector<F> &v) {
+  LocalFockVector<F> local;
+  for (size_t c(0); c < v.component_tensors.size(); ++c) {
+    int64_t count, *indices;
+    F *values;
+    v.get(c)->read_local(&count, &indices, &values);
+    local.indices.emplace_back(indices, indices + count);
+    local.values.emplace_back(values, values + count);
+    free(indices);
+    free(values);
+  }
+  return local;
+}
+
+/**
+ * \brief Writes the local values to v, which must have the same
+ * shape and distribution as the FockVector they were read from.
+ **/
+template <typename F>
+void writeLocalFockVector(const LocalFockVector<F> &local, FockVector<F> &v) {
+  for (size_t c(0); c < local.indices.size(); ++c) {
+    v.get(c)->write(local.indices[c].size(),
+                    local.indices[c].data(),
+                    local.values[c].data());
+  }
+}
+
+/**
+ * \brief Writes the local values to the given file. Only the file is
+ * accessed, such that it may run in a separate thread.
+ **/
+template <typename F>
+void saveLocalFockVector(const std::string &fileName,
+                         const LocalFockVector<F> &local) {
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  const int64_t componentsCount(local.indices.size());
+  file.write(reinterpret_cast<const char *>(&componentsCount),
+             sizeof(componentsCount));
+  for (size_t c(0); c < local.indices.size(); ++c) {
+    const int64_t count(local.indices[c].size());
+    file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char *>(local.indices[c].data()),
+               count * sizeof(int64_t));
+    file.write(reinterpret_cast<const char *>(local.values[c].data()),
+               count * sizeof(F));
+  }
+  if (!file) throw new EXCEPTION("Failed to write " + fileName);
+}
+
+template <typename F>
+LocalFockVector<F> loadLocalFockVector(const std::string &fileName) {
+  std::ifstream file(fileName.c_str(), std::ios::binary);
+  int64_t componentsCount(0);
+  file.read(reinterpret_cast<char *>(&componentsCount),
+            sizeof(componentsCount));
+  LocalFockVector<F> local;
+  local.indices.resize(componentsCount);
+  local.values.resize(componentsCount);
+  for (int64_t c(0); c < componentsCount; ++c) {
+    int64_t count(0);
+    file.read(reinterpret_cast<char *>(&count), sizeof(count));
+    local.indices[c].resize(count);
+    local.values[c].resize(count);
+    file.read(reinterpret_cast<char *>(local.indices[c].data()),
+              count * sizeof(int64_t));
+    file.read(reinterpret_cast<char *>(local.values[c].data()),
+              count * sizeof(F));
+  }
+  if (!file) throw new EXCEPTION("Failed to read " + fileName);
+  return local;
+}
+
+} // namespace sisi4s
+
+#endif
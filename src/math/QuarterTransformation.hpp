@@ -0,0 +1,164 @@
+#ifndef QUARTER_TRANSFORMATION_DEFINED
+#define QUARTER_TRANSFORMATION_DEFINED
+
+#include <extern/Lapack.hpp>
+#include <util/Exception.hpp>
+
+#include <vector>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+namespace sisi4s {
+
+/**
+ * \brief Quarter transformation of the fastest index of a tensor,
+ * moving the transformed index to the slowest position:
+ *   out[x + p*X] = sum_n in[n + x*N] * C[n + (p0+p)*ldC],
+ * for 0 <= p < P, where x runs over all X combinations of the remaining
+ * indices. C is given in column major order, e.g. the orbital coefficients
+ * C(n,p) read from a ctf matrix.
+ * Applying it four times to a four-index tensor yields the fully
+ * transformed tensor in the original index order without any transposes.
+ * The transformation is a single dgemm.
+ */
+inline void transformFastestIndex(const double *in,
+                                  const size_t X,
+                                  const size_t N,
+                                  const double *C,
+                                  const size_t ldC,
+                                  const size_t p0,
+                                  const size_t P,
+                                  double *out) {
+  if (X == 0 || P == 0) return;
+  const size_t intMax(std::numeric_limits<int>::max());
+  if (X > intMax || N > intMax || P > intMax || ldC > intMax) {
+    throw EXCEPTION("Quarter transformation dimensions exceed blas integers");
+  }
+  const int m(X), n(P), k(N), lda(N), ldb(ldC), ldc(X);
+  const double one(1.0), zero(0.0);
+  dgemm_("T",
+         "N",
+         &m,
+         &n,
+         &k,
+         &one,
+         in,
+         &lda,
+         C + p0 * ldC,
+         &ldb,
+         &zero,
+         out,
+         &ldc);
+}
+
+/**
+ * \brief Quarter transformation of the slower index of a matrix,
+ * writing the transformed index as the fastest one:
+ *   out[p + m*ldOut] = sum_l in[m + l*M] * C[l + (p0+p)*ldC],
+ * for 0 <= p < P and 0 <= m < M. The transformation is a single dgemm.
+ */
+inline void transformSlowerIndex(const double *in,
+                                 const size_t M,
+                                 const size_t L,
+                                 const double *C,
+                                 const size_t ldC,
+                                 const size_t p0,
+                                 const size_t P,
+                                 double *out,
+                                 const size_t ldOut) {
+  if (M == 0 || P == 0) return;
+  const size_t intMax(std::numeric_limits<int>::max());
+  if (M > intMax || L > intMax || P > intMax || ldC > intMax
+      || ldOut > intMax) {
+    throw EXCEPTION("Quarter transformation dimensions exceed blas integers");
+  }
+  const int m(P), n(M), k(L), lda(ldC), ldb(M), ldc(ldOut);
+  const double one(1.0), zero(0.0);
+  dgemm_("T",
+         "T",
+         &m,
+         &n,
+         &k,
+         &one,
+         C + p0 * ldC,
+         &lda,
+         in,
+         &ldb,
+         &zero,
+         out,
+         &ldc);
+}
+
+/**
+ * \brief Swaps the two middle indices of a four-index tensor,
+ * with the first index running fastest:
+ *   out[a + c*A + b*A*C + d*A*C*B] = in[a + b*A + c*A*B + d*A*B*C].
+ * The (b,c) planes are transposed in cache sized blocks, moving
+ * contiguous vectors of length A.
+ */
+inline void swapMiddleIndices(const double *in,
+                              const size_t A,
+                              const size_t B,
+                              const size_t C,
+                              const size_t D,
+                              double *out) {
+  const size_t block(std::max<size_t>(1, 4096 / std::max<size_t>(1, A)));
+  for (size_t d(0); d < D; d++) {
+    const double *inD(in + d * A * B * C);
+    double *outD(out + d * A * B * C);
+    for (size_t bb(0); bb < B; bb += block) {
+      const size_t bEnd(std::min(B, bb + block));
+      for (size_t cc(0); cc < C; cc += block) {
+        const size_t cEnd(std::min(C, cc + block));
+        for (size_t b(bb); b < bEnd; b++) {
+          for (size_t c(cc); c < cEnd; c++) {
+            std::memcpy(outD + c * A + b * A * C,
+                        inD + b * A + c * A * B,
+                        A * sizeof(double));
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * \brief Transforms the chemist notation integrals in the basis functions
+ *   V[i0 + i1*N + i2*N*N + i3*N*N*N] = (i0 i1|i2 i3)
+ * to the physics notation integrals <pq|rs> = (pr|qs) with the orbital
+ * ranges [p0,p0+P), [q0,q0+Q), [r0,r0+R), [s0,s0+S) of the
+ * column major coefficients C(n,p) with leading dimension ldC:
+ *   result[p + q*P + r*P*Q + s*P*Q*R] = <pq|rs>.
+ * Four quarter transformations are done with dgemm, followed by a single
+ * blocked swap of the middle indices into physics notation.
+ */
+inline std::vector<double> transformChemistToPhysics(const double *V,
+                                                     const size_t N,
+                                                     const double *C,
+                                                     const size_t ldC,
+                                                     const size_t p0,
+                                                     const size_t P,
+                                                     const size_t q0,
+                                                     const size_t Q,
+                                                     const size_t r0,
+                                                     const size_t R,
+                                                     const size_t s0,
+                                                     const size_t S) {
+  // (i0 i1|i2 i3) -> (i1 i2 i3 p) -> (i2 i3 p r) -> (i3 p r q) -> (p r q s)
+  std::vector<double> a(N * N * N * P), b(N * N * P * R);
+  transformFastestIndex(V, N * N * N, N, C, ldC, p0, P, a.data());
+  transformFastestIndex(a.data(), N * N * P, N, C, ldC, r0, R, b.data());
+  a.resize(N * P * R * Q);
+  transformFastestIndex(b.data(), N * P * R, N, C, ldC, q0, Q, a.data());
+  b.resize(P * R * Q * S);
+  transformFastestIndex(a.data(), P * R * Q, N, C, ldC, s0, S, b.data());
+  // (p r q s) -> (p q r s)
+  std::vector<double> result(P * Q * R * S);
+  swapMiddleIndices(b.data(), P, R, Q, S, result.data());
+  return result;
+}
+
+} // namespace sisi4s
+
+#endif
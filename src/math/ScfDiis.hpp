@@ -0,0 +1,110 @@
+#ifndef SCF_DIIS_DEFINED
+#define SCF_DIIS_DEFINED
+
+#include <Eigen/Dense>
+#include <deque>
+#include <cstddef>
+
+namespace sisi4s {
+
+/**
+ * \brief Pulay's direct inversion in the iterative subspace (DIIS) for
+ * self consistent field iterations.
+ * For every given Fock matrix F built from the density matrix D the
+ * commutator error e = F D S - S D F is stored, vanishing at convergence.
+ * The extrapolated Fock matrix is the linear combination sum_i c_i F_i
+ * minimizing |sum_i c_i e_i| subject to sum_i c_i = 1.
+ * The Fock matrices are small and replicated on every rank, so
+ * the subspace is kept locally in Eigen matrices.
+ */
+template <typename M>
+class ScfDiis {
+public:
+  /**
+   * \brief Creates a DIIS extrapolation keeping at most maxSubspaceSize
+   * Fock matrices. A size smaller than 2 disables the extrapolation.
+   */
+  ScfDiis(const size_t maxSubspaceSize_)
+      : maxSubspaceSize(maxSubspaceSize_)
+      , errorNorm(0.0) {}
+
+  /**
+   * \brief Appends the Fock matrix F built from the density matrix D with
+   * the overlap matrix S and returns the extrapolated Fock matrix.
+   */
+  M extrapolate(const M &F, const M &D, const M &S) {
+    const M FDS(F * D * S);
+    const M error(FDS - FDS.transpose());
+    errorNorm = error.norm();
+    if (maxSubspaceSize < 2) return F;
+
+    fockMatrices.push_back(F);
+    errors.push_back(error);
+    if (fockMatrices.size() > maxSubspaceSize) drop();
+
+    Eigen::VectorXd c;
+    // drop the oldest vectors while the subspace is linearly dependent
+    while (!getCoefficients(c)) drop();
+
+    M result(M::Zero(F.rows(), F.cols()));
+    for (size_t i(0); i < fockMatrices.size(); i++) {
+      result += c(i) * fockMatrices[i];
+    }
+    return result;
+  }
+
+  /**
+   * \brief Frobenius norm of the commutator error of the last Fock matrix
+   * given to extrapolate.
+   */
+  double getErrorNorm() const { return errorNorm; }
+
+  size_t getSubspaceSize() const { return fockMatrices.size(); }
+
+  size_t getMaxSubspaceSize() const { return maxSubspaceSize; }
+
+protected:
+  void drop() {
+    fockMatrices.pop_front();
+    errors.pop_front();
+  }
+
+  /**
+   * \brief Solves the DIIS equations for the coefficients c of the current
+   * subspace. Returns false if the error overlap matrix is singular.
+   */
+  bool getCoefficients(Eigen::VectorXd &c) const {
+    const size_t n(errors.size());
+    if (n == 1) {
+      c = Eigen::VectorXd::Ones(1);
+      return true;
+    }
+    Eigen::MatrixXd B(n + 1, n + 1);
+    for (size_t i(0); i < n; i++) {
+      for (size_t j(0); j <= i; j++) {
+        B(i, j) = B(j, i) = errors[i].cwiseProduct(errors[j]).sum();
+      }
+    }
+    // scale the error overlaps for a better conditioned system
+    const double scale(B.topLeftCorner(n, n).diagonal().maxCoeff());
+    if (scale > 0.0) B.topLeftCorner(n, n) /= scale;
+    B.row(n).setConstant(-1.0);
+    B.col(n).setConstant(-1.0);
+    B(n, n) = 0.0;
+    Eigen::VectorXd rhs(Eigen::VectorXd::Zero(n + 1));
+    rhs(n) = -1.0;
+
+    const Eigen::FullPivLU<Eigen::MatrixXd> lu(B);
+    if (!lu.isInvertible()) return false;
+    c = lu.solve(rhs).head(n);
+    return true;
+  }
+
+  const size_t maxSubspaceSize;
+  double errorNorm;
+  std::deque<M> fockMatrices, errors;
+};
+
+} // namespace sisi4s
+
+#endif
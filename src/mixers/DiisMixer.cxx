@@ -2,50 +2,101 @@
 
 #include <mixers/DiisMixer.hpp>
 #include <util/Emitter.hpp>
+#include <util/Exception.hpp>
 #include <util/Log.hpp>
 #include <Sisi4s.hpp>
 #include <extern/Lapack.hpp>
 
 #include <math/IterativePseudoInverse.hpp>
+#include <math/LocalFockVector.hpp>
+#include <math/MathFunctions.hpp>
 #include <util/Tensor.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
 using namespace sisi4s;
 
 MIXER_REGISTRAR_DEFINITION(DiisMixer);
 
-std::vector<double> inverse(std::vector<double> matrix, int N) {
-  std::vector<double> column(N, 0);
-  std::vector<int> ipiv(N);
-  std::vector<double> work(N);
-  column[0] = -1.0;
+template <typename F>
+int64_t DiisMixer<F>::nextSubspaceId(0);
 
-  int one(1);
+namespace {
+// solves the DIIS equations of the given bordered overlap matrix of
+// dimension n for the first column of its inverse, returning the
+// reciprocal condition number, which is zero if it is singular
+double solve(const std::vector<Float64> &matrix,
+             const int n,
+             std::vector<Float64> &column) {
+  std::vector<Float64> rhs(n, 0.0), factors(n * n), work(3 * n);
+  std::vector<int> pivots(n), iwork(n);
+  rhs[0] = -1.0;
+  column.resize(n);
+  const int one(1), workSize(work.size());
+  Float64 conditioning, forwardError, backwardError;
   int info;
-  dsysv_("U",
-         &N,
-         &one,
-         matrix.data(),
-         &N,
-         ipiv.data(),
-         column.data(),
-         &N,
-         work.data(),
-         &N,
-         &info);
-  if (info != 0) {
-    LOG(0) << "Problem diagonalization of matrix:\n";
-    for (auto i : matrix) LOG(9) << i << std::endl;
-    throw "problem diagonalization\n";
-  }
-  return column;
+  dsysvx_("N",
+          "U",
+          &n,
+          &one,
+          matrix.data(),
+          &n,
+          factors.data(),
+          &n,
+          pivots.data(),
+          rhs.data(),
+          &n,
+          column.data(),
+          &n,
+          &conditioning,
+          &forwardError,
+          &backwardError,
+          work.data(),
+          &workSize,
+          iwork.data(),
+          &info);
+  // info = n+1 only signals a condition number below machine precision
+  return info == 0 || info == n + 1 ? conditioning : 0.0;
 }
 
-std::vector<sisi4s::complex> inverse(std::vector<sisi4s::complex> matrix,
-                                     int N) {
-  std::vector<sisi4s::complex> column(N);
-  throw "TODO";
-  return column;
+// the same for a Hermitian overlap matrix
+double solve(const std::vector<Complex64> &matrix,
+             const int n,
+             std::vector<Complex64> &column) {
+  std::vector<Complex64> rhs(n, 0.0), factors(n * n), work(2 * n);
+  std::vector<Float64> rwork(n);
+  std::vector<int> pivots(n);
+  rhs[0] = -1.0;
+  column.resize(n);
+  const int one(1), workSize(work.size());
+  Float64 conditioning, forwardError, backwardError;
+  int info;
+  zhesvx_("N",
+          "U",
+          &n,
+          &one,
+          matrix.data(),
+          &n,
+          factors.data(),
+          &n,
+          pivots.data(),
+          rhs.data(),
+          &n,
+          column.data(),
+          &n,
+          &conditioning,
+          &forwardError,
+          &backwardError,
+          work.data(),
+          &workSize,
+          rwork.data(),
+          &info);
+  return info == 0 || info == n + 1 ? conditioning : 0.0;
 }
+} // namespace
 
 template <typename F>
 DiisMixer<F>::DiisMixer(Algorithm *algorithm)
@@ -53,129 +104,234 @@ DiisMixer<F>::DiisMixer(Algorithm *algorithm)
     , next(nullptr)
     , nextResiduum(nullptr) {
   int N(algorithm->getRealArgument("maxResidua", 4));
+  subspaceDirectory = algorithm->getTextArgument("subspaceDirectory", "");
+  const std::string illConditioned(
+      algorithm->getTextArgument("illConditionedSubspace", "prune"));
+  if (illConditioned != "prune" && illConditioned != "restart") {
+    throw new EXCEPTION("illConditionedSubspace must be prune or restart, not "
+                        + illConditioned);
+  }
+  restartIllConditioned = illConditioned == "restart";
+  minConditioning = algorithm->getRealArgument("minConditioning", 1e-14);
   LOG(1, "DiisMixer") << "maxResidua=" << N << std::endl;
+  LOG(1, "DiisMixer") << "illConditionedSubspace=" << illConditioned
+                      << ", minConditioning=" << minConditioning << std::endl;
   EMIT() << YAML::Key << "mixer" << YAML::Value;
   EMIT() << YAML::BeginMap;
   EMIT() << YAML::Key << "type" << YAML::Value << "diis";
   EMIT() << YAML::Key << "max-residua" << YAML::Value << N;
+  EMIT() << YAML::Key << "ill-conditioned-subspace" << YAML::Value
+         << illConditioned;
+  EMIT() << YAML::Key << "min-conditioning" << YAML::Value << minConditioning;
+  if (!subspaceDirectory.empty()) {
+    LOG(1, "DiisMixer") << "subspaceDirectory=" << subspaceDirectory
+                        << std::endl;
+    EMIT() << YAML::Key << "subspace-directory" << YAML::Value
+           << subspaceDirectory;
+  }
   EMIT() << YAML::EndMap;
 
   amplitudes.resize(N);
   residua.resize(N);
+  weights.resize(N);
+  B.resize(N * N);
   nextIndex = 0;
   count = 0;
+  subspaceId = nextSubspaceId++;
+}
+
+template <typename F>
+DiisMixer<F>::~DiisMixer() {
+  if (subspaceDirectory.empty()) return;
+  if (storing.valid()) storing.wait();
+  for (size_t i(0); i < residua.size(); ++i) {
+    std::remove(getSubspaceFileName("amplitudes", i).c_str());
+    std::remove(getSubspaceFileName("residuum", i).c_str());
+  }
+}
+
+template <typename F>
+std::string DiisMixer<F>::getSubspaceFileName(const std::string &kind,
+                                              const int i) {
+  std::stringstream fileName;
+  fileName << subspaceDirectory << "/diis-" << subspaceId << "-" << kind
+           << "-" << i << "." << Sisi4s::world->rank;
+  return fileName.str();
+}
 
-  // generate initial overlap matrix
-  std::array<int, 2> lens{{N + 1, N + 1}};
-  std::array<int, 2> syms{{NS, NS}};
-  B = NEW(Tensor<F>,
-          lens.size(),
-          lens.data(),
-          syms.data(),
-          *Sisi4s::world,
-          "B");
-  Tensor<F> one(false, *B);
-  one["ij"] += 1.0;
-  std::array<int, 2> upperRightBegin{{0, 1}};
-  std::array<int, 2> upperLeftBegin{{1, 0}};
-  std::array<int, 2> upperRightEnd{{1, N + 1}};
-  std::array<int, 2> lowerLeftEnd{{N + 1, 1}};
-  B->slice(upperRightBegin.data(),
-           upperRightEnd.data(),
-           1.0,
-           one,
-           upperRightBegin.data(),
-           upperRightEnd.data(),
-           -1.0);
-  B->slice(upperLeftBegin.data(),
-           lowerLeftEnd.data(),
-           1.0,
-           one,
-           upperLeftBegin.data(),
-           lowerLeftEnd.data(),
-           -1.0);
+template <typename F>
+std::vector<int> DiisMixer<F>::getSubspaceIndices(const int newest) {
+  const int N(residua.size());
+  std::vector<int> indices;
+  for (int j(0); j < count; ++j) indices.push_back((newest + N - j) % N);
+  return indices;
 }
 
 template <typename F>
-DiisMixer<F>::~DiisMixer() {}
+void DiisMixer<F>::streamSubspace(
+    const std::string &kind,
+    const std::vector<int> &indices,
+    const FockVector<F> &shape,
+    const std::function<void(int, FockVector<F> &)> &f) {
+  if (indices.empty()) return;
+  FockVector<F> V(shape);
+  auto reading(std::async(std::launch::async,
+                          &loadLocalFockVector<F>,
+                          getSubspaceFileName(kind, indices[0])));
+  for (size_t n(0); n < indices.size(); ++n) {
+    LocalFockVector<F> local(reading.get());
+    if (n + 1 < indices.size()) {
+      reading = std::async(std::launch::async,
+                           &loadLocalFockVector<F>,
+                           getSubspaceFileName(kind, indices[n + 1]));
+    }
+    writeLocalFockVector(local, V);
+    f(indices[n], V);
+  }
+}
+
+template <typename F>
+PTR(FockVector<F>)
+DiisMixer<F>::combineSubspace(const std::string &kind,
+                              const PTR(FockVector<F>) &inMemory,
+                              const int inMemoryIndex) {
+  // in the order of the in-memory mixing, from the newest to the oldest
+  auto combination(NEW(FockVector<F>, *inMemory));
+  *combination *= weights[inMemoryIndex];
+  std::vector<int> indices(getSubspaceIndices(inMemoryIndex));
+  indices.erase(indices.begin());
+  streamSubspace(kind, indices, *inMemory, [&](int i, FockVector<F> &V) {
+    V *= weights[i];
+    *combination += V;
+  });
+  return combination;
+}
 
 template <typename F>
 void DiisMixer<F>::append(const PTR(FockVector<F>) &A,
                           const PTR(FockVector<F>) &R) {
+  const int N(residua.size());
+  // the vector at nextIndex is replaced
+  count = std::min(count, N - 1);
+  const std::vector<int> previous(getSubspaceIndices((nextIndex + N - 1) % N));
+
+  // overlaps of the given residuum with the previous ones
+  std::vector<F> overlaps(N);
+  if (subspaceDirectory.empty()) {
+    for (int i : previous) overlaps[i] = 2.0 * residua[i]->dot(*R);
+  } else {
+    // the previously appended pair is now on disk
+    if (storing.valid()) storing.get();
+    std::fill(amplitudes.begin(), amplitudes.end(), nullptr);
+    std::fill(residua.begin(), residua.end(), nullptr);
+    streamSubspace("residuum", previous, *R, [&](int i, FockVector<F> &Ri) {
+      overlaps[i] = 2.0 * Ri.dot(*R);
+    });
+    // store the given pair while the estimate is formed
+    LocalFockVector<F> localA(readLocalFockVector(*A)),
+        localR(readLocalFockVector(*R));
+    const std::string fileNameA(getSubspaceFileName("amplitudes", nextIndex));
+    const std::string fileNameR(getSubspaceFileName("residuum", nextIndex));
+    storing = std::async(
+        std::launch::async,
+        [fileNameA, fileNameR](const LocalFockVector<F> &localA,
+                               const LocalFockVector<F> &localR) {
+          saveLocalFockVector(fileNameA, localA);
+          saveLocalFockVector(fileNameR, localR);
+        },
+        std::move(localA),
+        std::move(localR));
+  }
+  for (int i : previous) {
+    B[i + N * nextIndex] = overlaps[i];
+    B[nextIndex + N * i] = conj(overlaps[i]);
+  }
+  B[nextIndex + N * nextIndex] = 2.0 * std::real(R->dot(*R));
+
   // replace amplidue and residuum at nextIndex
   amplitudes[nextIndex] = A;
   residua[nextIndex] = R;
+  ++count;
 
-  // generate 1x1 matrix to enter new overlap elements
-  const int N(residua.size());
-  std::array<int, 2> lens{{1, 1}};
-  std::array<int, 2> syms{{NS, NS}};
-  Tensor<F> one(lens.size(), lens.data(), syms.data(), *Sisi4s::world, "1");
-  one["ij"] += 1.0;
-  for (int i(0); i < N; ++i) {
-    if (residua[i]) {
-      std::array<int, 2> colBegin{{nextIndex + 1, i + 1}};
-      std::array<int, 2> colEnd{{nextIndex + 2, i + 2}};
-      std::array<int, 2> rowBegin{{i + 1, nextIndex + 1}};
-      std::array<int, 2> rowEnd{{i + 2, nextIndex + 2}};
-      std::array<int, 2> oneBegin{{0, 0}};
-      std::array<int, 2> oneEnd{{1, 1}};
-      F overlap(2.0 * std::real(residua[i]->dot(*R)));
-      B->slice(colBegin.data(),
-               colEnd.data(),
-               0.0,
-               one,
-               oneBegin.data(),
-               oneEnd.data(),
-               overlap);
-      if (i == nextIndex) continue;
-      B->slice(rowBegin.data(),
-               rowEnd.data(),
-               0.0,
-               one,
-               oneBegin.data(),
-               oneEnd.data(),
-               overlap);
+  // solve the DIIS equations for the weights, dropping old vectors
+  // from the subspace while they are ill-conditioned
+  std::vector<int> indices(getSubspaceIndices(nextIndex));
+  std::vector<F> column;
+  double conditioning, scale;
+  int dropped(0);
+  while (true) {
+    // the overlaps are scaled for a better conditioned system
+    scale = 0.0;
+    for (int i : indices) {
+      scale = std::max(scale, std::abs(B[i + N * i]));
+    }
+    if (scale == 0.0) scale = 1.0;
+    const int n(count + 1);
+    std::vector<F> matrix(n * n);
+    for (int k(0); k < count; ++k) {
+      matrix[k + 1] = matrix[(k + 1) * n] = -1.0;
+      for (int l(0); l < count; ++l) {
+        matrix[(k + 1) + n * (l + 1)] = B[indices[k] + N * indices[l]] / scale;
+      }
+    }
+    conditioning = solve(matrix, n, column);
+    if (count == 1 || conditioning >= minConditioning) break;
+    const int dropping(restartIllConditioned ? count - 1 : 1);
+    for (int j(count - dropping); j < count; ++j) {
+      amplitudes[indices[j]] = nullptr;
+      residua[indices[j]] = nullptr;
     }
+    count -= dropping;
+    dropped += dropping;
+    indices.resize(count);
+  }
+  if (dropped > 0) {
+    LOG(1, "DiisMixer") << "dropped " << dropped
+                        << " vectors from ill-conditioned subspace"
+                        << std::endl;
   }
-  if (count < N) ++count;
-
-  //  B->print();
-  // now, pseudo-invert upper left corner of B and read out its first column
-  int dim(count + 1);
-  std::array<int, 2> upperLeftBegin{{0, 0}};
-  std::array<int, 2> lowerRightEnd{{count + 1, count + 1}};
-  std::vector<F> column(count + 1);
-  std::vector<F> matrix(dim * dim);
-  B->slice(upperLeftBegin.data(), lowerRightEnd.data()).read_all(matrix.data());
-  column = inverse(matrix, dim);
 
   LOG(1, "DiisMixer") << "lambda"
-                      << "=" << column[0] << std::endl;
+                      << "=" << column[0] * scale << std::endl;
   EMIT() << YAML::Key << "mixing";
   EMIT() << YAML::Value << YAML::BeginMap;
   // FIXME: imaginary part dismissed
-  EMIT() << YAML::Key << "lambda" << YAML::Value << std::real(column[0]);
+  EMIT() << YAML::Key << "lambda" << YAML::Value
+         << std::real(column[0] * scale);
+  EMIT() << YAML::Key << "conditioning" << YAML::Value << conditioning;
+  if (dropped > 0) {
+    EMIT() << YAML::Key << "dropped" << YAML::Value << dropped;
+  }
 
-  next = NEW(FockVector<F>, *A);
-  *next *= F(0);
-  nextResiduum = NEW(FockVector<F>, *R);
-  *nextResiduum *= F(0);
   EMIT() << YAML::Key << "weights";
   EMIT() << YAML::Value << YAML::Flow << YAML::BeginSeq;
   for (int j(0); j < count; ++j) {
-    int i((nextIndex + N - j) % N);
-    LOG(1, "DiisMixer") << "w^(-" << (j + 1) << ")=" << column[i + 1]
+    int i(indices[j]);
+    LOG(1, "DiisMixer") << "w^(-" << (j + 1) << ")=" << column[j + 1]
                         << std::endl;
     // FIXME: imaginary part dismissed
-    EMIT() << std::real(column[i + 1]);
-    *next += column[i + 1] * *amplitudes[i];
-    *nextResiduum += column[i + 1] * *residua[i];
+    EMIT() << std::real(column[j + 1]);
+    weights[i] = column[j + 1];
   }
   EMIT() << YAML::EndSeq;
   EMIT() << YAML::Comment("w(-1), ... , w(-max-residua)");
   EMIT() << YAML::EndMap;
 
+  if (subspaceDirectory.empty()) {
+    next = NEW(FockVector<F>, *A);
+    *next *= F(0);
+    nextResiduum = NEW(FockVector<F>, *R);
+    *nextResiduum *= F(0);
+    for (int i : indices) {
+      *next += weights[i] * *amplitudes[i];
+      *nextResiduum += weights[i] * *residua[i];
+    }
+  } else {
+    next = combineSubspace("amplitudes", A, nextIndex);
+    // formed when requested
+    nextResiduum = nullptr;
+  }
+
   nextIndex = (nextIndex + 1) % N;
 }
 
@@ -186,9 +342,91 @@ PTR(const FockVector<F>) DiisMixer<F>::get() {
 
 template <typename F>
 PTR(const FockVector<F>) DiisMixer<F>::getResiduum() {
+  if (!nextResiduum && next) {
+    const int last((nextIndex + residua.size() - 1) % residua.size());
+    nextResiduum = combineSubspace("residuum", residua[last], last);
+  }
   return nextResiduum;
 }
 
+template <typename F>
+void DiisMixer<F>::writeCheckpoint(Checkpoint &checkpoint) {
+  const int N(residua.size()), last((nextIndex + N - 1) % N);
+  checkpoint.setInteger("mixer-max-residua", N);
+  checkpoint.setInteger("mixer-next-index", nextIndex);
+  checkpoint.setInteger("mixer-count", count);
+  checkpoint.setScalars<F>("mixer-overlaps", B);
+  std::vector<int> onDisk;
+  for (int i : getSubspaceIndices(last)) {
+    std::stringstream index;
+    index << i;
+    if (!residua[i]) {
+      onDisk.push_back(i);
+      continue;
+    }
+    checkpoint.writeFockVector<F>("mixer-amplitudes-" + index.str(),
+                                  *amplitudes[i]);
+    checkpoint.writeFockVector<F>("mixer-residua-" + index.str(), *residua[i]);
+  }
+  if (!onDisk.empty()) {
+    streamSubspace("amplitudes",
+                   onDisk,
+                   *amplitudes[last],
+                   [&](int i, FockVector<F> &V) {
+                     std::stringstream key;
+                     key << "mixer-amplitudes-" << i;
+                     checkpoint.writeFockVector<F>(key.str(), V);
+                   });
+    streamSubspace("residuum",
+                   onDisk,
+                   *residua[last],
+                   [&](int i, FockVector<F> &V) {
+                     std::stringstream key;
+                     key << "mixer-residua-" << i;
+                     checkpoint.writeFockVector<F>(key.str(), V);
+                   });
+  }
+  checkpoint.writeFockVector<F>("mixer-next", *next);
+  checkpoint.writeFockVector<F>("mixer-next-residuum", *getResiduum());
+}
+
+template <typename F>
+void DiisMixer<F>::readCheckpoint(Checkpoint &checkpoint) {
+  const int N(residua.size());
+  if (checkpoint.getInteger("mixer-max-residua") != N) {
+    std::stringstream message;
+    message << "Checkpoint written with maxResidua="
+            << checkpoint.getInteger("mixer-max-residua") << ", not " << N;
+    throw new EXCEPTION(message.str());
+  }
+  nextIndex = checkpoint.getInteger("mixer-next-index");
+  count = checkpoint.getInteger("mixer-count");
+  B = checkpoint.getScalars<F>("mixer-overlaps");
+  const int last((nextIndex + N - 1) % N);
+  if (storing.valid()) storing.get();
+  std::fill(amplitudes.begin(), amplitudes.end(), nullptr);
+  std::fill(residua.begin(), residua.end(), nullptr);
+  for (int i : getSubspaceIndices(last)) {
+    std::stringstream index;
+    index << i;
+    auto Ai(checkpoint.readFockVector<F>("mixer-amplitudes-" + index.str()));
+    auto Ri(checkpoint.readFockVector<F>("mixer-residua-" + index.str()));
+    if (subspaceDirectory.empty() || i == last) {
+      amplitudes[i] = Ai;
+      residua[i] = Ri;
+    }
+    // the last pair is also read from disk by the next append
+    if (!subspaceDirectory.empty()) {
+      saveLocalFockVector(getSubspaceFileName("amplitudes", i),
+                          readLocalFockVector(*Ai));
+      saveLocalFockVector(getSubspaceFileName("residuum", i),
+                          readLocalFockVector(*Ri));
+    }
+  }
+  next = checkpoint.readFockVector<F>("mixer-next");
+  nextResiduum = checkpoint.readFockVector<F>("mixer-next-residuum");
+}
+
 // instantiate
 template class sisi4s::DiisMixer<sisi4s::Float64>;
 template class sisi4s::DiisMixer<sisi4s::Complex64>;
@@ -7,6 +7,11 @@
 
 #include <util/Tensor.hpp>
 
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
 namespace sisi4s {
 template <typename F>
 class DiisMixer : public Mixer<F> {
@@ -18,6 +23,8 @@ public:
   virtual void append(const PTR(FockVector<F>) &A, const PTR(FockVector<F>) &R);
   virtual PTR(const FockVector<F>) get();
   virtual PTR(const FockVector<F>) getResiduum();
+  virtual void writeCheckpoint(Checkpoint &checkpoint);
+  virtual void readCheckpoint(Checkpoint &checkpoint);
 
   /**
    * \brief The best estimate for the next amplitudes as returned by get().
@@ -40,14 +47,14 @@ public:
   std::vector<PTR(FockVector<F>)> residua;
 
   /**
-   * \brief Overlap matrix \f$B(i,j) = 2*Re(\langleR(i)|R(j)\rangle),
-     B(i,N) = 1, B(N,j) = 1, B(N,N) = 0\f$ where \f$i,j < N\f$.
-   * The coefficients \f$c_j\f$ and the Lagrangian multiplyer are then given
-   * by \f$c_j = B^+(j,N), lambda = B^+(N,N)\f$, where $\fB^+\f$ denotes
-   * the Moore--Pensore pseudo inverse of \f$B\f$.
+   * \brief Overlap matrix \f$B(i,j) = 2\langle R(i)|R(j)\rangle\f$ of the
+   * residua, replicated on all processes and stored column major.
+   * The weights \f$c_j\f$ of the subspace vectors minimize
+   * \f$\sum_{ij} c_i^\ast B(i,j) c_j\f$ subject to \f$\sum_j c_j = 1\f$.
+   * They are found by solving the symmetric, or Hermitian, linear
+   * equations of B bordered by the constraint.
    **/
-  PTR(Tensor<F>) B;
-
+  std::vector<F> B;
   /**
    * \brief The index of the residuum in the residua vector and in the
    * overlap matrix to be replaced with the next one.
@@ -55,9 +62,75 @@ public:
   int nextIndex;
 
   /**
-   * \brief The number of non-zero amplitudes in the vector.
+   * \brief The number of amplitudes in the subspace, which are the
+   * count most recently appended ones.
    **/
   int count;
+
+  /**
+   * \brief Whether to drop all but the newest vector, rather than the
+   * oldest ones, if the DIIS equations are ill-conditioned.
+   **/
+  bool restartIllConditioned;
+
+  /**
+   * \brief The reciprocal condition number of the DIIS equations below
+   * which they are considered ill-conditioned.
+   **/
+  double minConditioning;
+
+  /**
+   * \brief Directory where each process keeps its part of the amplitudes
+   * and residua of the subspace, if given. Only the last appended pair
+   * is then kept in memory, the others are streamed from disk once per
+   * iteration and the estimated residuum is formed only when requested.
+   **/
+  std::string subspaceDirectory;
+
+  /**
+   * \brief The coefficients of the subspace vectors in the current
+   * estimate.
+   **/
+  std::vector<F> weights;
+
+protected:
+  /**
+   * \brief Returns the indices of the vectors in the subspace, from the
+   * newest, at the given index, to the oldest.
+   **/
+  std::vector<int> getSubspaceIndices(const int newest);
+
+  std::string getSubspaceFileName(const std::string &kind, const int i);
+
+  /**
+   * \brief Calls f(i,V) for each i of the given subspace indices in turn,
+   * with V the vector of the given kind read from disk into a copy of
+   * the given vector. The next vector is read while f works on V.
+   **/
+  void streamSubspace(const std::string &kind,
+                      const std::vector<int> &indices,
+                      const FockVector<F> &shape,
+                      const std::function<void(int, FockVector<F> &)> &f);
+
+  /**
+   * \brief Returns the linear combination of the given subspace vectors
+   * of the given kind with the current weights, where only the vector at
+   * the given index is in memory.
+   **/
+  PTR(FockVector<F>) combineSubspace(const std::string &kind,
+                                     const PTR(FockVector<F>) &inMemory,
+                                     const int inMemoryIndex);
+
+  /**
+   * \brief Storing the last appended pair to disk in the background.
+   **/
+  std::future<void> storing;
+
+  /**
+   * \brief Distinguishes the files of different mixers.
+   **/
+  int64_t subspaceId;
+  static int64_t nextSubspaceId;
 };
 } // namespace sisi4s
 
@@ -53,6 +53,18 @@ PTR(const FockVector<F>) LinearMixer<F>::getResiduum() {
   return lastResiduum;
 }
 
+template <typename F>
+void LinearMixer<F>::writeCheckpoint(Checkpoint &checkpoint) {
+  checkpoint.writeFockVector<F>("mixer-last", *last);
+  checkpoint.writeFockVector<F>("mixer-last-residuum", *lastResiduum);
+}
+
+template <typename F>
+void LinearMixer<F>::readCheckpoint(Checkpoint &checkpoint) {
+  last = checkpoint.readFockVector<F>("mixer-last");
+  lastResiduum = checkpoint.readFockVector<F>("mixer-last-residuum");
+}
+
 // instantiate
 template class sisi4s::LinearMixer<sisi4s::Float64>;
 template class sisi4s::LinearMixer<sisi4s::Complex64>;
@@ -16,6 +16,8 @@ public:
   virtual void append(const PTR(FockVector<F>) &A, const PTR(FockVector<F>) &R);
   virtual PTR(const FockVector<F>) get();
   virtual PTR(const FockVector<F>) getResiduum();
+  virtual void writeCheckpoint(Checkpoint &checkpoint);
+  virtual void readCheckpoint(Checkpoint &checkpoint);
 
   PTR(FockVector<F>) last;
   PTR(FockVector<F>) lastResiduum;
@@ -4,6 +4,7 @@
 #include <algorithms/Algorithm.hpp>
 #include <math/Complex.hpp>
 #include <math/FockVector.hpp>
+#include <util/Checkpoint.hpp>
 #include <util/SharedPointer.hpp>
 
 #include <string>
@@ -47,6 +48,19 @@ public:
    **/
   virtual PTR(const FockVector<F>) getResiduum() = 0;
 
+  /**
+   * \brief Writes the state of the mixer to the given checkpoint such
+   * that a mixer restored from it continues with identical estimates.
+   * Requires one or more previous calls to append.
+   **/
+  virtual void writeCheckpoint(Checkpoint &checkpoint) = 0;
+
+  /**
+   * \brief Restores the state of the mixer from the given checkpoint,
+   * written by a mixer of the same type and arguments.
+   **/
+  virtual void readCheckpoint(Checkpoint &checkpoint) = 0;
+
   Algorithm *algorithm;
 };
 
@@ -0,0 +1,231 @@
+#include <util/BinaryTensorFormat.hpp>
+#include <util/Exception.hpp>
+#include <algorithm>
+
+using namespace sisi4s;
+
+std::vector<BinaryTensorSymmetry>
+BinaryTensorSymmetry::fromCtf(int const order,
+                              int const *syms,
+                              std::string const &indexNames) {
+  std::vector<BinaryTensorSymmetry> symmetries;
+  for (int d(0); d < order - 1; ++d) {
+    if (syms[d] == NS) continue;
+    BinaryTensorSymmetry symmetry;
+    symmetry.flags = PACKED_FLAG | (syms[d] == SH ? HOLLOW_FLAG : 0);
+    symmetry.operation = syms[d] == AS ? "-x" : "x";
+    symmetry.indexMap = indexNames;
+    std::swap(symmetry.indexMap[d], symmetry.indexMap[d + 1]);
+    symmetries.push_back(symmetry);
+  }
+  return symmetries;
+}
+
+void BinaryTensorSymmetry::toCtf(
+    std::vector<BinaryTensorSymmetry> const &symmetries,
+    std::string const &indexNames,
+    int *syms) {
+  for (size_t d(0); d < indexNames.size(); ++d) syms[d] = NS;
+  for (auto const &symmetry : symmetries) {
+    // symmetries not exploited in the data need not be known
+    if (!(symmetry.flags & PACKED_FLAG)) continue;
+    std::vector<size_t> permuted;
+    for (size_t d(0); d < indexNames.size(); ++d) {
+      if (d >= symmetry.indexMap.size()
+          || symmetry.indexMap[d] != indexNames[d]) {
+        permuted.push_back(d);
+      }
+    }
+    if (symmetry.indexMap.size() != indexNames.size() || permuted.size() != 2
+        || permuted[1] != permuted[0] + 1
+        || symmetry.indexMap[permuted[0]] != indexNames[permuted[1]]
+        || symmetry.indexMap[permuted[1]] != indexNames[permuted[0]]) {
+      throw new EXCEPTION("Unsupported packed symmetry " + symmetry.indexMap
+                          + " of indices " + indexNames);
+    }
+    if (symmetry.operation == "-x") {
+      syms[permuted[0]] = AS;
+    } else if (symmetry.operation == "x") {
+      syms[permuted[0]] = (symmetry.flags & HOLLOW_FLAG) ? SH : SY;
+    } else {
+      throw new EXCEPTION("Unsupported symmetry operation "
+                          + symmetry.operation);
+    }
+  }
+}
+
+std::vector<char> BinaryTensorSymmetry::encode() const {
+  const size_t fieldsSize(2 + operation.size() + indexMap.size());
+  const size_t size(
+      (sizeof(BinaryTensorChunkHeader) + fieldsSize + 7) / 8 * 8);
+  std::vector<char> chunk(size, 0);
+  BinaryTensorChunkHeader header(BinaryTensorChunkHeader::SYMMETRY, size);
+  std::memcpy(chunk.data(), &header, sizeof(header));
+  char *fields(chunk.data() + sizeof(header));
+  fields[0] = flags;
+  fields[1] = static_cast<char>(operation.size());
+  std::copy(operation.begin(), operation.end(), fields + 2);
+  std::copy(indexMap.begin(), indexMap.end(), fields + 2 + operation.size());
+  return chunk;
+}
+
+BinaryTensorSymmetry
+BinaryTensorSymmetry::decode(std::vector<char> const &chunk) {
+  const size_t fieldsOffset(sizeof(BinaryTensorChunkHeader) + 2);
+  const size_t operationSize(
+      chunk.size() >= fieldsOffset
+          ? static_cast<unsigned char>(chunk[fieldsOffset - 1])
+          : 0);
+  if (chunk.size() < fieldsOffset + operationSize) {
+    throw new EXCEPTION("Invalid symmetry chunk");
+  }
+  BinaryTensorSymmetry symmetry;
+  symmetry.flags = chunk[fieldsOffset - 2];
+  symmetry.operation.assign(chunk.data() + fieldsOffset, operationSize);
+  // the index map is followed by zero padding
+  symmetry.indexMap.assign(chunk.data() + fieldsOffset + operationSize,
+                           chunk.size() - fieldsOffset - operationSize);
+  symmetry.indexMap.resize(std::strlen(symmetry.indexMap.c_str()));
+  return symmetry;
+}
+
+namespace {
+void shuffleBytes(std::vector<char> &data, size_t const wordSize) {
+  const size_t wordsCount(data.size() / wordSize);
+  std::vector<char> shuffled(data);
+  for (size_t w(0); w < wordsCount; ++w) {
+    for (size_t b(0); b < wordSize; ++b) {
+      shuffled[b * wordsCount + w] = data[w * wordSize + b];
+    }
+  }
+  data.swap(shuffled);
+}
+
+void unshuffleBytes(std::vector<char> &data, size_t const wordSize) {
+  const size_t wordsCount(data.size() / wordSize);
+  std::vector<char> unshuffled(data);
+  for (size_t w(0); w < wordsCount; ++w) {
+    for (size_t b(0); b < wordSize; ++b) {
+      unshuffled[w * wordSize + b] = data[b * wordsCount + w];
+    }
+  }
+  data.swap(unshuffled);
+}
+
+// control bytes below 128 are followed by 1 to 128 literal bytes,
+// control bytes from 128 by a single byte repeated 3 to 130 times
+const size_t MIN_RUN_LENGTH(3), MAX_RUN_LENGTH(130), MAX_LITERALS(128);
+
+bool encodeRunLength(std::vector<char> const &data, std::vector<char> &code) {
+  const size_t n(data.size());
+  code.clear();
+  code.reserve(n);
+  size_t i(0);
+  while (i < n) {
+    size_t j(i + 1);
+    while (j < n && j - i < MAX_RUN_LENGTH && data[j] == data[i]) ++j;
+    if (j - i >= MIN_RUN_LENGTH) {
+      code.push_back(static_cast<char>(128 + j - i - MIN_RUN_LENGTH));
+      code.push_back(data[i]);
+      i = j;
+    } else {
+      const size_t start(i);
+      while (i < n && i - start < MAX_LITERALS
+             && !(i + 2 < n && data[i] == data[i + 1]
+                  && data[i] == data[i + 2])) {
+        ++i;
+      }
+      code.push_back(static_cast<char>(i - start - 1));
+      code.insert(code.end(), data.begin() + start, data.begin() + i);
+    }
+    // not worth it
+    if (code.size() >= n) return false;
+  }
+  return true;
+}
+
+void decodeRunLength(std::vector<char> const &code,
+                     std::vector<char> &data,
+                     size_t const decodedSize) {
+  data.clear();
+  data.reserve(decodedSize);
+  size_t i(0);
+  while (i < code.size()) {
+    const size_t control(static_cast<unsigned char>(code[i++]));
+    if (control < 128) {
+      const size_t length(control + 1);
+      if (i + length > code.size() || data.size() + length > decodedSize) {
+        throw new EXCEPTION("Invalid run length encoded data");
+      }
+      data.insert(data.end(), code.begin() + i, code.begin() + i + length);
+      i += length;
+    } else {
+      const size_t length(control - 128 + MIN_RUN_LENGTH);
+      if (i >= code.size() || data.size() + length > decodedSize) {
+        throw new EXCEPTION("Invalid run length encoded data");
+      }
+      data.insert(data.end(), length, code[i++]);
+    }
+  }
+}
+} // namespace
+
+int32_t BinaryTensorCodec::encode(std::vector<char> &data,
+                                  int32_t const filters,
+                                  size_t const wordSize) {
+  int32_t applied(0);
+  if (filters & SHUFFLE) {
+    shuffleBytes(data, wordSize);
+    applied |= SHUFFLE;
+  }
+  if (filters & RUN_LENGTH) {
+    std::vector<char> code;
+    if (encodeRunLength(data, code)) {
+      data.swap(code);
+      applied |= RUN_LENGTH;
+    }
+  }
+  return applied;
+}
+
+void BinaryTensorCodec::decode(std::vector<char> &data,
+                               int32_t const filters,
+                               size_t const wordSize,
+                               size_t const decodedSize) {
+  if (filters & RUN_LENGTH) {
+    std::vector<char> decoded;
+    decodeRunLength(data, decoded, decodedSize);
+    data.swap(decoded);
+  }
+  if (data.size() != decodedSize) {
+    throw new EXCEPTION("Unexpected size of decoded data");
+  }
+  if (filters & SHUFFLE) unshuffleBytes(data, wordSize);
+}
+
+int32_t BinaryTensorCodec::getFilters(std::string const &name) {
+  if (name == "none") return NONE;
+  if (name == "shuffle") return SHUFFLE;
+  if (name == "rle") return SHUFFLE | RUN_LENGTH;
+  throw new EXCEPTION("Unknown binary tensor compression " + name
+                      + ", expected none, shuffle or rle");
+}
+
+uint32_t BinaryTensorCodec::getChecksum(char const *data, size_t const size) {
+  // table of the reflected CRC-32 polynomial 0xedb88320
+  static const std::vector<uint32_t> table([]() {
+    std::vector<uint32_t> t(256);
+    for (uint32_t n(0); n < 256; ++n) {
+      uint32_t c(n);
+      for (int k(0); k < 8; ++k) c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }());
+  uint32_t crc(0xffffffffu);
+  for (size_t i(0); i < size; ++i) {
+    const unsigned char byte(data[i]);
+    crc = table[(crc ^ byte) & 0xff] ^ (crc >> 8);
+  }
+  return crc ^ 0xffffffffu;
+}
@@ -2,7 +2,10 @@
 #define BINARY_TENSOR_FORMAT_DEFINED
 
 #include <math/Complex.hpp>
+#include <util/Exception.hpp>
 #include <cstring>
+#include <string>
+#include <vector>
 #include <util/Tensor.hpp>
 
 namespace sisi4s {
@@ -18,8 +21,26 @@ public:
   int32_t reserved;
 
   static constexpr char const *MAGIC = "TENS";
-  static constexpr int32_t VERSION = 0x09000;
+  // version 1: dense data directly following the dimension headers
+  static constexpr int32_t DENSE_VERSION = 0x09000;
+  // version 2: variable chunks, a chunk index and checksummed data chunks
+  static constexpr int32_t CHUNKED_VERSION = 0x20000;
+  // version written by default, which all readers support
+  static constexpr int32_t VERSION = DENSE_VERSION;
+  // newest version that can be read
+  static constexpr int32_t LATEST_VERSION = CHUNKED_VERSION;
   static constexpr char const *IEEE = "IEEE";
+  // data stored in (index,value) pairs
+  static constexpr int32_t INDEX_VALUE_FLAG = 1;
+
+  /**
+   * \brief Returns the version of the given major version number, 1 or 2.
+   */
+  static int32_t getVersion(int64_t const majorVersion) {
+    if (majorVersion == 1) return DENSE_VERSION;
+    if (majorVersion == 2) return CHUNKED_VERSION;
+    throw new EXCEPTION("Binary tensor format version must be 1 or 2");
+  }
 
 protected:
   BinaryTensorHeaderBase() {}
@@ -58,10 +79,158 @@ public:
 
   BinaryTensorDimensionHeader() {}
   BinaryTensorDimensionHeader(int32_t length_, char indexName_)
-      : length(length_) {
+      : length(length_)
+      , flags(0)
+      , reserved(0) {
     indexName[0] = indexName_;
   }
 };
+
+/**
+ * \brief Header of each variable chunk following the dimension headers
+ * in version 2. The size includes the header and is a multiple of 8,
+ * such that unknown chunks can be skipped.
+ */
+class BinaryTensorChunkHeader {
+public:
+  char magic[8];
+  int64_t size;
+
+  static constexpr char const *SYMMETRY = "SYMMETRY";
+  static constexpr char const *INDEX = "CHUNKIDX";
+  static constexpr char const *DATA = "DATACHNK";
+
+  BinaryTensorChunkHeader() {}
+  BinaryTensorChunkHeader(char const *magic_, int64_t size_)
+      : size(size_) {
+    std::memcpy(magic, magic_, sizeof(magic));
+  }
+  bool is(char const *magic_) const {
+    return std::memcmp(magic, magic_, sizeof(magic)) == 0;
+  }
+};
+
+/**
+ * \brief Symmetry of a tensor under a permutation of its indices
+ * followed by an operation on its elements. The symmetries of CTF
+ * tensors are transpositions of adjacent indices.
+ */
+class BinaryTensorSymmetry {
+public:
+  int8_t flags;
+  // the operation on the elements, "x" or "-x"
+  std::string operation;
+  // the permuted index names
+  std::string indexMap;
+
+  // tensor data packed exploiting this symmetry
+  static constexpr int8_t PACKED_FLAG = 1;
+  // diagonal elements vanish, as for CTF's SH symmetry
+  static constexpr int8_t HOLLOW_FLAG = 2;
+
+  /**
+   * \brief Returns the symmetries of the given CTF symmetry of each
+   * dimension for the given index names.
+   */
+  static std::vector<BinaryTensorSymmetry>
+  fromCtf(int const order, int const *syms, std::string const &indexNames);
+
+  /**
+   * \brief Sets the CTF symmetry of each dimension from the given
+   * packed symmetries. Throws if a symmetry is not expressible in CTF.
+   */
+  static void toCtf(std::vector<BinaryTensorSymmetry> const &symmetries,
+                    std::string const &indexNames,
+                    int *syms);
+
+  /**
+   * \brief Returns the variable chunk of this symmetry including its header.
+   */
+  std::vector<char> encode() const;
+  /**
+   * \brief Reads the symmetry from the given variable chunk, including
+   * its header.
+   */
+  static BinaryTensorSymmetry decode(std::vector<char> const &chunk);
+};
+
+/**
+ * \brief Fixed fields of the chunk index following its chunk header.
+ * It is followed by the entry of each data chunk.
+ */
+class BinaryTensorChunkIndex {
+public:
+  int64_t elementsPerChunk;
+  int64_t chunksCount;
+};
+
+/**
+ * \brief Entry of a data chunk in the chunk index, giving its position
+ * in the file and the range of global indices it holds.
+ */
+class BinaryTensorChunkIndexEntry {
+public:
+  int64_t offset;
+  int64_t firstIndex;
+  int64_t lastIndex;
+  int64_t elementsCount;
+};
+
+/**
+ * \brief Fixed fields of a data chunk following its chunk header.
+ * They are followed by the encoded data and padding to a multiple of 8.
+ * The decoded data are the values of the consecutive global indices
+ * starting at firstIndex, or, in index-value storage, the differences
+ * of the global indices to their respective predecessor, starting with
+ * firstIndex, followed by the values.
+ */
+class BinaryTensorDataChunk {
+public:
+  int64_t firstIndex;
+  int64_t elementsCount;
+  int64_t encodedSize;
+  // CRC-32 of the encoded data
+  uint32_t checksum;
+  // the filters applied to the data
+  int32_t filters;
+};
+
+/**
+ * \brief Filters and checksum of the data chunks.
+ */
+class BinaryTensorCodec {
+public:
+  static constexpr int32_t NONE = 0;
+  // groups the i-th bytes of all words
+  static constexpr int32_t SHUFFLE = 1;
+  // replaces runs of equal bytes, applied after shuffling
+  static constexpr int32_t RUN_LENGTH = 2;
+
+  /**
+   * \brief Applies the given filters to the data in place for the given
+   * size of the words, in bytes, and returns the filters applied.
+   * Run length encoding is only applied if it reduces the size.
+   */
+  static int32_t
+  encode(std::vector<char> &data, int32_t const filters, size_t const wordSize);
+
+  /**
+   * \brief Reverts the given filters in place. Throws if the data do
+   * not decode to the given size.
+   */
+  static void decode(std::vector<char> &data,
+                     int32_t const filters,
+                     size_t const wordSize,
+                     size_t const decodedSize);
+
+  /**
+   * \brief Returns the filters given by name: none, shuffle or rle,
+   * the latter shuffling before the run length encoding.
+   */
+  static int32_t getFilters(std::string const &name);
+
+  static uint32_t getChecksum(char const *data, size_t const size);
+};
 } // namespace sisi4s
 
 #endif
@@ -0,0 +1,285 @@
+#include <util/Checkpoint.hpp>
+#include <util/TensorIo.hpp>
+#include <util/Exception.hpp>
+#include <util/Log.hpp>
+#include <Sisi4s.hpp>
+#include <vendor/filesystem.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+using namespace sisi4s;
+
+namespace fs = ghc::filesystem;
+
+namespace {
+// text of a real number from which it is read back exactly
+std::string getExactText(const Float64 x) {
+  std::stringstream text;
+  text << std::setprecision(std::numeric_limits<Float64>::max_digits10) << x;
+  return text.str();
+}
+
+YAML::Node getExactNode(const Float64 x) { return YAML::Node(getExactText(x)); }
+
+// complex numbers as list of real and imaginary part
+YAML::Node getExactNode(const Complex64 z) {
+  YAML::Node node;
+  node.push_back(getExactText(std::real(z)));
+  node.push_back(getExactText(std::imag(z)));
+  return node;
+}
+
+void readExactNode(const YAML::Node &node, Float64 &x) {
+  x = std::stod(node.as<std::string>());
+}
+
+void readExactNode(const YAML::Node &node, Complex64 &z) {
+  z = Complex64(std::stod(node[0].as<std::string>()),
+                std::stod(node[1].as<std::string>()));
+}
+} // namespace
+
+Checkpoint::Checkpoint(const std::string &directory_, const std::string &name_)
+    : directory(directory_)
+    , name(name_)
+    , generation(0) {}
+
+std::string Checkpoint::getFileName() const {
+  return directory + "/" + name + "-checkpoint.yaml";
+}
+
+bool Checkpoint::load() {
+  // the root reads the yaml file for all processes
+  std::string text;
+  int64_t size(-1);
+  if (Sisi4s::world->rank == 0) {
+    std::ifstream file(getFileName().c_str());
+    if (file) {
+      std::stringstream stream;
+      stream << file.rdbuf();
+      text = stream.str();
+      size = text.size();
+    }
+  }
+  MPI_Bcast(&size, 1, MPI_INT64_T, 0, Sisi4s::world->comm);
+  if (size < 0) return false;
+  text.resize(size);
+  MPI_Bcast(&text[0], size, MPI_CHAR, 0, Sisi4s::world->comm);
+  node = YAML::Load(text);
+  generation = node["generation"].as<int64_t>();
+  LOG(1, "Checkpoint") << "loaded " << getFileName() << ", generation "
+                       << generation << std::endl;
+  return true;
+}
+
+void Checkpoint::begin() {
+  previousFiles.clear();
+  for (auto const &tensor : node["tensors"]) {
+    previousFiles.push_back(tensor.second.as<std::string>());
+  }
+  node = YAML::Node();
+  node["generation"] = ++generation;
+  if (Sisi4s::world->rank == 0) fs::create_directories(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+}
+
+void Checkpoint::commit() {
+  // all tensors are written
+  MPI_Barrier(Sisi4s::world->comm);
+  const std::string fileName(getFileName());
+  // 1 if writing, 2 if replacing the checkpoint failed on the root
+  int failure(0);
+  if (Sisi4s::world->rank == 0) {
+    {
+      YAML::Emitter emitter;
+      emitter << node;
+      std::ofstream file((fileName + ".tmp").c_str());
+      file << emitter.c_str() << std::endl;
+      if (!file) failure = 1;
+    }
+    // atomically replace the previous checkpoint
+    if (failure == 0
+        && std::rename((fileName + ".tmp").c_str(), fileName.c_str()) != 0) {
+      failure = 2;
+    }
+    if (failure == 0) {
+      for (auto const &file : previousFiles) {
+        std::remove((directory + "/" + file).c_str());
+      }
+    }
+  }
+  // all processes fail together
+  MPI_Bcast(&failure, 1, MPI_INT, 0, Sisi4s::world->comm);
+  if (failure == 1) {
+    throw new EXCEPTION("Failed to write checkpoint " + fileName);
+  }
+  if (failure == 2) {
+    throw new EXCEPTION("Failed to replace checkpoint " + fileName);
+  }
+  previousFiles.clear();
+  LOG(1, "Checkpoint") << "wrote " << fileName << ", generation " << generation
+                       << std::endl;
+}
+
+void Checkpoint::remove() {
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) {
+    for (auto const &tensor : node["tensors"]) {
+      std::remove((directory + "/" + tensor.second.as<std::string>()).c_str());
+    }
+    std::remove(getFileName().c_str());
+  }
+  node = YAML::Node();
+  previousFiles.clear();
+  MPI_Barrier(Sisi4s::world->comm);
+  LOG(1, "Checkpoint") << "removed " << getFileName() << std::endl;
+}
+
+YAML::Node Checkpoint::getEntry(const std::string &section,
+                                const std::string &key) const {
+  const YAML::Node entries(node[section]);
+  return entries && entries.IsMap() ? entries[key]
+                                    : YAML::Node(YAML::NodeType::Undefined);
+}
+
+bool Checkpoint::has(const std::string &key) const {
+  return getEntry("values", key) || getEntry("tensors", key)
+      || getEntry("fock-vectors", key);
+}
+
+YAML::Node Checkpoint::getValue(const std::string &key) const {
+  const YAML::Node value(getEntry("values", key));
+  if (!value) {
+    throw new EXCEPTION("Value " + key + " missing in checkpoint "
+                        + getFileName());
+  }
+  return value;
+}
+
+void Checkpoint::setInteger(const std::string &key, const int64_t value) {
+  node["values"][key] = value;
+}
+
+int64_t Checkpoint::getInteger(const std::string &key) const {
+  return getValue(key).as<int64_t>();
+}
+
+template <typename F>
+void Checkpoint::setScalar(const std::string &key, const F value) {
+  node["values"][key] = getExactNode(value);
+}
+
+template <typename F>
+F Checkpoint::getScalar(const std::string &key) const {
+  F value;
+  readExactNode(getValue(key), value);
+  return value;
+}
+
+template <typename F>
+void Checkpoint::setScalars(const std::string &key,
+                            const std::vector<F> &values) {
+  YAML::Node list(YAML::NodeType::Sequence);
+  for (auto const &value : values) list.push_back(getExactNode(value));
+  node["values"][key] = list;
+}
+
+template <typename F>
+std::vector<F> Checkpoint::getScalars(const std::string &key) const {
+  const YAML::Node list(getValue(key));
+  std::vector<F> values(list.size());
+  for (size_t i(0); i < values.size(); ++i) readExactNode(list[i], values[i]);
+  return values;
+}
+
+template <typename F>
+void Checkpoint::writeTensor(const std::string &key, Tensor<F> &T) {
+  std::stringstream file;
+  file << name << "-" << generation << "-" << key << ".bin";
+  // unfiltered for speed
+  TensorIo::writeBinary<F>(directory + "/" + file.str(),
+                           T,
+                           BinaryTensorHeaderBase::CHUNKED_VERSION,
+                           0);
+  node["tensors"][key] = file.str();
+}
+
+template <typename F>
+PTR(Tensor<F>) Checkpoint::readTensor(const std::string &key) {
+  const YAML::Node file(getEntry("tensors", key));
+  if (!file) {
+    throw new EXCEPTION("Tensor " + key + " missing in checkpoint "
+                        + getFileName());
+  }
+  return PTR(Tensor<F>)(
+      TensorIo::readBinary<F>(directory + "/" + file.as<std::string>()));
+}
+
+template <typename F>
+void Checkpoint::writeFockVector(const std::string &key,
+                                 const FockVector<F> &v) {
+  for (size_t i(0); i < v.component_tensors.size(); ++i) {
+    std::stringstream componentKey;
+    componentKey << key << "-" << i;
+    writeTensor<F>(componentKey.str(), *v.get(i));
+    node["fock-vectors"][key].push_back(v.get_indices(i));
+  }
+}
+
+template <typename F>
+PTR(FockVector<F>) Checkpoint::readFockVector(const std::string &key) {
+  const YAML::Node components(getEntry("fock-vectors", key));
+  if (!components) {
+    throw new EXCEPTION("Vector " + key + " missing in checkpoint "
+                        + getFileName());
+  }
+  std::vector<PTR(Tensor<F>)> tensors;
+  std::vector<std::string> indices;
+  for (auto const &componentIndices : components) {
+    std::stringstream componentKey;
+    componentKey << key << "-" << tensors.size();
+    tensors.push_back(readTensor<F>(componentKey.str()));
+    indices.push_back(componentIndices.as<std::string>());
+  }
+  return NEW(FockVector<F>, tensors, indices);
+}
+
+// instantiate
+template void Checkpoint::setScalar<Float64>(const std::string &key,
+                                             const Float64 value);
+template void Checkpoint::setScalar<Complex64>(const std::string &key,
+                                               const Complex64 value);
+template Float64 Checkpoint::getScalar<Float64>(const std::string &key) const;
+template Complex64
+Checkpoint::getScalar<Complex64>(const std::string &key) const;
+template void
+Checkpoint::setScalars<Float64>(const std::string &key,
+                                const std::vector<Float64> &values);
+template void
+Checkpoint::setScalars<Complex64>(const std::string &key,
+                                  const std::vector<Complex64> &values);
+template std::vector<Float64>
+Checkpoint::getScalars<Float64>(const std::string &key) const;
+template std::vector<Complex64>
+Checkpoint::getScalars<Complex64>(const std::string &key) const;
+template void Checkpoint::writeTensor<Float64>(const std::string &key,
+                                               Tensor<Float64> &T);
+template void Checkpoint::writeTensor<Complex64>(const std::string &key,
+                                                 Tensor<Complex64> &T);
+template PTR(Tensor<Float64>)
+    Checkpoint::readTensor<Float64>(const std::string &key);
+template PTR(Tensor<Complex64>)
+    Checkpoint::readTensor<Complex64>(const std::string &key);
+template void
+Checkpoint::writeFockVector<Float64>(const std::string &key,
+                                     const FockVector<Float64> &v);
+template void
+Checkpoint::writeFockVector<Complex64>(const std::string &key,
+                                       const FockVector<Complex64> &v);
+template PTR(FockVector<Float64>)
+    Checkpoint::readFockVector<Float64>(const std::string &key);
+template PTR(FockVector<Complex64>)
+    Checkpoint::readFockVector<Complex64>(const std::string &key);
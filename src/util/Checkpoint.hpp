@@ -0,0 +1,102 @@
+#ifndef CHECKPOINT_DEFINED
+#define CHECKPOINT_DEFINED
+
+#include <math/FockVector.hpp>
+#include <util/SharedPointer.hpp>
+#include <util/Tensor.hpp>
+#include <util/Yaml.hpp>
+
+#include <string>
+#include <vector>
+
+namespace sisi4s {
+/**
+ * \brief Checkpoint of the state of an iterative algorithm in a directory.
+ * The tensors are written in parallel in the binary tensor format, the
+ * scalars to a yaml file also listing the tensor files. The yaml file is
+ * replaced atomically after all tensors are written, such that an
+ * interrupted write leaves the previous checkpoint intact.
+ */
+class Checkpoint {
+public:
+  /**
+   * \brief Checkpoint of the given name, e.g. the algorithm's abbreviation,
+   * in the given directory.
+   */
+  Checkpoint(const std::string &directory, const std::string &name);
+
+  /**
+   * \brief Loads the last committed checkpoint, if any.
+   * Returns whether there is one.
+   */
+  bool load();
+
+  /**
+   * \brief Begins writing a new checkpoint. The previous one remains
+   * valid until commit.
+   */
+  void begin();
+
+  /**
+   * \brief Makes the written checkpoint the current one and removes the
+   * files of the previous one.
+   */
+  void commit();
+
+  /**
+   * \brief Removes the current checkpoint and its files, e.g. after
+   * the iterations have converged.
+   */
+  void remove();
+
+  bool has(const std::string &key) const;
+
+  void setInteger(const std::string &key, const int64_t value);
+  int64_t getInteger(const std::string &key) const;
+
+  /**
+   * \brief Stores the given scalar exactly.
+   */
+  template <typename F>
+  void setScalar(const std::string &key, const F value);
+  template <typename F>
+  F getScalar(const std::string &key) const;
+
+  /**
+   * \brief Stores the given scalars exactly, e.g. a small matrix.
+   */
+  template <typename F>
+  void setScalars(const std::string &key, const std::vector<F> &values);
+  template <typename F>
+  std::vector<F> getScalars(const std::string &key) const;
+
+  template <typename F>
+  void writeTensor(const std::string &key, Tensor<F> &T);
+  template <typename F>
+  PTR(Tensor<F>) readTensor(const std::string &key);
+
+  template <typename F>
+  void writeFockVector(const std::string &key, const FockVector<F> &v);
+  template <typename F>
+  PTR(FockVector<F>) readFockVector(const std::string &key);
+
+  /**
+   * \brief The yaml file of the checkpoint.
+   */
+  std::string getFileName() const;
+
+protected:
+  // the entry of the given section or an undefined node
+  YAML::Node getEntry(const std::string &section, const std::string &key) const;
+  // the given value, throws if missing
+  YAML::Node getValue(const std::string &key) const;
+
+  std::string directory, name;
+  int64_t generation;
+  YAML::Node node;
+  // tensor files of the previous checkpoint to remove upon commit
+  std::vector<std::string> previousFiles;
+};
+} // namespace sisi4s
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef MAPPED_FILE_DEFINED
+#define MAPPED_FILE_DEFINED
+
+#include <util/Exception.hpp>
+
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sisi4s {
+
+/**
+ * \brief Read only memory mapping of an entire file.
+ * The file is unmapped when the object goes out of scope.
+ */
+class MappedFile {
+public:
+  MappedFile(const std::string &fileName)
+      : data(nullptr)
+      , size(0) {
+    const int fd(open(fileName.c_str(), O_RDONLY));
+    if (fd < 0) throw new EXCEPTION("Could not open file " + fileName);
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+      close(fd);
+      throw new EXCEPTION("Could not stat file " + fileName);
+    }
+    size = status.st_size;
+    if (size > 0) {
+      void *address(mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0));
+      if (address == MAP_FAILED) {
+        close(fd);
+        throw new EXCEPTION("Could not map file " + fileName);
+      }
+      data = static_cast<const char *>(address);
+      // the file is mostly read front to back
+      madvise(address, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (data) munmap(const_cast<char *>(data), size);
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *begin() const { return data; }
+  const char *end() const { return data + size; }
+  size_t getSize() const { return size; }
+
+protected:
+  const char *data;
+  size_t size;
+};
+
+} // namespace sisi4s
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef NUMBER_PARSER_DEFINED
+#define NUMBER_PARSER_DEFINED
+
+#include <math/Float.hpp>
+#include <math/Complex.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace sisi4s {
+
+inline bool isNumberSeparator(const char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+/**
+ * \brief Parses the real number starting at p, not reading beyond end,
+ * and advances p past it. Returns false if there is no number at p.
+ * Decimal numbers with at most 19 significant digits whose mantissa
+ * and power of ten are exactly representable are converted directly,
+ * all others are converted by strtod, both correctly rounded.
+ */
+inline bool parseNumber(const char *&p, const char *end, Float64 &x) {
+  static const Float64 powersOfTen[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                        1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                        1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                        1e18, 1e19, 1e20, 1e21, 1e22};
+  const char *begin(p), *c(p);
+  bool negative(false);
+  if (c < end && (*c == '-' || *c == '+')) negative = *c++ == '-';
+  uint64_t mantissa(0);
+  int digits(0), exponent(0);
+  bool anyDigit(false), exact(true);
+  for (; c < end && *c >= '0' && *c <= '9'; ++c) {
+    anyDigit = true;
+    if (digits < 19) {
+      mantissa = 10 * mantissa + (*c - '0');
+      digits += mantissa > 0;
+    } else {
+      ++exponent;
+      exact = false;
+    }
+  }
+  if (c < end && *c == '.') {
+    for (++c; c < end && *c >= '0' && *c <= '9'; ++c) {
+      anyDigit = true;
+      if (digits < 19) {
+        mantissa = 10 * mantissa + (*c - '0');
+        digits += mantissa > 0;
+        --exponent;
+      } else {
+        exact = false;
+      }
+    }
+  }
+  if (anyDigit && c < end && (*c == 'e' || *c == 'E')) {
+    const char *e(c + 1);
+    bool negativeExponent(false);
+    if (e < end && (*e == '-' || *e == '+')) negativeExponent = *e++ == '-';
+    if (e < end && *e >= '0' && *e <= '9') {
+      int n(0);
+      for (; e < end && *e >= '0' && *e <= '9'; ++e) {
+        if (n < 100000) n = 10 * n + (*e - '0');
+      }
+      exponent += negativeExponent ? -n : n;
+      c = e;
+    }
+  }
+  const bool terminated(c == end || isNumberSeparator(*c) || *c == ','
+                        || *c == ')');
+  if (anyDigit && terminated && exact && mantissa <= (uint64_t(1) << 53)
+      && exponent >= -22 && exponent <= 22) {
+    const Float64 m(static_cast<Float64>(mantissa));
+    x = exponent < 0 ? m / powersOfTen[-exponent] : m * powersOfTen[exponent];
+    if (negative) x = -x;
+    p = c;
+    return true;
+  }
+
+  // general case, including inf and nan: copy the token for strtod,
+  // which must not read beyond end
+  const char *tokenEnd(begin);
+  while (tokenEnd < end && !isNumberSeparator(*tokenEnd) && *tokenEnd != ','
+         && *tokenEnd != ')') {
+    ++tokenEnd;
+  }
+  const size_t length(tokenEnd - begin);
+  if (length == 0) return false;
+  const std::string token(begin, length);
+  char *tokenParsed;
+  x = std::strtod(token.c_str(), &tokenParsed);
+  if (tokenParsed == token.c_str()) return false;
+  p = begin + (tokenParsed - token.c_str());
+  return true;
+}
+
+/**
+ * \brief Parses a complex number written as (real,imag).
+ */
+inline bool parseNumber(const char *&p, const char *end, Complex<Float64> &z) {
+  const char *c(p);
+  if (c < end && *c == '(') ++c;
+  Float64 r, i;
+  if (!parseNumber(c, end, r) || c == end || *c != ',') return false;
+  ++c;
+  if (!parseNumber(c, end, i)) return false;
+  if (c < end && *c == ')') ++c;
+  z = Complex<Float64>(r, i);
+  p = c;
+  return true;
+}
+
+} // namespace sisi4s
+
+#endif
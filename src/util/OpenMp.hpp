@@ -0,0 +1,36 @@
+#ifndef OPEN_MP_DEFINED
+#define OPEN_MP_DEFINED
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
+namespace sisi4s {
+
+/**
+ * \brief Maximal number of OpenMP threads of a parallel region,
+ * 1 if compiled without OpenMP.
+ */
+inline int getMaxThreads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/**
+ * \brief Index of the calling thread within the current parallel region,
+ * 0 if compiled without OpenMP.
+ */
+inline int getThreadNumber() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+} // namespace sisi4s
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef SCHWARZ_SCREENING_DEFINED
+#define SCHWARZ_SCREENING_DEFINED
+
+#include <util/Libint.hpp>
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+namespace sisi4s {
+
+/**
+ * \brief Schwarz bounds for shell quartets of two-electron integrals.
+ *
+ * For every shell pair (P,Q) the bound
+ *   Q(P,Q) = sqrt( max_{pq in PQ} |(pq|pq)| )
+ * is precomputed, such that |(pq|rs)| <= Q(P,Q) Q(R,S) for every
+ * function quartet in the shell quartet (PQ|RS).
+ * Optionally, the bounds can be weighted by the largest density matrix
+ * element entering the Fock matrix through the quartet.
+ */
+class SchwarzScreening {
+public:
+  SchwarzScreening(const libint2::BasisSet &shells_,
+                   const libint2::Operator op,
+                   const double threshold_)
+      : nShells(shells_.size())
+      , threshold(threshold_)
+      , bounds(nShells * nShells, 0.0)
+      , densityBounds(nShells * nShells, 1.0)
+      , shells(shells_) {
+    libint2::Engine engine(op, shells.max_nprim(), shells.max_l(), 0);
+    const auto &buffer = engine.results();
+    for (size_t P(0); P < nShells; P++) {
+      for (size_t Q(0); Q <= P; Q++) {
+        engine.compute(shells[P], shells[Q], shells[P], shells[Q]);
+        double maximum(0.0);
+        if (buffer[0] != nullptr) {
+          const size_t nP(shells[P].size()), nQ(shells[Q].size()),
+              nPQ(nP * nQ);
+          // diagonal elements (pq|pq) of the nPQ x nPQ block
+          for (size_t pq(0); pq < nPQ; pq++) {
+            maximum = std::max(maximum, std::abs(buffer[0][pq * nPQ + pq]));
+          }
+        }
+        bounds[P * nShells + Q] = bounds[Q * nShells + P] = std::sqrt(maximum);
+      }
+    }
+  }
+
+  /**
+   * \brief Sets the density weights from a (symmetric) density matrix
+   * in the basis function representation. D must provide D(p,q).
+   */
+  template <typename M>
+  void setDensity(const M &D) {
+    const auto &shell2bf(shells.shell2bf());
+    for (size_t P(0); P < nShells; P++) {
+      for (size_t Q(0); Q <= P; Q++) {
+        double maximum(0.0);
+        for (size_t p(shell2bf[P]); p < shell2bf[P] + shells[P].size(); p++) {
+          for (size_t q(shell2bf[Q]); q < shell2bf[Q] + shells[Q].size();
+               q++) {
+            maximum = std::max(maximum, std::abs(D(p, q)));
+          }
+        }
+        densityBounds[P * nShells + Q] = densityBounds[Q * nShells + P] =
+            maximum;
+      }
+    }
+  }
+
+  double getBound(const size_t P, const size_t Q) const {
+    return bounds[P * nShells + Q];
+  }
+
+  double getThreshold() const { return threshold; }
+
+  /**
+   * \brief Whether the shell quartet (PQ|RS) may contain integrals
+   * larger than the threshold.
+   */
+  bool isSignificant(const size_t P,
+                     const size_t Q,
+                     const size_t R,
+                     const size_t S) const {
+    return getBound(P, Q) * getBound(R, S) >= threshold;
+  }
+
+  /**
+   * \brief Whether the shell quartet (PQ|RS) may contribute more than
+   * the threshold to a Coulomb or exchange Fock matrix element,
+   * using the density weights given with setDensity.
+   */
+  bool isSignificantWeighted(const size_t P,
+                             const size_t Q,
+                             const size_t R,
+                             const size_t S) const {
+    const double d(std::max({density(P, Q),
+                             density(R, S),
+                             density(P, R),
+                             density(P, S),
+                             density(Q, R),
+                             density(Q, S)}));
+    return getBound(P, Q) * getBound(R, S) * d >= threshold;
+  }
+
+protected:
+  double density(const size_t P, const size_t Q) const {
+    return densityBounds[P * nShells + Q];
+  }
+
+  const size_t nShells;
+  const double threshold;
+  std::vector<double> bounds, densityBounds;
+  const libint2::BasisSet &shells;
+};
+
+/**
+ * \brief Returns the distinct shell quartets related to (KL|MN) by the
+ * 8-fold permutational symmetry of real two-electron integrals
+ * (kl|mn) = (lk|mn) = (kl|nm) = (lk|nm) = (mn|kl) = (nm|kl) = (mn|lk)
+ * = (nm|lk).
+ * Every entry holds the permutation of the positions, i.e. the
+ * quartet (a[0] a[1]|a[2] a[3]) of the image corresponds to the
+ * positions (a[p[0]] a[p[1]]|a[p[2]] a[p[3]]) of (KL|MN).
+ */
+inline std::vector<std::array<size_t, 4>> getDistinctQuartetPermutations(
+    const size_t K, const size_t L, const size_t M, const size_t N) {
+  static const std::array<std::array<size_t, 4>, 8> permutations = {{
+      {{0, 1, 2, 3}},
+      {{1, 0, 2, 3}},
+      {{0, 1, 3, 2}},
+      {{1, 0, 3, 2}},
+      {{2, 3, 0, 1}},
+      {{3, 2, 0, 1}},
+      {{2, 3, 1, 0}},
+      {{3, 2, 1, 0}},
+  }};
+  const std::array<size_t, 4> quartet = {{K, L, M, N}};
+  std::vector<std::array<size_t, 4>> images, result;
+  for (const auto &p : permutations) {
+    const std::array<size_t, 4> image = {
+        {quartet[p[0]], quartet[p[1]], quartet[p[2]], quartet[p[3]]}};
+    if (std::find(images.begin(), images.end(), image) != images.end()) {
+      continue;
+    }
+    images.push_back(image);
+    result.push_back(p);
+  }
+  return result;
+}
+
+} // namespace sisi4s
+
+#endif
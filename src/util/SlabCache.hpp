@@ -0,0 +1,211 @@
+#ifndef SLAB_CACHE_DEFINED
+#define SLAB_CACHE_DEFINED
+
+#include <util/Exception.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sisi4s {
+
+/**
+ * \brief Least recently used cache of equally sized slabs of a binary file,
+ * e.g. the Nv^3 slabs V[abc](i) of the PPPH integrals for each i.
+ * The file is kept open and slabs are read with pread by a background
+ * thread, such that slabs requested with prefetch are read while the
+ * caller works on the slabs it has acquired.
+ * Acquired slabs are pinned and not evicted until released.
+ */
+template <typename F>
+class SlabCache {
+public:
+  /**
+   * \brief Creates a cache of at most capacity slabs of slabSize elements
+   * each, where slab s starts at byte dataOffset + s*slabSize*sizeof(F).
+   */
+  SlabCache(const std::string &fileName,
+            const int64_t dataOffset_,
+            const size_t slabSize_,
+            const size_t capacity_)
+      : dataOffset(dataOffset_)
+      , slabSize(slabSize_)
+      , capacity(std::max<size_t>(capacity_, 1))
+      , reads(0)
+      , hits(0)
+      , stop(false)
+      , failed(false) {
+    fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) throw new EXCEPTION("Could not open file " + fileName);
+    reader = std::thread(&SlabCache::readLoop, this);
+  }
+
+  ~SlabCache() {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      stop = true;
+    }
+    requested.notify_all();
+    released.notify_all();
+    reader.join();
+    close(fd);
+  }
+
+  SlabCache(const SlabCache &) = delete;
+  SlabCache &operator=(const SlabCache &) = delete;
+
+  /**
+   * \brief Returns the slab s, waiting until it has been read.
+   * The slab stays valid until it is released.
+   */
+  const F *acquire(const int64_t s) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it(slabs.find(s));
+    if (it != slabs.end()) {
+      ++hits;
+    } else {
+      // read it next
+      queue.push_front(s);
+      requested.notify_all();
+    }
+    // keep it from being evicted until it is pinned
+    ++waiting[s];
+    loaded.wait(lock, [&] { return failed || slabs.count(s) > 0; });
+    if (--waiting[s] == 0) waiting.erase(s);
+    if (failed) throw new EXCEPTION("Could not read slab from file");
+    Slab &slab(slabs[s]);
+    ++slab.pins;
+    touch(s, slab);
+    loaded.wait(lock, [&] { return failed || slab.ready; });
+    if (failed) throw new EXCEPTION("Could not read slab from file");
+    return slab.data.data();
+  }
+
+  void release(const int64_t s) {
+    std::unique_lock<std::mutex> lock(mutex);
+    auto it(slabs.find(s));
+    if (it != slabs.end() && it->second.pins > 0) --it->second.pins;
+    lock.unlock();
+    // a waiting read may now evict it
+    released.notify_all();
+  }
+
+  /**
+   * \brief Requests the given slabs to be read in the background,
+   * in the given order.
+   */
+  void prefetch(const std::vector<int64_t> &s) {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (const auto slab : s) {
+      if (!slabs.count(slab)) queue.push_back(slab);
+    }
+    requested.notify_all();
+  }
+
+  size_t getCapacity() const { return capacity; }
+  // number of slabs read from the file
+  size_t getReads() const { return reads; }
+  // number of acquired slabs found in the cache
+  size_t getHits() const { return hits; }
+
+protected:
+  struct Slab {
+    std::vector<F> data;
+    bool ready = false;
+    int pins = 0;
+    std::list<int64_t>::iterator position;
+  };
+
+  void touch(const int64_t s, Slab &slab) {
+    lru.erase(slab.position);
+    slab.position = lru.insert(lru.end(), s);
+  }
+
+  void readLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      requested.wait(lock, [&] { return stop || !queue.empty(); });
+      if (stop) return;
+      const int64_t s(queue.front());
+      queue.pop_front();
+      if (slabs.count(s)) continue;
+
+      // evict the least recently used unpinned slab, reusing its memory
+      std::vector<F> data;
+      if (slabs.size() >= capacity) {
+        auto victim(lru.end());
+        released.wait(lock, [&] {
+          if (stop) return true;
+          for (victim = lru.begin(); victim != lru.end(); ++victim) {
+            const Slab &candidate(slabs[*victim]);
+            if (candidate.pins == 0 && candidate.ready
+                && !waiting.count(*victim)) {
+              return true;
+            }
+          }
+          return false;
+        });
+        if (stop) return;
+        data.swap(slabs[*victim].data);
+        slabs.erase(*victim);
+        lru.erase(victim);
+      }
+      data.resize(slabSize);
+      Slab &slab(slabs[s]);
+      slab.position = lru.insert(lru.end(), s);
+      loaded.notify_all();
+
+      // read without holding the lock, the slab is not ready yet
+      lock.unlock();
+      const size_t bytes(slabSize * sizeof(F));
+      const int64_t offset(dataOffset + s * int64_t(bytes));
+      char *buffer(reinterpret_cast<char *>(data.data()));
+      bool success(true);
+      for (size_t done(0); done < bytes && success;) {
+        const ssize_t n(pread(fd, buffer + done, bytes - done, offset + done));
+        success = n > 0;
+        done += success ? n : 0;
+      }
+      lock.lock();
+      if (!success) {
+        // report to the waiting callers and stop reading
+        failed = true;
+        loaded.notify_all();
+        return;
+      }
+      slab.data.swap(data);
+      slab.ready = true;
+      ++reads;
+      loaded.notify_all();
+    }
+  }
+
+  const int64_t dataOffset;
+  const size_t slabSize, capacity;
+  size_t reads, hits;
+  int fd;
+  bool stop, failed;
+  std::map<int64_t, Slab> slabs;
+  // number of callers waiting for each slab to enter the cache
+  std::map<int64_t, int> waiting;
+  // slabs from least to most recently used
+  std::list<int64_t> lru;
+  // slabs to be read
+  std::deque<int64_t> queue;
+  std::mutex mutex;
+  std::condition_variable requested, loaded, released;
+  std::thread reader;
+};
+
+} // namespace sisi4s
+
+#endif
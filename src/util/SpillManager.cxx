@@ -0,0 +1,171 @@
+#include <util/SpillManager.hpp>
+#include <util/TensorIo.hpp>
+#include <util/Timer.hpp>
+#include <util/Log.hpp>
+#include <util/Exception.hpp>
+#include <Sisi4s.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <sstream>
+
+using namespace sisi4s;
+
+int64_t SpillManager::budget(0);
+std::string SpillManager::directory(".");
+std::vector<std::set<std::string>> SpillManager::stepUses;
+std::map<std::string, std::string> SpillManager::spillFiles;
+int64_t SpillManager::nextSpillId(0);
+SpillManager::Statistics SpillManager::statistics;
+
+void SpillManager::configure(
+    const int64_t budget_,
+    const std::string &directory_,
+    const std::vector<std::set<std::string>> &stepUses_) {
+  budget = budget_;
+  directory = directory_;
+  stepUses = stepUses_;
+}
+
+namespace {
+// size of the resident tensor in bytes, or -1 if data is no resident tensor
+template <typename F>
+int64_t getResidentBytes(Data *data, bool &spillable) {
+  auto tensorData(dynamic_cast<TensorData<F> *>(data));
+  if (!tensorData || !tensorData->value) return -1;
+  int64_t elements(1);
+  spillable = tensorData->value->order > 0;
+  for (int d(0); d < tensorData->value->order; ++d) {
+    elements *= tensorData->value->lens[d];
+  }
+  return elements * sizeof(F);
+}
+} // namespace
+
+void SpillManager::beforeStep(const size_t step) {
+  if (budget <= 0) return;
+  struct Candidate {
+    Data *data;
+    int64_t bytes;
+    size_t nextUse;
+  };
+  std::vector<Candidate> candidates;
+  int64_t residentBytes(0);
+  for (const auto &entry : Data::getDataMap()) {
+    if (!entry.second) continue;
+    bool spillable(false);
+    int64_t bytes(getResidentBytes<real>(entry.second, spillable));
+    if (bytes < 0) bytes = getResidentBytes<complex>(entry.second, spillable);
+    if (bytes < 0) continue;
+    residentBytes += bytes;
+    if (!spillable || stepUses[step].count(entry.first)) continue;
+    size_t nextUse(step + 1);
+    while (nextUse < stepUses.size() && !stepUses[nextUse].count(entry.first))
+      ++nextUse;
+    if (nextUse == stepUses.size()) nextUse = std::numeric_limits<size_t>::max();
+    candidates.push_back({entry.second, bytes, nextUse});
+  }
+  if (residentBytes <= budget) return;
+
+  // spill the tensors needed latest first, the largest first among those
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.nextUse != b.nextUse ? a.nextUse > b.nextUse
+                                            : a.bytes > b.bytes;
+            });
+  for (const auto &candidate : candidates) {
+    if (residentBytes <= budget) break;
+    int64_t bytes;
+    if (spill<real>(candidate.data, bytes)
+        || spill<complex>(candidate.data, bytes)) {
+      residentBytes -= bytes;
+    }
+  }
+  if (residentBytes > budget) {
+    LOG(0, "SpillManager") << "Warning: resident tensors exceed the budget, "
+                           << "memory="
+                           << residentBytes / (1024.0 * 1024.0 * 1024.0)
+                           << " GB" << std::endl;
+  }
+}
+
+template <typename F>
+bool SpillManager::spill(Data *data, int64_t &bytes) {
+  auto tensorData(dynamic_cast<TensorData<F> *>(data));
+  if (!tensorData || !tensorData->value) return false;
+  bool spillable;
+  bytes = getResidentBytes<F>(data, spillable);
+  std::stringstream fileName;
+  fileName << directory << "/spill-" << nextSpillId++ << "-"
+           << data->getName() << ".bin";
+  Time time;
+  {
+    Timer timer(&time);
+    // scratch files are written unfiltered for speed, symmetric
+    // tensors packed
+    TensorIo::writeBinary<F>(fileName.str(),
+                             *tensorData->value,
+                             BinaryTensorHeaderBase::CHUNKED_VERSION,
+                             0);
+  }
+  delete tensorData->value;
+  tensorData->value = nullptr;
+  data->setStage(Data::LINGERING);
+  spillFiles[data->getName()] = fileName.str();
+  LOG(1, "SpillManager") << "spilled " << data->getName() << " to "
+                         << fileName.str() << ", memory="
+                         << bytes / (1024.0 * 1024.0 * 1024.0) << " GB"
+                         << std::endl;
+  ++statistics.spills;
+  statistics.spilledBytes += bytes;
+  statistics.spillSeconds += time.getFractionalSeconds();
+  return true;
+}
+
+template <typename F>
+void SpillManager::reload(TensorData<F, Tensor<F>> *data) {
+  auto file(spillFiles.find(data->getName()));
+  if (file == spillFiles.end()) {
+    throw new EXCEPTION("Tensor " + data->getName() + " is not allocated");
+  }
+  Time time;
+  {
+    Timer timer(&time);
+    data->value = TensorIo::readBinary<F>(file->second);
+  }
+  data->value->set_name(data->getName().c_str());
+  data->setStage(Data::READY);
+  bool spillable;
+  const int64_t bytes(getResidentBytes<F>(data, spillable));
+  LOG(1, "SpillManager") << "reloaded " << data->getName() << ", memory="
+                         << bytes / (1024.0 * 1024.0 * 1024.0) << " GB"
+                         << std::endl;
+  ++statistics.reloads;
+  statistics.reloadedBytes += bytes;
+  statistics.reloadSeconds += time.getFractionalSeconds();
+  forget(data->getName());
+}
+
+void SpillManager::forget(const std::string &name) {
+  auto file(spillFiles.find(name));
+  if (file == spillFiles.end()) return;
+  // all processes are done with the file
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) std::remove(file->second.c_str());
+  spillFiles.erase(file);
+}
+
+void SpillManager::cleanup() {
+  while (!spillFiles.empty()) forget(spillFiles.begin()->first);
+}
+
+SpillManager::Statistics SpillManager::takeStatistics() {
+  Statistics result(statistics);
+  statistics = Statistics();
+  return result;
+}
+
+// instantiate
+template void SpillManager::reload<Float64>(TensorData<Float64> *);
+template void SpillManager::reload<Complex64>(TensorData<Complex64> *);
@@ -0,0 +1,87 @@
+#ifndef SPILL_MANAGER_DEFINED
+#define SPILL_MANAGER_DEFINED
+
+#include <Data.hpp>
+#include <DryTensor.hpp>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace sisi4s {
+
+/**
+ * \brief Writes tensors not needed by the upcoming steps of the execution
+ * plan to scratch files when the resident tensors exceed a memory budget.
+ * Spilled tensors keep their TensorData with a null value and the stage
+ * LINGERING. They are read back when retrieved by getTensorArgument.
+ */
+class SpillManager {
+public:
+  /**
+   * \brief Volumes and timings of spilling and reloading.
+   */
+  struct Statistics {
+    int64_t spills = 0, spilledBytes = 0;
+    int64_t reloads = 0, reloadedBytes = 0;
+    double spillSeconds = 0.0, reloadSeconds = 0.0;
+  };
+
+  /**
+   * \brief Enables spilling for the given memory budget of all resident
+   * tensors in bytes, summed over all processes, and scratch directory.
+   * The data names used by each step of the execution plan are given
+   * to decide which tensors are needed next.
+   */
+  static void configure(const int64_t budget,
+                        const std::string &directory,
+                        const std::vector<std::set<std::string>> &stepUses);
+
+  /**
+   * \brief Spills the tensors needed latest, or not at all, by the
+   * upcoming steps until the resident tensors fit the budget.
+   * Tensors used by the given step are never spilled.
+   */
+  static void beforeStep(const size_t step);
+
+  /**
+   * \brief Reads back the value of the spilled tensor data.
+   */
+  template <typename F>
+  static void reload(TensorData<F, Tensor<F>> *data);
+  // dry tensors are never spilled
+  template <typename F>
+  static void reload(TensorData<F, DryTensor<F>> *) {}
+
+  /**
+   * \brief Removes the scratch file of the data of the given name,
+   * if spilled, since the data is no longer needed.
+   */
+  static void forget(const std::string &name);
+
+  /**
+   * \brief Removes all remaining scratch files.
+   */
+  static void cleanup();
+
+  /**
+   * \brief Returns and resets the statistics since the last call.
+   */
+  static Statistics takeStatistics();
+
+protected:
+  template <typename F>
+  static bool spill(Data *data, int64_t &bytes);
+
+  static int64_t budget;
+  static std::string directory;
+  static std::vector<std::set<std::string>> stepUses;
+  // scratch file of each spilled data
+  static std::map<std::string, std::string> spillFiles;
+  static int64_t nextSpillId;
+  static Statistics statistics;
+};
+
+} // namespace sisi4s
+
+#endif
@@ -1,14 +1,505 @@
 #include <util/TensorIo.hpp>
 #include <util/BinaryTensorFormat.hpp>
 #include <util/Scanner.hpp>
+#include <util/MappedFile.hpp>
+#include <util/NumberParser.hpp>
+#include <util/OpenMp.hpp>
+#include <util/SharedPointer.hpp>
 #include <util/Log.hpp>
 #include <Sisi4s.hpp>
 #include <fstream>
 #include <iomanip>
 #include <util/Tensor.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
 
 using namespace sisi4s;
 
+namespace {
+// formats as iostream does with setprecision(16), returns the length
+inline int formatNumber(char *buffer, const Float64 x) {
+  return std::snprintf(buffer, 32, "%.16g", x);
+}
+inline int formatNumber(char *buffer, const Complex<Float64> z) {
+  return std::snprintf(buffer, 64, "(%.16g,%.16g)", z.real(), z.imag());
+}
+
+// formats the rows of the given values and writes them to the file
+template <typename F>
+void writeTextRows(std::ofstream &file,
+                   const std::vector<F> &values,
+                   const int64_t columnElementsCount,
+                   const std::string &delimiter) {
+  std::string text;
+  text.reserve(values.size() * 24);
+  char buffer[64];
+  for (size_t index(0); index < values.size(); ++index) {
+    if (index % columnElementsCount > 0) text += delimiter;
+    text.append(buffer, formatNumber(buffer, values[index]));
+    if ((index + 1) % columnElementsCount == 0) text += '\n';
+  }
+  file.write(text.data(), text.size());
+}
+
+// number of values fetched to the root per block of rows
+const int64_t WRITE_TEXT_BLOCK_SIZE(1024 * 1024);
+
+// reads or writes in pieces of at most 1GB, the limit of the MPI counts
+void readAt(MPI_File &file, int64_t offset, void *data, int64_t size) {
+  MPI_Status status;
+  char *bytes(static_cast<char *>(data));
+  for (int64_t done(0); done < size;) {
+    const int count(std::min(size - done, int64_t(1) << 30));
+    MPI_File_read_at(file,
+                     offset + done,
+                     bytes + done,
+                     count,
+                     MPI_BYTE,
+                     &status);
+    done += count;
+  }
+}
+void writeAt(MPI_File &file, int64_t offset, const void *data, int64_t size) {
+  MPI_Status status;
+  const char *bytes(static_cast<const char *>(data));
+  for (int64_t done(0); done < size;) {
+    const int count(std::min(size - done, int64_t(1) << 30));
+    MPI_File_write_at(file,
+                      offset + done,
+                      const_cast<char *>(bytes + done),
+                      count,
+                      MPI_BYTE,
+                      &status);
+    done += count;
+  }
+}
+
+// the filters operate on words of the indices and of the real
+// and imaginary parts
+const size_t CODEC_WORD_SIZE(sizeof(int64_t));
+
+// returns the data chunk of the given values, including all headers,
+// in index-value storage if indices are given
+template <typename F>
+std::vector<char> encodeDataChunk(const int64_t firstIndex,
+                                  const int64_t *indices,
+                                  const F *values,
+                                  const int64_t elementsCount,
+                                  const int32_t filters) {
+  const int64_t indicesSize(indices ? elementsCount * sizeof(int64_t) : 0);
+  std::vector<char> data(indicesSize + elementsCount * sizeof(F));
+  if (indices) {
+    int64_t previous(firstIndex);
+    for (int64_t i(0); i < elementsCount; ++i) {
+      const int64_t difference(indices[i] - previous);
+      std::memcpy(&data[i * sizeof(int64_t)], &difference, sizeof(int64_t));
+      previous = indices[i];
+    }
+  }
+  std::memcpy(data.data() + indicesSize, values, elementsCount * sizeof(F));
+
+  BinaryTensorDataChunk fields;
+  fields.firstIndex = firstIndex;
+  fields.elementsCount = elementsCount;
+  fields.filters = BinaryTensorCodec::encode(data, filters, CODEC_WORD_SIZE);
+  fields.encodedSize = data.size();
+  fields.checksum = BinaryTensorCodec::getChecksum(data.data(), data.size());
+
+  const size_t headersSize(sizeof(BinaryTensorChunkHeader) + sizeof(fields));
+  const int64_t size((headersSize + data.size() + 7) / 8 * 8);
+  BinaryTensorChunkHeader header(BinaryTensorChunkHeader::DATA, size);
+  std::vector<char> chunk(size, 0);
+  std::memcpy(chunk.data(), &header, sizeof(header));
+  std::memcpy(chunk.data() + sizeof(header), &fields, sizeof(fields));
+  std::copy(data.begin(), data.end(), chunk.begin() + headersSize);
+  return chunk;
+}
+
+// decodes the indices and values of the data chunk, returns false
+// if the chunk is corrupt
+template <typename F>
+bool decodeDataChunk(const std::vector<char> &chunk,
+                     const bool indexValue,
+                     std::vector<int64_t> &indices,
+                     std::vector<F> &values) {
+  BinaryTensorChunkHeader header;
+  BinaryTensorDataChunk fields;
+  const size_t headersSize(sizeof(header) + sizeof(fields));
+  if (chunk.size() < headersSize) return false;
+  std::memcpy(&header, chunk.data(), sizeof(header));
+  std::memcpy(&fields, chunk.data() + sizeof(header), sizeof(fields));
+  if (!header.is(BinaryTensorChunkHeader::DATA) || fields.elementsCount < 0
+      || fields.encodedSize < 0
+      || headersSize + fields.encodedSize > chunk.size()) {
+    return false;
+  }
+  std::vector<char> data(chunk.begin() + headersSize,
+                         chunk.begin() + headersSize + fields.encodedSize);
+  if (BinaryTensorCodec::getChecksum(data.data(), data.size())
+      != fields.checksum) {
+    return false;
+  }
+  const int64_t n(fields.elementsCount);
+  const int64_t indicesSize(indexValue ? n * sizeof(int64_t) : 0);
+  BinaryTensorCodec::decode(data,
+                            fields.filters,
+                            CODEC_WORD_SIZE,
+                            indicesSize + n * sizeof(F));
+  indices.resize(n);
+  int64_t index(fields.firstIndex);
+  for (int64_t i(0); i < n; ++i) {
+    if (indexValue) {
+      int64_t difference;
+      std::memcpy(&difference, &data[i * sizeof(int64_t)], sizeof(int64_t));
+      index += difference;
+      indices[i] = index;
+    } else {
+      indices[i] = index++;
+    }
+  }
+  values.resize(n);
+  std::memcpy(values.data(), data.data() + indicesSize, n * sizeof(F));
+  return true;
+}
+
+// writes the header of the chunk index at the given offset, returns
+// its total size including the entries
+int64_t writeChunkIndex(MPI_File &file,
+                        const int64_t offset,
+                        const int64_t elementsPerChunk,
+                        const int64_t chunksCount) {
+  const int64_t size(sizeof(BinaryTensorChunkHeader)
+                     + sizeof(BinaryTensorChunkIndex)
+                     + chunksCount * sizeof(BinaryTensorChunkIndexEntry));
+  if (Sisi4s::world->rank == 0) {
+    BinaryTensorChunkHeader header(BinaryTensorChunkHeader::INDEX, size);
+    BinaryTensorChunkIndex index;
+    index.elementsPerChunk = elementsPerChunk;
+    index.chunksCount = chunksCount;
+    writeAt(file, offset, &header, sizeof(header));
+    writeAt(file, offset + sizeof(header), &index, sizeof(index));
+  }
+  return size;
+}
+
+// offset of the first entry of the chunk index at the given offset
+int64_t getChunkIndexEntriesOffset(const int64_t indexOffset) {
+  return indexOffset + sizeof(BinaryTensorChunkHeader)
+       + sizeof(BinaryTensorChunkIndex);
+}
+
+// writes the dense data of a nonsymmetric tensor in chunks of consecutive
+// global indices, processed by all processes in rounds
+template <typename F, typename T>
+void writeDenseChunks(MPI_File &file,
+                      const int64_t offset,
+                      T &A,
+                      const int32_t filters,
+                      const int64_t elementsPerChunk) {
+  const int rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  int64_t elementsCount(1);
+  for (int d(0); d < A.order; ++d) elementsCount *= A.lens[d];
+  const int64_t chunksCount((elementsCount + elementsPerChunk - 1)
+                            / elementsPerChunk);
+  int64_t dataOffset(
+      offset + writeChunkIndex(file, offset, elementsPerChunk, chunksCount));
+
+  std::vector<int64_t> indices;
+  std::vector<F> values;
+  for (int64_t round(0); round * np < chunksCount; ++round) {
+    const int64_t chunk(round * np + rank);
+    const int64_t firstIndex(chunk * elementsPerChunk);
+    const int64_t n(chunk < chunksCount
+                        ? std::min(elementsPerChunk, elementsCount - firstIndex)
+                        : 0);
+    indices.resize(n);
+    std::iota(indices.begin(), indices.end(), firstIndex);
+    values.resize(n);
+    A.read(n, indices.data(), values.data());
+
+    std::vector<char> data;
+    if (n > 0) {
+      data = encodeDataChunk<F>(firstIndex, nullptr, values.data(), n, filters);
+    }
+    int64_t size(data.size()), localOffset(0), roundSize;
+    MPI_Exscan(&size, &localOffset, 1, MPI_INT64_T, MPI_SUM, A.wrld->comm);
+    if (rank == 0) localOffset = 0;
+    MPI_Allreduce(&size, &roundSize, 1, MPI_INT64_T, MPI_SUM, A.wrld->comm);
+    if (n > 0) {
+      writeAt(file, dataOffset + localOffset, data.data(), size);
+      BinaryTensorChunkIndexEntry entry;
+      entry.offset = dataOffset + localOffset;
+      entry.firstIndex = firstIndex;
+      entry.lastIndex = firstIndex + n - 1;
+      entry.elementsCount = n;
+      writeAt(file,
+              getChunkIndexEntriesOffset(offset) + chunk * sizeof(entry),
+              &entry,
+              sizeof(entry));
+    }
+    dataOffset += roundSize;
+  }
+}
+
+// writes the locally stored elements of a symmetric tensor in
+// index-value storage, each process writing its own chunks
+template <typename F, typename T>
+void writeIndexValueChunks(MPI_File &file,
+                           const int64_t offset,
+                           T &A,
+                           const int32_t filters,
+                           const int64_t elementsPerChunk) {
+  int64_t localCount, *localIndices;
+  F *localValues;
+  A.read_local(&localCount, &localIndices, &localValues);
+  std::vector<int64_t> order(localCount);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [localIndices](int64_t i, int64_t j) {
+    return localIndices[i] < localIndices[j];
+  });
+  std::vector<int64_t> indices(localCount);
+  std::vector<F> values(localCount);
+  for (int64_t i(0); i < localCount; ++i) {
+    indices[i] = localIndices[order[i]];
+    values[i] = localValues[order[i]];
+  }
+  free(localIndices);
+  free(localValues);
+
+  int64_t localChunksCount((localCount + elementsPerChunk - 1)
+                           / elementsPerChunk),
+      firstChunk(0), chunksCount;
+  MPI_Exscan(&localChunksCount,
+             &firstChunk,
+             1,
+             MPI_INT64_T,
+             MPI_SUM,
+             A.wrld->comm);
+  if (Sisi4s::world->rank == 0) firstChunk = 0;
+  MPI_Allreduce(&localChunksCount,
+                &chunksCount,
+                1,
+                MPI_INT64_T,
+                MPI_SUM,
+                A.wrld->comm);
+  const int64_t dataOffset(
+      offset + writeChunkIndex(file, offset, elementsPerChunk, chunksCount));
+
+  std::vector<char> data;
+  std::vector<BinaryTensorChunkIndexEntry> entries(localChunksCount);
+  for (int64_t c(0); c < localChunksCount; ++c) {
+    const int64_t first(c * elementsPerChunk);
+    const int64_t n(std::min(elementsPerChunk, localCount - first));
+    std::vector<char> chunk(encodeDataChunk<F>(indices[first],
+                                               &indices[first],
+                                               &values[first],
+                                               n,
+                                               filters));
+    entries[c].offset = data.size();
+    entries[c].firstIndex = indices[first];
+    entries[c].lastIndex = indices[first + n - 1];
+    entries[c].elementsCount = n;
+    data.insert(data.end(), chunk.begin(), chunk.end());
+  }
+  int64_t size(data.size()), localOffset(0);
+  MPI_Exscan(&size, &localOffset, 1, MPI_INT64_T, MPI_SUM, A.wrld->comm);
+  if (Sisi4s::world->rank == 0) localOffset = 0;
+  for (auto &entry : entries) entry.offset += dataOffset + localOffset;
+  writeAt(file, dataOffset + localOffset, data.data(), size);
+  writeAt(file,
+          getChunkIndexEntriesOffset(offset)
+              + firstChunk * sizeof(BinaryTensorChunkIndexEntry),
+          entries.data(),
+          entries.size() * sizeof(BinaryTensorChunkIndexEntry));
+}
+
+// global index of the given multi-index for the given lengths
+int64_t getGlobalIndex(const std::vector<int64_t> &index,
+                       const std::vector<int> &lens) {
+  int64_t globalIndex(0);
+  for (int d(lens.size() - 1); d >= 0; --d) {
+    globalIndex = globalIndex * lens[d] + index[d];
+  }
+  return globalIndex;
+}
+
+// reads the chunk index at the given offset and the data chunks,
+// each process reading and verifying one chunk per round. If begins
+// are given, only the chunks overlapping the slice from begins to ends
+// of the tensor with the given lengths are read and only the elements
+// within the slice are written to A.
+template <typename F, typename T>
+void readChunks(MPI_File &file,
+                const int64_t offset,
+                const BinaryTensorHeader &header,
+                T &A,
+                const std::string &fileName,
+                const std::vector<int> &lens = std::vector<int>(),
+                const std::vector<int64_t> &begins = std::vector<int64_t>(),
+                const std::vector<int64_t> &ends = std::vector<int64_t>()) {
+  const int rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  BinaryTensorChunkHeader indexHeader;
+  BinaryTensorChunkIndex index;
+  readAt(file, offset, &indexHeader, sizeof(indexHeader));
+  readAt(file, offset + sizeof(indexHeader), &index, sizeof(index));
+  std::vector<BinaryTensorChunkIndexEntry> entries(index.chunksCount);
+  readAt(file,
+         getChunkIndexEntriesOffset(offset),
+         entries.data(),
+         entries.size() * sizeof(BinaryTensorChunkIndexEntry));
+
+  const bool sliced(!begins.empty());
+  std::vector<int64_t> chunks;
+  if (sliced) {
+    // chunks with global indices between the slice's first and last one
+    std::vector<int64_t> lasts(ends);
+    for (auto &last : lasts) --last;
+    const int64_t first(getGlobalIndex(begins, lens)),
+        last(getGlobalIndex(lasts, lens));
+    for (int64_t c(0); c < index.chunksCount; ++c) {
+      if (entries[c].lastIndex >= first && entries[c].firstIndex <= last) {
+        chunks.push_back(c);
+      }
+    }
+  } else {
+    chunks.resize(index.chunksCount);
+    std::iota(chunks.begin(), chunks.end(), 0);
+  }
+
+  const bool indexValue(header.flags
+                        & BinaryTensorHeaderBase::INDEX_VALUE_FLAG);
+  const int64_t chunksCount(chunks.size());
+  std::vector<int64_t> indices;
+  std::vector<F> values;
+  for (int64_t round(0); round * np < chunksCount; ++round) {
+    const int64_t c(round * np + rank);
+    int corrupt(0);
+    indices.clear();
+    values.clear();
+    if (c < chunksCount) {
+      const BinaryTensorChunkIndexEntry &entry(entries[chunks[c]]);
+      BinaryTensorChunkHeader chunkHeader;
+      readAt(file, entry.offset, &chunkHeader, sizeof(chunkHeader));
+      std::vector<char> data(std::max(chunkHeader.size, int64_t(0)));
+      readAt(file, entry.offset, data.data(), data.size());
+      corrupt = !decodeDataChunk<F>(data, indexValue, indices, values)
+             || int64_t(values.size()) != entry.elementsCount;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, &corrupt, 1, MPI_INT, MPI_MAX, A.wrld->comm);
+    if (corrupt) {
+      throw new EXCEPTION("Corrupt data chunk in file \"" + fileName + "\"");
+    }
+    if (sliced) {
+      // keep the elements within the slice at their index in the slice
+      size_t kept(0);
+      for (size_t i(0); i < indices.size(); ++i) {
+        int64_t globalIndex(indices[i]), sliceIndex(0), stride(1);
+        bool inside(true);
+        for (size_t d(0); d < lens.size() && inside; ++d) {
+          const int64_t position(globalIndex % lens[d]);
+          globalIndex /= lens[d];
+          inside = begins[d] <= position && position < ends[d];
+          sliceIndex += (position - begins[d]) * stride;
+          stride *= ends[d] - begins[d];
+        }
+        if (inside) {
+          indices[kept] = sliceIndex;
+          values[kept++] = values[i];
+        }
+      }
+      indices.resize(kept);
+      values.resize(kept);
+    }
+    A.write(values.size(), indices.data(), values.data());
+  }
+}
+
+// reads the slice from begins to ends of the dense data of version 1
+// at the given offset into S. The slice's last dimension is distributed
+// over the processes, each reading its part through a subarray file view.
+template <typename F, typename T>
+void readDenseSlice(MPI_File &file,
+                    const int64_t offset,
+                    const std::vector<int> &lens,
+                    const std::vector<int64_t> &begins,
+                    const std::vector<int64_t> &ends,
+                    T &S) {
+  const int rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  const int order(lens.size()), last(order - 1);
+  std::vector<int> subsizes(order), starts(order);
+  for (int d(0); d < order; ++d) {
+    starts[d] = begins[d];
+    subsizes[d] = ends[d] - begins[d];
+  }
+  starts[last] = begins[last] + subsizes[last] * rank / np;
+  subsizes[last] =
+      begins[last] + subsizes[last] * (rank + 1) / np - starts[last];
+  int64_t elementsCount(1);
+  for (int d(0); d < order; ++d) elementsCount *= subsizes[d];
+
+  MPI_Datatype element, view;
+  MPI_Type_contiguous(sizeof(F), MPI_BYTE, &element);
+  MPI_Type_commit(&element);
+  if (elementsCount > 0) {
+    MPI_Type_create_subarray(order,
+                             lens.data(),
+                             subsizes.data(),
+                             starts.data(),
+                             MPI_ORDER_FORTRAN,
+                             element,
+                             &view);
+  } else {
+    MPI_Type_contiguous(1, element, &view);
+  }
+  MPI_Type_commit(&view);
+  MPI_File_set_view(file,
+                    offset,
+                    element,
+                    view,
+                    const_cast<char *>("native"),
+                    MPI_INFO_NULL);
+
+  // read collectively in pieces, limited by the MPI counts
+  const int64_t pieceSize(int64_t(1) << 30);
+  int64_t piecesCount((elementsCount + pieceSize - 1) / pieceSize);
+  MPI_Allreduce(MPI_IN_PLACE,
+                &piecesCount,
+                1,
+                MPI_INT64_T,
+                MPI_MAX,
+                S.wrld->comm);
+  std::vector<F> values(elementsCount);
+  for (int64_t piece(0); piece < piecesCount; ++piece) {
+    MPI_Status status;
+    const int64_t first(std::min(piece * pieceSize, elementsCount));
+    const int count(std::min(pieceSize, elementsCount - first));
+    MPI_File_read_all(file, values.data() + first, count, element, &status);
+  }
+  MPI_Type_free(&view);
+  MPI_Type_free(&element);
+
+  // index of each element within the slice, the first index fastest
+  std::vector<int64_t> indices(elementsCount), position(order, 0);
+  for (int64_t i(0); i < elementsCount; ++i) {
+    int64_t sliceIndex(0), stride(1);
+    for (int d(0); d < order; ++d) {
+      sliceIndex += (starts[d] - begins[d] + position[d]) * stride;
+      stride *= ends[d] - begins[d];
+    }
+    indices[i] = sliceIndex;
+    for (int d(0); d < order && ++position[d] == subsizes[d]; ++d) {
+      position[d] = 0;
+    }
+  }
+  S.write(elementsCount, indices.data(), values.data());
+}
+} // namespace
+
 template <typename F, typename T>
 T *TensorIo::readBinary(std::string const &fileName) {
   // open the file
@@ -25,10 +516,18 @@ T *TensorIo::readBinary(std::string const &fileName) {
   }
 
   int64_t offset(0);
-  T *A(readBinaryHeader<F, T>(file, offset));
+  BinaryTensorHeader header;
+  std::vector<int> lens, syms;
+  readBinaryHeader<F>(file, offset, header, lens, syms);
+  // allocate tensor
+  T *A(new T(header.order, lens.data(), syms.data(), *Sisi4s::world));
 
-  // read dense data
-  A->read_dense_from_file(file, offset);
+  if (header.version <= BinaryTensorHeaderBase::DENSE_VERSION) {
+    // read dense data
+    A->read_dense_from_file(file, offset);
+  } else {
+    readChunks<F>(file, offset, header, *A, fileName);
+  }
 
   // done
   MPI_File_close(&file);
@@ -36,18 +535,89 @@ T *TensorIo::readBinary(std::string const &fileName) {
 }
 
 template <typename F, typename T>
-T *TensorIo::readText(std::string const &fileName,
-                      std::string const &delimiter,
-                      int64_t const bufferSize) {
-  std::ifstream stream(fileName.c_str());
-  if (stream.fail()) {
+T *TensorIo::readBinary(std::string const &fileName,
+                        std::vector<int64_t> const &begins,
+                        std::vector<int64_t> const &ends) {
+  // open the file
+  MPI_File file;
+  int mpiError(MPI_File_open(Sisi4s::world->comm,
+                             fileName.c_str(),
+                             MPI_MODE_RDONLY,
+                             MPI_INFO_NULL,
+                             &file));
+  if (mpiError) {
     std::stringstream explanation;
     explanation << "Failed to open file \"" << fileName << "\"";
     throw new EXCEPTION(explanation.str());
   }
-  Scanner scanner(&stream);
-  std::string name(scanner.nextLine(' '));
-  std::stringstream lineStream(scanner.nextLine());
+
+  int64_t offset(0);
+  BinaryTensorHeader header;
+  std::vector<int> lens, syms;
+  readBinaryHeader<F>(file, offset, header, lens, syms);
+  if (header.order == 0 || begins.size() != size_t(header.order)
+      || ends.size() != size_t(header.order)) {
+    throw new EXCEPTION("A slice needs a begin and an end for each dimension");
+  }
+  std::vector<int> sliceLens(header.order), sliceSyms(header.order, NS);
+  for (int d(0); d < header.order; ++d) {
+    if (begins[d] < 0 || begins[d] >= ends[d] || ends[d] > lens[d]) {
+      throw new EXCEPTION("Invalid slice of tensor in file");
+    }
+    if (syms[d] != NS) {
+      throw new EXCEPTION("Slices of symmetric tensors are not supported");
+    }
+    sliceLens[d] = ends[d] - begins[d];
+  }
+  // allocate only the slice
+  T *S(new T(header.order, sliceLens.data(), sliceSyms.data(), *Sisi4s::world));
+
+  if (header.version <= BinaryTensorHeaderBase::DENSE_VERSION) {
+    readDenseSlice<F>(file, offset, lens, begins, ends, *S);
+  } else {
+    readChunks<F>(file, offset, header, *S, fileName, lens, begins, ends);
+  }
+
+  // done
+  MPI_File_close(&file);
+  return S;
+}
+
+template <typename F, typename T>
+T *TensorIo::readText(std::string const &fileName,
+                      std::string const &delimiter,
+                      int64_t const bufferSize,
+                      bool const localOnly) {
+  const int rank(Sisi4s::world->rank), np(Sisi4s::world->np);
+  // in local only mode the file is only accessible by the root
+  const bool reading(!localOnly || rank == 0);
+  PTR(MappedFile) file;
+  if (reading) file = NEW(MappedFile, fileName);
+
+  // the root reads the two header lines and sends them to all processes
+  int64_t headerSize(0);
+  if (rank == 0) {
+    const char *lineEnd(file->begin());
+    for (int line(0); line < 2 && lineEnd < file->end(); ++line) {
+      lineEnd = static_cast<const char *>(
+          std::memchr(lineEnd, '\n', file->end() - lineEnd));
+      lineEnd = lineEnd ? lineEnd + 1 : file->end();
+    }
+    headerSize = lineEnd - file->begin();
+  }
+  MPI_Bcast(&headerSize, 1, MPI_INT64_T, 0, Sisi4s::world->comm);
+  std::vector<char> header(headerSize);
+  if (rank == 0) {
+    std::copy(file->begin(), file->begin() + headerSize, header.begin());
+  }
+  MPI_Bcast(header.data(), headerSize, MPI_CHAR, 0, Sisi4s::world->comm);
+
+  std::stringstream headerStream(std::string(header.begin(), header.end()));
+  std::string name, rowIndexOrder, columnIndexOrder;
+  std::getline(headerStream, name, ' ');
+  std::string line;
+  std::getline(headerStream, line);
+  std::stringstream lineStream(line);
   int order;
   lineStream >> order;
   int lens[order];
@@ -56,9 +626,8 @@ T *TensorIo::readText(std::string const &fileName,
     lineStream >> lens[dim];
     syms[dim] = NS;
   }
-
-  std::string rowIndexOrder(scanner.nextLine(' '));
-  std::string columnIndexOrder(scanner.nextLine());
+  std::getline(headerStream, rowIndexOrder, ' ');
+  std::getline(headerStream, columnIndexOrder);
 
   int storedLens[order];
   int storedIndex(0);
@@ -76,31 +645,93 @@ T *TensorIo::readText(std::string const &fileName,
 
   int64_t indexCount(1);
   for (int dim(0); dim < B->order; ++dim) { indexCount *= B->lens[dim]; }
+  LOG(1, "TensorReader") << "indexCount=" << indexCount << std::endl;
 
-  // read the values only on root
-  int64_t localBufferSize(B->wrld->rank == 0 ? bufferSize : 0);
-  int64_t *indices(new int64_t[localBufferSize]);
-  F *values(new F[localBufferSize]);
+  // each process parses a range of the data, split at separators
+  std::vector<F> values;
+  int parseFailed(0);
+  if (reading) {
+    const char *data(file->begin() + headerSize), *dataEnd(file->end());
+    const int ranges(localOnly ? 1 : np), range(localOnly ? 0 : rank);
+    const auto getBoundary = [&](const int r) {
+      if (r == 0) return data;
+      if (r == ranges) return dataEnd;
+      const char *boundary(data + (dataEnd - data) * r / ranges);
+      while (boundary < dataEnd && !isNumberSeparator(*boundary)) ++boundary;
+      return boundary;
+    };
+    const char *begin(getBoundary(range)), *end(getBoundary(range + 1));
 
-  int64_t index(0);
-  LOG(1, "TensorReader") << "indexCount=" << indexCount << std::endl;
-  NumberScanner<F> numberScanner(&scanner);
-  while (index < indexCount) {
-    int64_t elementsCount(std::min(bufferSize, indexCount - index));
-    int64_t localElementsCount(B->wrld->rank == 0 ? elementsCount : 0);
-    for (int64_t i(0); i < localElementsCount; ++i) {
-      indices[i] = index + i;
-      values[i] = numberScanner.nextNumber();
+    // and further among the threads
+    const int threads(getMaxThreads());
+    std::vector<std::vector<F>> threadValues(threads);
+    bool failed(false);
+#pragma omp parallel for reduction(|| : failed)
+    for (int t = 0; t < threads; ++t) {
+      const char *p(begin + (end - begin) * t / threads);
+      const char *pEnd(begin + (end - begin) * (t + 1) / threads);
+      while (t > 0 && p < end && !isNumberSeparator(*p)) ++p;
+      while (t + 1 < threads && pEnd < end && !isNumberSeparator(*pEnd)) ++pEnd;
+      while (p < pEnd && !failed) {
+        while (p < pEnd && isNumberSeparator(*p)) ++p;
+        if (p == pEnd) break;
+        F value;
+        failed = !parseNumber(p, pEnd, value);
+        threadValues[t].push_back(value);
+      }
     }
-    // wait until all processes finished reading this buffer
-    MPI_Barrier(Sisi4s::world->comm);
-    LOG(1, "TensorReader") << "writing " << elementsCount
+    parseFailed = failed;
+    for (const auto &v : threadValues) {
+      values.insert(values.end(), v.begin(), v.end());
+    }
+  }
+  // throw on all processes, the others would wait in the collectives below
+  int anyParseFailed;
+  MPI_Allreduce(&parseFailed,
+                &anyParseFailed,
+                1,
+                MPI_INT,
+                MPI_LOR,
+                Sisi4s::world->comm);
+  if (anyParseFailed) {
+    throw new EXCEPTION("Failed to parse number in file \"" + fileName + "\"");
+  }
+
+  // index of the first value of each process
+  int64_t count(values.size()), first(0), totalCount;
+  MPI_Exscan(&count, &first, 1, MPI_INT64_T, MPI_SUM, Sisi4s::world->comm);
+  if (rank == 0) first = 0;
+  MPI_Allreduce(&count,
+                &totalCount,
+                1,
+                MPI_INT64_T,
+                MPI_SUM,
+                Sisi4s::world->comm);
+  if (totalCount != indexCount) {
+    std::stringstream explanation;
+    explanation << "Expected " << indexCount << " values in file \""
+                << fileName << "\", found " << totalCount;
+    throw new EXCEPTION(explanation.str());
+  }
+
+  // insert all values with one collective write, in local only mode
+  // in writes of at most bufferSize values to limit the memory
+  const int64_t writeSize(localOnly ? std::max<int64_t>(bufferSize, 1)
+                                    : std::max<int64_t>(totalCount, 1));
+  std::vector<int64_t> indices;
+  for (int64_t written(0); written < totalCount; written += writeSize) {
+    const int64_t writeBegin(std::min(std::max(written, first), first + count));
+    const int64_t writeEnd(
+        std::min(std::max(written + writeSize, first), first + count));
+    indices.resize(writeEnd - writeBegin);
+    std::iota(indices.begin(), indices.end(), writeBegin);
+    LOG(1, "TensorReader") << "writing " << indices.size()
                            << " values to tensor..." << std::endl;
-    B->write(localElementsCount, indices, values);
-    index += elementsCount;
+    B->write(indices.size(),
+             indices.data(),
+             values.data() + writeBegin - first);
   }
-  delete[] indices;
-  delete[] values;
+  std::vector<F>().swap(values);
 
   char indexOrder[B->order + 1];
   for (int dim(0); dim < B->order; ++dim) { indexOrder[dim] = 'i' + dim; }
@@ -117,7 +748,18 @@ T *TensorIo::readText(std::string const &fileName,
 }
 
 template <typename F, typename T>
-void TensorIo::writeBinary(std::string const &fileName, T &A) {
+void TensorIo::writeBinary(std::string const &fileName,
+                           T &A,
+                           int32_t const version,
+                           int32_t const filters,
+                           int64_t const elementsPerChunk) {
+  if (version != BinaryTensorHeaderBase::DENSE_VERSION
+      && version != BinaryTensorHeaderBase::CHUNKED_VERSION) {
+    throw new EXCEPTION("Unknown binary tensor format version");
+  }
+  if (elementsPerChunk <= 0) {
+    throw new EXCEPTION("Chunks must contain at least one element");
+  }
   MPI_File file;
   MPI_Status status;
   MPI_File_open(A.wrld->comm,
@@ -131,13 +773,21 @@ void TensorIo::writeBinary(std::string const &fileName, T &A) {
   MPI_File_set_size(file, offset);
   // write header
   BinaryTensorHeader header(A);
+  header.version = version;
+  bool packed(false);
+  for (int dim(0); dim < A.order; ++dim) packed = packed || A.sym[dim] != NS;
+  // symmetric tensors are stored packed in version 2
+  packed = packed && version != BinaryTensorHeaderBase::DENSE_VERSION;
+  if (packed) header.flags |= BinaryTensorHeaderBase::INDEX_VALUE_FLAG;
   MPI_File_write_at(file, offset, &header, sizeof(header), MPI_BYTE, &status);
   offset += sizeof(header);
   // FIXME: status checking
 
   // write dimension header for each dimension
+  std::string indexNames;
   for (int dim(0); dim < A.order; ++dim) {
     BinaryTensorDimensionHeader dimensionHeader(A.lens[dim], 'a' + dim);
+    indexNames += dimensionHeader.indexName[0];
     MPI_File_write_at(file,
                       offset,
                       &dimensionHeader,
@@ -147,8 +797,26 @@ void TensorIo::writeBinary(std::string const &fileName, T &A) {
     offset += sizeof(dimensionHeader);
   }
 
-  // write dense data
-  A.write_dense_to_file(file, offset);
+  if (version == BinaryTensorHeaderBase::DENSE_VERSION) {
+    // write dense data
+    A.write_dense_to_file(file, offset);
+  } else {
+    // write symmetry chunks
+    for (auto const &symmetry :
+         BinaryTensorSymmetry::fromCtf(A.order, A.sym, indexNames)) {
+      const std::vector<char> chunk(symmetry.encode());
+      if (Sisi4s::world->rank == 0) {
+        writeAt(file, offset, chunk.data(), chunk.size());
+      }
+      offset += chunk.size();
+    }
+    // write chunk index and data chunks
+    if (packed) {
+      writeIndexValueChunks<F>(file, offset, A, filters, elementsPerChunk);
+    } else {
+      writeDenseChunks<F>(file, offset, A, filters, elementsPerChunk);
+    }
+  }
 
   // done
   MPI_File_close(&file);
@@ -190,57 +858,75 @@ void TensorIo::writeText(std::string const &fileName,
     rowElementsCount *= lens[columnOrder + dim];
   }
   indexOrder[A.order] = 0;
+  // reorder indices for writing and unpack symmetries
   T B(A.order, lens, syms, *A.wrld, "DataOrdered");
-  // reorder indices for writing:
   B[indexOrder] = A[defaultIndexOrder];
-  int64_t valuesCount;
-  F *values;
-  // and unpack symmetries for writing
-  // TODO: implement memory scalable version
-  B.read_all(&valuesCount, &values, true);
-  Assert(rowElementsCount * columnElementsCount == valuesCount,
-         "Wrong number of elements read");
 
   // only the root writes the file
-  if (A.wrld->rank == 0) {
-    std::ofstream file(fileName.c_str());
+  const bool root(A.wrld->rank == 0);
+  std::ofstream file;
+  if (root) {
+    file.open(fileName.c_str());
     file << A.get_name() << delimiter << A.order;
     for (int i(0); i < A.order; ++i) { file << delimiter << A.lens[i]; }
     file << std::endl;
     file << rowIndexOrder << delimiter << columnIndexOrder << std::endl;
+  }
+  LOG(1, "Writer") << "rows=" << rowElementsCount
+                   << ", columns=" << columnElementsCount << std::endl;
 
-    // write the actual data
-    int64_t index(0);
-    LOG(1, "Writer") << "rows=" << rowElementsCount
-                     << ", columns=" << columnElementsCount << std::endl;
-    file << std::setprecision(16);
-    for (int64_t row(0); row < rowElementsCount; ++row) {
-      file << values[index++];
-      for (int64_t column(1); column < columnElementsCount; ++column) {
-        file << delimiter << values[index++];
-      }
-      file << std::endl;
+  // fetch blocks of rows to the root, formatting and writing each block
+  // in the background while fetching the next one
+  const int64_t blockRows(
+      std::max<int64_t>(1, WRITE_TEXT_BLOCK_SIZE / columnElementsCount));
+  std::vector<F> values[2];
+  std::vector<int64_t> indices;
+  std::thread writer;
+  for (int64_t row(0), block(0); row < rowElementsCount;
+       row += blockRows, ++block) {
+    const int64_t rows(std::min(blockRows, rowElementsCount - row));
+    const int64_t count(root ? rows * columnElementsCount : 0);
+    std::vector<F> &blockValues(values[block % 2]);
+    blockValues.resize(count);
+    indices.resize(count);
+    std::iota(indices.begin(), indices.end(), row * columnElementsCount);
+    // collective, all processes take part
+    B.read(count, indices.data(), blockValues.data());
+    if (writer.joinable()) writer.join();
+    if (root) {
+      writer = std::thread(writeTextRows<F>,
+                           std::ref(file),
+                           std::cref(blockValues),
+                           columnElementsCount,
+                           std::cref(delimiter));
     }
   }
-  free(values);
+  if (writer.joinable()) writer.join();
 }
 
-template <typename F, typename T>
-T *TensorIo::readBinaryHeader(MPI_File &file, int64_t &offset) {
+template <typename F>
+void TensorIo::readBinaryHeader(MPI_File &file,
+                                int64_t &offset,
+                                BinaryTensorHeader &header,
+                                std::vector<int> &lens,
+                                std::vector<int> &syms) {
   MPI_Status status;
   // reade header
-  BinaryTensorHeader header;
   MPI_File_read_at(file, offset, &header, sizeof(header), MPI_BYTE, &status);
   offset += sizeof(header);
   if (strncmp(header.magic, BinaryTensorHeaderBase::MAGIC, sizeof(header.magic))
       != 0)
     throw new EXCEPTION("Invalid file format");
-  if (header.version > header.VERSION)
+  if (header.version > header.LATEST_VERSION)
     throw new EXCEPTION("Incompatible file format version");
+  // the bytes per number are those of a tensor element, as written
+  if (header.bytesPerNumber != int32_t(sizeof(F)))
+    throw new EXCEPTION("Incompatible number type of tensor in file");
 
   // read dimension headers
-  int lens[header.order];
-  int syms[header.order];
+  lens.resize(header.order);
+  syms.resize(header.order);
+  std::string indexNames;
   for (int dim(0); dim < header.order; ++dim) {
     BinaryTensorDimensionHeader dimensionHeader;
     MPI_File_read_at(file,
@@ -252,10 +938,28 @@ T *TensorIo::readBinaryHeader(MPI_File &file, int64_t &offset) {
     offset += sizeof(dimensionHeader);
     lens[dim] = dimensionHeader.length;
     syms[dim] = NS;
+    indexNames += dimensionHeader.indexName[0];
   }
 
-  // allocate tensor
-  return new T(header.order, lens, syms, *Sisi4s::world);
+  if (header.version > BinaryTensorHeaderBase::DENSE_VERSION) {
+    // read variable chunks up to the chunk index, skipping unknown ones
+    std::vector<BinaryTensorSymmetry> symmetries;
+    while (true) {
+      BinaryTensorChunkHeader chunkHeader;
+      readAt(file, offset, &chunkHeader, sizeof(chunkHeader));
+      if (chunkHeader.is(BinaryTensorChunkHeader::INDEX)) break;
+      if (chunkHeader.size < int64_t(sizeof(chunkHeader))) {
+        throw new EXCEPTION("Invalid variable chunk in file");
+      }
+      if (chunkHeader.is(BinaryTensorChunkHeader::SYMMETRY)) {
+        std::vector<char> chunk(chunkHeader.size);
+        readAt(file, offset, chunk.data(), chunk.size());
+        symmetries.push_back(BinaryTensorSymmetry::decode(chunk));
+      }
+      offset += chunkHeader.size;
+    }
+    BinaryTensorSymmetry::toCtf(symmetries, indexNames, syms.data());
+  }
 }
 
 // instantiate
@@ -263,21 +967,38 @@ template Tensor<Float64> *
 TensorIo::readBinary<Float64>(std::string const &fileName);
 template Tensor<Complex<Float64>> *
 TensorIo::readBinary<Complex<Float64>>(std::string const &fileName);
+template Tensor<Float64> *
+TensorIo::readBinary<Float64>(std::string const &fileName,
+                              std::vector<int64_t> const &begins,
+                              std::vector<int64_t> const &ends);
+template Tensor<Complex<Float64>> *
+TensorIo::readBinary<Complex<Float64>>(std::string const &fileName,
+                                       std::vector<int64_t> const &begins,
+                                       std::vector<int64_t> const &ends);
 
 template Tensor<Float64> *
 TensorIo::readText<Float64>(std::string const &fileName,
                             std::string const &delimiter,
-                            int64_t const bufferSize);
+                            int64_t const bufferSize,
+                            bool const localOnly);
 template Tensor<Complex<Float64>> *
 TensorIo::readText<Complex<Float64>>(std::string const &fileName,
                                      std::string const &delimiter,
-                                     int64_t const bufferSize);
+                                     int64_t const bufferSize,
+                                     bool const localOnly);
 
-template void TensorIo::writeBinary<Float64>(std::string const &fileName,
-                                             Tensor<Float64> &A);
+template void
+TensorIo::writeBinary<Float64>(std::string const &fileName,
+                               Tensor<Float64> &A,
+                               int32_t const version,
+                               int32_t const filters,
+                               int64_t const elementsPerChunk);
 template void
 TensorIo::writeBinary<Complex<Float64>>(std::string const &fileName,
-                                        Tensor<Complex<Float64>> &A);
+                                        Tensor<Complex<Float64>> &A,
+                                        int32_t const version,
+                                        int32_t const filters,
+                                        int64_t const elementsPerChunk);
 
 template void TensorIo::writeText<Float64>(std::string const &fileName,
                                            Tensor<Float64> &A,
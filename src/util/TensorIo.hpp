@@ -1,21 +1,59 @@
 #ifndef TENSOR_IO_DEFINED
 #define TENSOR_IO_DEFINED
 
+#include <util/BinaryTensorFormat.hpp>
 #include <util/Scanner.hpp>
 #include <util/Tensor.hpp>
+#include <vector>
 
 namespace sisi4s {
 class TensorIo {
 public:
+  /**
+   * \brief Reads a tensor from a binary file of version 1 or 2.
+   * The processes read and verify the data chunks of version 2 in
+   * parallel.
+   */
   template <typename F = real, typename T = Tensor<F>>
   static T *readBinary(std::string const &fileName);
+  /**
+   * \brief Reads only the slice from begins to ends, exclusive, in each
+   * dimension of a nonsymmetric tensor in a binary file, without
+   * allocating the full tensor. The processes read their parts of
+   * version 1 files through subarray file views and only the chunks
+   * overlapping the slice of version 2 files.
+   */
+  template <typename F = real, typename T = Tensor<F>>
+  static T *readBinary(std::string const &fileName,
+                       std::vector<int64_t> const &begins,
+                       std::vector<int64_t> const &ends);
+  /**
+   * \brief Reads a tensor from a text file. The processes parse disjoint
+   * ranges of the file in parallel. In local only mode the file needs
+   * to be accessible only by the root, which parses it alone and
+   * inserts at most bufferSize values at a time.
+   * The values are separated by white space regardless of delimiter.
+   */
   template <typename F = real, typename T = Tensor<F>>
   static T *readText(std::string const &fileName,
                      std::string const &delimiter = " ",
-                     int64_t const bufferSize = 1024 * 1024 * 1024);
+                     int64_t const bufferSize = 1024 * 1024 * 1024,
+                     bool const localOnly = false);
 
+  /**
+   * \brief Writes a tensor to a binary file of the given version.
+   * Version 2 writes the data in chunks of at most elementsPerChunk
+   * elements, each with a checksum and encoded by the given
+   * BinaryTensorCodec filters. Symmetric tensors are written packed,
+   * in index-value storage.
+   */
   template <typename F = real, typename T = Tensor<F>>
-  static void writeBinary(std::string const &fileName, T &A);
+  static void
+  writeBinary(std::string const &fileName,
+              T &A,
+              int32_t const version = BinaryTensorHeaderBase::VERSION,
+              int32_t const filters = BinaryTensorCodec::NONE,
+              int64_t const elementsPerChunk = 1024 * 1024);
   template <typename F = real, typename T = Tensor<F>>
   static void writeText(std::string const &fileName,
                         T &A,
@@ -24,8 +62,12 @@ public:
                         std::string const &delimiter = " ");
 
 protected:
-  template <typename F = real, typename T = Tensor<F>>
-  static T *readBinaryHeader(MPI_File &file, int64_t &offset);
+  template <typename F = real>
+  static void readBinaryHeader(MPI_File &file,
+                               int64_t &offset,
+                               BinaryTensorHeader &header,
+                               std::vector<int> &lens,
+                               std::vector<int> &syms);
   template <typename F = real, typename T = Tensor<F>>
   static T *readTextHeader(Scanner &scanner);
 };
@@ -0,0 +1,58 @@
+#ifndef TEST_ALGORITHM_DEFINED
+#define TEST_ALGORITHM_DEFINED
+
+#include <algorithms/Algorithm.hpp>
+#include <util/SharedPointer.hpp>
+#include <Data.hpp>
+#include <Sisi4s.hpp>
+
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace sisi4s {
+/**
+ * \brief Algorithm only providing the given arguments to components
+ * taking their arguments from an algorithm, such as mixers.
+ * The arguments refer to data by name, e.g. to that of IntegerData(4).
+ */
+class TestAlgorithm : public Algorithm {
+public:
+  TestAlgorithm(std::vector<Argument> const &argumentList)
+      : Algorithm(argumentList) {}
+  virtual std::string getName() { return "TestAlgorithm"; }
+  virtual void run() {}
+};
+
+/**
+ * \brief Tensor data of the given lens with values uniformly distributed
+ * between the given bounds, to be given to an algorithm by its name.
+ */
+inline PTR(TensorData<Float64>)
+    getRandomTensorData(const std::vector<int> &lens,
+                        const Float64 min,
+                        const Float64 max,
+                        std::mt19937 &random) {
+  const std::vector<int> syms(lens.size(), NS);
+  auto tensor(new Tensor<Float64>(lens.size(),
+                                  lens.data(),
+                                  syms.data(),
+                                  *Sisi4s::world,
+                                  "T"));
+  std::vector<int64_t> indices;
+  std::vector<Float64> values;
+  if (Sisi4s::world->rank == 0) {
+    indices.resize(tensor->get_tot_size(false));
+    std::iota(indices.begin(), indices.end(), 0);
+    std::uniform_real_distribution<Float64> uniform(min, max);
+    for (size_t i(0); i < indices.size(); ++i) {
+      values.push_back(uniform(random));
+    }
+  }
+  tensor->write(indices.size(), indices.data(), values.data());
+  return NEW(TensorData<Float64>, tensor);
+}
+} // namespace sisi4s
+
+#endif
@@ -0,0 +1,70 @@
+#include <tests/Test.hpp>
+#include <tests/TestAlgorithm.hpp>
+
+#include <algorithms/PerturbativeTriples.hpp>
+#include <Data.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace {
+// the (T) energy of the given arguments with the given batching
+Float64 getTriplesEnergy(std::vector<Argument> arguments) {
+  const std::string energyName("PerturbativeTriplesTestEnergy");
+  // replaced by the algorithm
+  new RealData(energyName, 0.0);
+  arguments.push_back(Argument("PerturbativeTriplesEnergy", energyName));
+  PerturbativeTriples triples(arguments);
+  triples.run();
+  RealData *energy(dynamic_cast<RealData *>(Data::get(energyName)));
+  REQUIRE(energy);
+  return energy->value;
+}
+} // namespace
+
+TEST_CASE("PerturbativeTriples", "[algorithms]") {
+  const int No(5), Nv(3);
+  std::mt19937 random;
+  // well separated occupied and virtual eigenenergies
+  auto epsi(getRandomTensorData({No}, -2.0, -1.0, random));
+  auto epsa(getRandomTensorData({Nv}, 1.0, 2.0, random));
+  auto Vabij(getRandomTensorData({Nv, Nv, No, No}, -0.1, 0.1, random));
+  auto Vijka(getRandomTensorData({No, No, No, Nv}, -0.1, 0.1, random));
+  auto Vabci(getRandomTensorData({Nv, Nv, Nv, No}, -0.1, 0.1, random));
+  auto Tabij(getRandomTensorData({Nv, Nv, No, No}, -0.1, 0.1, random));
+  auto Tai(getRandomTensorData({Nv, No}, -0.1, 0.1, random));
+  RealData ccsdEnergy(-0.25);
+  const std::vector<Argument> arguments(
+      {Argument("HoleEigenEnergies", epsi->getName()),
+       Argument("ParticleEigenEnergies", epsa->getName()),
+       Argument("PPHHCoulombIntegrals", Vabij->getName()),
+       Argument("HHHPCoulombIntegrals", Vijka->getName()),
+       Argument("PPPHCoulombIntegrals", Vabci->getName()),
+       Argument("CcsdDoublesAmplitudes", Tabij->getName()),
+       Argument("CcsdSinglesAmplitudes", Tai->getName()),
+       Argument("CcsdEnergy", ccsdEnergy.getName())});
+
+  const Float64 unbatched(getTriplesEnergy(arguments));
+  REQUIRE(unbatched != ccsdEnergy.value);
+  // several batches, the last one incomplete, and a single batch
+  for (const int batchSize : {1, 2, 3, No}) {
+    IntegerData batchSizeData(batchSize);
+    std::vector<Argument> batchedArguments(arguments);
+    batchedArguments.push_back(Argument("batchSize", batchSizeData.getName()));
+    const Float64 batched(getTriplesEnergy(batchedArguments));
+    REQUIRE(std::abs(batched - unbatched) < 1e-12 * std::abs(unbatched));
+  }
+
+  // the batch size B=2 derived from the memory budget of the 8 slabs
+  // of Nv^3*B^3 doubles held at the same time
+  const Float64 slabBytes(8.0 * sizeof(Float64) * Nv * Nv * Nv);
+  RealData batchMemory(2 * 2 * 2 * slabBytes);
+  std::vector<Argument> budgetArguments(arguments);
+  budgetArguments.push_back(Argument("batchMemory", batchMemory.getName()));
+  const Float64 budgeted(getTriplesEnergy(budgetArguments));
+  REQUIRE(std::abs(budgeted - unbatched) < 1e-12 * std::abs(unbatched));
+}
@@ -0,0 +1,161 @@
+#include <tests/Test.hpp>
+
+#include <util/Exception.hpp>
+#include <util/SharedPointer.hpp>
+#include <math/EigenSystemDavidson.hpp>
+#include <math/FockVector.hpp>
+#include <util/LapackMatrix.hpp>
+#include <util/LapackGeneralEigenSystem.hpp>
+#include <Sisi4s.hpp>
+#include <vendor/filesystem.hpp>
+
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace fs = ghc::filesystem;
+
+namespace {
+const int No(5), Nv(8), D(No * Nv);
+
+std::vector<Float64> readAll(const FockVector<Float64> &v) {
+  std::vector<Float64> values(D);
+  v.get(0)->read_all(values.data());
+  return values;
+}
+
+// writes the given values to v from the root
+void writeAll(FockVector<Float64> &v, const std::vector<Float64> &values) {
+  std::vector<int64_t> indices;
+  if (Sisi4s::world->rank == 0) {
+    indices.resize(D);
+    std::iota(indices.begin(), indices.end(), 0);
+  }
+  v.get(0)->write(indices.size(), indices.data(), values.data());
+}
+
+FockVector<Float64> getFockVector(const std::vector<Float64> &values) {
+  const int vo[] = {Nv, No}, syms[] = {NS, NS};
+  FockVector<Float64> v(
+      std::vector<PTR(Tensor<Float64>)>(
+          {NEW(Tensor<Float64>, 2, vo, syms, *Sisi4s::world, "Rai")}),
+      std::vector<std::string>({"ai"}));
+  writeAll(v, values);
+  return v;
+}
+
+// a dense symmetric matrix acting on Fock vectors of a singles component
+class DenseHamiltonian {
+public:
+  DenseHamiltonian()
+      : A(D * D) {
+    std::mt19937 random;
+    std::uniform_real_distribution<Float64> uniform(-0.3, 0.3);
+    for (int j(0); j < D; ++j) {
+      A[j + D * j] = j + 1.0;
+      for (int i(0); i < j; ++i) A[i + D * j] = A[j + D * i] = uniform(random);
+    }
+  }
+
+  FockVector<Float64> right_apply(FockVector<Float64> &v) {
+    const std::vector<Float64> x(readAll(v));
+    std::vector<Float64> y(D);
+    for (int j(0); j < D; ++j) {
+      for (int i(0); i < D; ++i) y[i] += A[i + D * j] * x[j];
+    }
+    FockVector<Float64> w(v);
+    writeAll(w, y);
+    return w;
+  }
+
+  std::vector<Float64> A;
+};
+
+class DiagonalPreconditioner {
+public:
+  typedef FockVector<Float64> V;
+
+  DiagonalPreconditioner(const DenseHamiltonian &h)
+      : diagonal(D) {
+    for (int i(0); i < D; ++i) diagonal[i] = h.A[i + D * i];
+  }
+
+  // unit vectors of the lowest diagonal elements, which increase
+  std::vector<V> getInitialBasis(const int eigenVectorsCount) {
+    std::vector<V> basis;
+    for (int b(0); b < eigenVectorsCount; ++b) {
+      std::vector<Float64> values(D);
+      values[b] = 1.0;
+      basis.push_back(getFockVector(values));
+    }
+    return basis;
+  }
+
+  V getCorrection(const complex eigenValue, V &residuum) {
+    std::vector<Float64> values(readAll(residuum));
+    // shifted to avoid vanishing denominators
+    for (int i(0); i < D; ++i) {
+      values[i] /= std::real(eigenValue) - diagonal[i] + 0.05;
+    }
+    V correction(residuum);
+    writeAll(correction, values);
+    return correction;
+  }
+
+  std::vector<Float64> diagonal;
+};
+
+// the lowest eigenvalues found with thick restarts and the given memory
+// budget per process, without limit if zero
+std::vector<complex> getEigenValues(DenseHamiltonian &h,
+                                    const double subspaceMemory,
+                                    const std::string &directory) {
+  DiagonalPreconditioner p(h);
+  EigenSystemDavidsonMono<DenseHamiltonian,
+                          DiagonalPreconditioner,
+                          FockVector<Float64>>
+      eigenSystem(&h, 3, &p, 1e-10, 1e-12, 8, 100, 1);
+  eigenSystem.refreshOnMaxBasisSize(true);
+  eigenSystem.refreshBasisSize(5);
+  if (subspaceMemory > 0.0) {
+    eigenSystem.subspaceMemory(subspaceMemory, directory);
+  }
+  eigenSystem.run();
+  return eigenSystem.getEigenValues();
+}
+} // namespace
+
+TEST_CASE("EigenSystemDavidsonMono", "[math]") {
+  const std::string directory("EigenSystemDavidsonTest");
+  if (Sisi4s::world->rank == 0) fs::create_directories(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+  DenseHamiltonian h;
+
+  const std::vector<complex> inMemory(getEigenValues(h, 0.0, directory));
+  // the share of a vector stored by each process
+  const double vectorBytes(D * sizeof(Float64) / double(Sisi4s::world->np));
+  // two basis and two sigma vectors in memory, the others spilled
+  const std::vector<complex> spilled(
+      getEigenValues(h, 4.0 * vectorBytes, directory));
+
+  LapackMatrix<complex> A(D, D);
+  for (int j(0); j < D; ++j) {
+    for (int i(0); i < D; ++i) A(i, j) = h.A[i + D * j];
+  }
+  LapackGeneralEigenSystem<complex> exact(A, false);
+  REQUIRE(spilled.size() == inMemory.size());
+  for (size_t k(0); k < inMemory.size(); ++k) {
+    REQUIRE(std::abs(inMemory[k] - exact.getEigenValues()[k]) < 1e-6);
+    REQUIRE(std::abs(spilled[k] - inMemory[k]) < 1e-12);
+  }
+
+  // the spilled vectors are removed
+  MPI_Barrier(Sisi4s::world->comm);
+  REQUIRE(fs::is_empty(directory));
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) fs::remove_all(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+}
@@ -0,0 +1,99 @@
+#include <tests/Test.hpp>
+
+#include <math/FockVectorBlock.hpp>
+#include <Sisi4s.hpp>
+
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace {
+// distinct values for each index i of component c of vector k
+Float64 getValue(Float64, const int64_t i, const int c, const int k) {
+  return std::cos(i * (k + 1) + c) / (i + k + 1.0);
+}
+
+Complex64 getValue(Complex64, const int64_t i, const int c, const int k) {
+  return Complex64(getValue(Float64(), i, c, k),
+                   getValue(Float64(), i, c, k + 7));
+}
+
+// a Fock vector with a singles and a doubles component
+template <typename F>
+FockVector<F> getFockVector(const int k) {
+  const int vo[] = {4, 3}, vvoo[] = {4, 4, 3, 3};
+  const int syms[] = {NS, NS, NS, NS};
+  std::vector<PTR(Tensor<F>)> tensors(
+      {NEW(Tensor<F>, 2, vo, syms, *Sisi4s::world, "Rai"),
+       NEW(Tensor<F>, 4, vvoo, syms, *Sisi4s::world, "Rabij")});
+  for (size_t c(0); c < tensors.size(); ++c) {
+    std::vector<int64_t> indices;
+    std::vector<F> values;
+    if (Sisi4s::world->rank == 0) {
+      indices.resize(tensors[c]->get_tot_size(false));
+      std::iota(indices.begin(), indices.end(), 0);
+      for (auto i : indices) values.push_back(getValue(F(), i, c, k));
+    }
+    tensors[c]->write(indices.size(), indices.data(), values.data());
+  }
+  return FockVector<F>(tensors, std::vector<std::string>({"ai", "abij"}));
+}
+
+template <typename F>
+std::vector<F> readAll(const FockVector<F> &v) {
+  std::vector<F> values;
+  for (size_t i(0); i < v.get_components_count(); ++i) {
+    std::vector<F> componentValues(v.get(i)->get_tot_size(false));
+    v.get(i)->read_all(componentValues.data());
+    values.insert(values.end(), componentValues.begin(), componentValues.end());
+  }
+  return values;
+}
+
+template <typename F>
+void testFockVectorBlock() {
+  std::vector<FockVector<F>> bras, kets;
+  for (int k(0); k < 3; ++k) bras.push_back(getFockVector<F>(k));
+  for (int k(3); k < 5; ++k) kets.push_back(getFockVector<F>(k));
+
+  // pack and unpack
+  const FockVector<F> braBlock(packFockVectors<F>(bras.begin(), bras.end()));
+  REQUIRE(getFockVectorBlockSize(braBlock) == 3);
+  REQUIRE(braBlock.get_components_count() == 2);
+  REQUIRE(braBlock.get_indices(0) == "aiZ");
+  REQUIRE(braBlock.get_indices(1) == "abijZ");
+  // unpacked into vectors of the same shape but other values
+  const std::vector<FockVector<F>> unpacked(unpackFockVectors(
+      braBlock, std::vector<FockVector<F>>(bras.size(), kets.front())));
+  for (size_t k(0); k < bras.size(); ++k) {
+    REQUIRE(readAll(unpacked[k]) == readAll(bras[k]));
+  }
+
+  // pack shared pointers
+  std::vector<PTR(FockVector<F>)> pointers;
+  for (auto &bra : bras) pointers.push_back(NEW(FockVector<F>, bra));
+  FockVector<F> v(kets.front());
+  unpackFockVector(packFockVectors<F>(pointers.begin(), pointers.end()), 2, v);
+  REQUIRE(readAll(v) == readAll(bras[2]));
+
+  // block overlaps equal the pairwise dot products
+  const std::vector<F> overlaps(getFockVectorBlockOverlaps(
+      braBlock, packFockVectors<F>(kets.begin(), kets.end())));
+  REQUIRE(overlaps.size() == bras.size() * kets.size());
+  for (size_t z(0); z < kets.size(); ++z) {
+    for (size_t y(0); y < bras.size(); ++y) {
+      const F expected(bras[y].dot(kets[z]));
+      REQUIRE(std::abs(overlaps[y + bras.size() * z] - expected)
+              < 1e-12 * std::abs(expected));
+    }
+  }
+}
+} // namespace
+
+TEST_CASE("FockVectorBlock", "[math]") {
+  SECTION("real") { testFockVectorBlock<Float64>(); }
+  SECTION("complex") { testFockVectorBlock<Complex64>(); }
+}
@@ -0,0 +1,102 @@
+#include <tests/Test.hpp>
+
+#include <math/FockVectorStore.hpp>
+#include <Sisi4s.hpp>
+#include <vendor/filesystem.hpp>
+
+#include <cmath>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace fs = ghc::filesystem;
+
+namespace {
+// a Fock vector with distinct values for each k
+FockVector<Float64> getFockVector(const int k) {
+  const int vo[] = {4, 3}, vvoo[] = {4, 4, 3, 3};
+  const int syms[] = {NS, NS, NS, NS};
+  std::vector<PTR(Tensor<Float64>)> tensors(
+      {NEW(Tensor<Float64>, 2, vo, syms, *Sisi4s::world, "Rai"),
+       NEW(Tensor<Float64>, 4, vvoo, syms, *Sisi4s::world, "Rabij")});
+  for (size_t c(0); c < tensors.size(); ++c) {
+    std::vector<int64_t> indices;
+    std::vector<Float64> values;
+    if (Sisi4s::world->rank == 0) {
+      indices.resize(tensors[c]->get_tot_size(false));
+      std::iota(indices.begin(), indices.end(), 0);
+      for (auto i : indices) values.push_back(std::cos(i * (k + 1.0) + c));
+    }
+    tensors[c]->write(indices.size(), indices.data(), values.data());
+  }
+  return FockVector<Float64>(tensors,
+                             std::vector<std::string>({"ai", "abij"}));
+}
+
+std::vector<Float64> readAll(const FockVector<Float64> &v) {
+  std::vector<Float64> values;
+  for (size_t i(0); i < v.get_components_count(); ++i) {
+    std::vector<Float64> componentValues(v.get(i)->get_tot_size(false));
+    v.get(i)->read_all(componentValues.data());
+    values.insert(values.end(), componentValues.begin(), componentValues.end());
+  }
+  return values;
+}
+} // namespace
+
+TEST_CASE("FockVectorStore", "[math]") {
+  const std::string directory("FockVectorStoreTest");
+  if (Sisi4s::world->rank == 0) fs::create_directories(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+
+  SECTION("spill and reload") {
+    {
+      FockVectorStore<FockVector<Float64>> store("store");
+      store.setMaxResident(2, directory);
+      for (int k(0); k < 5; ++k) store.push_back(getFockVector(k));
+      REQUIRE(store.size() == 5);
+      REQUIRE(store.getSpilledCount() == 3);
+      MPI_Barrier(Sisi4s::world->comm);
+      REQUIRE_FALSE(fs::is_empty(directory));
+      for (int k(0); k < 5; ++k) {
+        REQUIRE(readAll(*store.get(k)) == readAll(getFockVector(k)));
+      }
+      store.clear();
+      REQUIRE(store.size() == 0);
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    REQUIRE(fs::is_empty(directory));
+  }
+
+  SECTION("swap") {
+    {
+      FockVectorStore<FockVector<Float64>> a("a"), b("b");
+      a.setMaxResident(1, directory);
+      for (int k(0); k < 3; ++k) a.push_back(getFockVector(k));
+      b.push_back(getFockVector(3));
+      a.swap(b);
+      REQUIRE(a.size() == 1);
+      REQUIRE(a.getMaxResident() == 0);
+      REQUIRE(b.size() == 3);
+      REQUIRE(b.getMaxResident() == 1);
+      REQUIRE(b.getSpilledCount() == 2);
+      // the spilled vectors are found under their new owner
+      for (int k(0); k < 3; ++k) {
+        REQUIRE(readAll(*b.get(k)) == readAll(getFockVector(k)));
+      }
+      // raising the limit keeps the spilled vectors on disk
+      b.setMaxResident(3, directory);
+      b.push_back(getFockVector(4));
+      REQUIRE(b.getSpilledCount() == 2);
+      REQUIRE(readAll(*b.get(0)) == readAll(getFockVector(0)));
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    REQUIRE(fs::is_empty(directory));
+  }
+
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) fs::remove_all(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+}
@@ -0,0 +1,86 @@
+#include <tests/Test.hpp>
+
+#include <math/QuarterTransformation.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace sisi4s;
+
+TEST_CASE("QuarterTransformation", "[math]") {
+  // basis functions, orbitals and leading dimension of the coefficients
+  constexpr size_t N(5), Np(4), ldC(6);
+  std::mt19937 random;
+  std::normal_distribution<double> normalDistribution(0.0, 1.0);
+  std::vector<double> V(N * N * N * N), C(ldC * Np);
+  for (auto &v : V) v = normalDistribution(random);
+  for (auto &c : C) c = normalDistribution(random);
+
+  SECTION("chemist to physics notation") {
+    // distinct ranges and offsets for each orbital index
+    const size_t p0(1), P(3), q0(0), Q(2), r0(2), R(2), s0(0), S(4);
+    const std::vector<double> result(transformChemistToPhysics(V.data(),
+                                                               N,
+                                                               C.data(),
+                                                               ldC,
+                                                               p0,
+                                                               P,
+                                                               q0,
+                                                               Q,
+                                                               r0,
+                                                               R,
+                                                               s0,
+                                                               S));
+    REQUIRE(result.size() == P * Q * R * S);
+    for (size_t s(0); s < S; ++s) {
+      for (size_t r(0); r < R; ++r) {
+        for (size_t q(0); q < Q; ++q) {
+          for (size_t p(0); p < P; ++p) {
+            // <pq|rs> = (pr|qs) = sum_abcd C(a,p) C(b,r) C(c,q) C(d,s) (ab|cd)
+            double expected(0.0);
+            for (size_t d(0); d < N; ++d) {
+              for (size_t c(0); c < N; ++c) {
+                for (size_t b(0); b < N; ++b) {
+                  for (size_t a(0); a < N; ++a) {
+                    expected += C[a + (p0 + p) * ldC] * C[b + (r0 + r) * ldC]
+                              * C[c + (q0 + q) * ldC] * C[d + (s0 + s) * ldC]
+                              * V[a + b * N + c * N * N + d * N * N * N];
+                  }
+                }
+              }
+            }
+            REQUIRE(std::abs(result[p + q * P + r * P * Q + s * P * Q * R]
+                             - expected)
+                    < 1e-12);
+          }
+        }
+      }
+    }
+  }
+
+  SECTION("slower index of a matrix") {
+    const size_t M(3), p0(1), P(3), ldOut(4);
+    std::vector<double> out(ldOut * M, -1.0);
+    transformSlowerIndex(V.data(),
+                         M,
+                         N,
+                         C.data(),
+                         ldC,
+                         p0,
+                         P,
+                         out.data(),
+                         ldOut);
+    for (size_t m(0); m < M; ++m) {
+      for (size_t p(0); p < P; ++p) {
+        double expected(0.0);
+        for (size_t l(0); l < N; ++l) {
+          expected += V[m + l * M] * C[l + (p0 + p) * ldC];
+        }
+        REQUIRE(std::abs(out[p + m * ldOut] - expected) < 1e-12);
+      }
+      // padding up to the leading dimension remains untouched
+      REQUIRE(out[P + m * ldOut] == -1.0);
+    }
+  }
+}
@@ -0,0 +1,47 @@
+#include <tests/Test.hpp>
+
+#include <math/ScfDiis.hpp>
+
+#include <cmath>
+
+using namespace sisi4s;
+
+TEST_CASE("ScfDiis", "[math]") {
+  const Eigen::MatrixXd S(Eigen::MatrixXd::Identity(2, 2));
+  Eigen::MatrixXd D(2, 2), F1(2, 2), F2(2, 2);
+  D << 1.0, 0.0, 0.0, 0.0;
+  F1 << 0.0, 1.0, 1.0, 0.0;
+  F2 << 1.0, -2.0, -2.0, 0.0;
+  // the commutator errors are e1 = ((0,-1),(1,0)) and e2 = -2 e1,
+  // such that c1 e1 + c2 e2 vanishes for c1 = 2/3 and c2 = 1/3
+  Eigen::MatrixXd expected(2, 2);
+  expected << 1.0 / 3.0, 0.0, 0.0, 0.0;
+
+  SECTION("two vectors") {
+    ScfDiis<Eigen::MatrixXd> diis(4);
+    // a single matrix is returned unchanged
+    REQUIRE((diis.extrapolate(F1, D, S) - F1).norm() < 1e-14);
+    REQUIRE(std::abs(diis.getErrorNorm() - std::sqrt(2.0)) < 1e-14);
+    const Eigen::MatrixXd F(diis.extrapolate(F2, D, S));
+    REQUIRE(diis.getSubspaceSize() == 2);
+    REQUIRE(std::abs(diis.getErrorNorm() - std::sqrt(8.0)) < 1e-14);
+    REQUIRE((F - expected).norm() < 1e-14);
+  }
+
+  SECTION("subspace size") {
+    ScfDiis<Eigen::MatrixXd> diis(2);
+    diis.extrapolate(F2, D, S);
+    diis.extrapolate(F2, D, S);
+    // the oldest matrix is dropped
+    const Eigen::MatrixXd F(diis.extrapolate(F1, D, S));
+    REQUIRE(diis.getSubspaceSize() == 2);
+    REQUIRE((F - expected).norm() < 1e-14);
+  }
+
+  SECTION("disabled") {
+    ScfDiis<Eigen::MatrixXd> diis(1);
+    diis.extrapolate(F1, D, S);
+    REQUIRE((diis.extrapolate(F2, D, S) - F2).norm() < 1e-14);
+    REQUIRE(diis.getSubspaceSize() == 0);
+  }
+}
@@ -0,0 +1,186 @@
+#include <tests/Test.hpp>
+#include <tests/TestAlgorithm.hpp>
+
+#include <mixers/DiisMixer.hpp>
+#include <util/Checkpoint.hpp>
+#include <Data.hpp>
+#include <Sisi4s.hpp>
+#include <vendor/filesystem.hpp>
+
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace fs = ghc::filesystem;
+
+namespace {
+// a Fock vector with the given value at each global index
+template <typename F>
+PTR(FockVector<F>) getFockVector(const std::function<F(int64_t)> &value) {
+  const int vo[] = {4, 3}, syms[] = {NS, NS};
+  auto tensor(NEW(Tensor<F>, 2, vo, syms, *Sisi4s::world, "Rai"));
+  std::vector<int64_t> indices;
+  std::vector<F> values;
+  if (Sisi4s::world->rank == 0) {
+    indices.resize(tensor->get_tot_size(false));
+    std::iota(indices.begin(), indices.end(), 0);
+    for (auto index : indices) values.push_back(value(index));
+  }
+  tensor->write(indices.size(), indices.data(), values.data());
+  return NEW(FockVector<F>,
+             std::vector<PTR(Tensor<F>)>({tensor}),
+             std::vector<std::string>({"ai"}));
+}
+
+// linearly independent residua for different k
+PTR(FockVector<Float64>) getResiduum(const int k) {
+  return getFockVector<Float64>(
+      [k](int64_t i) { return std::cos(i * (k + 1)) / (i + k + 1); });
+}
+
+// amplitudes belonging to the residuum k
+PTR(FockVector<Float64>) getAmplitudes(const int k) {
+  return getFockVector<Float64>(
+      [k](int64_t i) { return std::sin(i + k) / (k + 1); });
+}
+
+void requireClose(const FockVector<Float64> &a, const FockVector<Float64> &b) {
+  FockVector<Float64> difference(a);
+  difference -= b;
+  REQUIRE(difference.dot(difference) < 1e-24);
+}
+} // namespace
+
+TEST_CASE("DiisMixer", "[mixers]") {
+  IntegerData maxResidua(4);
+
+  SECTION("complex residua") {
+    TestAlgorithm algorithm({Argument("maxResidua", maxResidua.getName())});
+    DiisMixer<Complex64> mixer(&algorithm);
+    const int N(4);
+    for (int k(0); k < 3; ++k) {
+      auto R(getFockVector<Complex64>([k](int64_t i) {
+        return Complex64(std::cos(i * (k + 1)), std::sin(i * k + 1))
+             / (i + 1.0);
+      }));
+      mixer.append(R, R);
+    }
+    REQUIRE(mixer.count == 3);
+    std::vector<int> indices({0, 1, 2});
+    for (int i : indices) {
+      // real diagonal
+      REQUIRE(std::imag(mixer.B[i + N * i]) == 0.0);
+      for (int j : indices) {
+        REQUIRE(std::abs(mixer.B[i + N * j] - std::conj(mixer.B[j + N * i]))
+                < 1e-14);
+      }
+    }
+    Complex64 sum(0.0);
+    for (int i : indices) sum += mixer.weights[i];
+    REQUIRE(std::abs(sum - 1.0) < 1e-12);
+    // the weights minimize c^H B c, such that (B c)_i is the same for all i
+    std::vector<Complex64> Bc(N);
+    for (int i : indices) {
+      for (int j : indices) Bc[i] += mixer.B[i + N * j] * mixer.weights[j];
+    }
+    for (int i : indices) REQUIRE(std::abs(Bc[i] - Bc[0]) < 1e-10);
+    // the estimate is the weighted sum of the residua given as amplitudes
+    Complex64 norm(mixer.get()->dot(*mixer.get()));
+    REQUIRE(std::abs(2.0 * norm - Bc[0]) < 1e-10);
+  }
+
+  SECTION("prune ill-conditioned subspace") {
+    TestAlgorithm algorithm({Argument("maxResidua", maxResidua.getName())});
+    DiisMixer<Float64> mixer(&algorithm);
+    REQUIRE_FALSE(mixer.restartIllConditioned);
+    mixer.append(getResiduum(0), getResiduum(0));
+    mixer.append(getResiduum(1), getResiduum(1));
+    // linearly dependent on the oldest residuum
+    mixer.append(getResiduum(0), getResiduum(0));
+    // only the oldest vector is dropped
+    REQUIRE(mixer.count == 2);
+    REQUIRE(!mixer.residua[0]);
+    REQUIRE(mixer.residua[1]);
+    REQUIRE(mixer.residua[2]);
+    REQUIRE(std::abs(mixer.weights[1] + mixer.weights[2] - 1.0) < 1e-12);
+  }
+
+  SECTION("restart ill-conditioned subspace") {
+    TextData restart("restart");
+    TestAlgorithm algorithm(
+        {Argument("maxResidua", maxResidua.getName()),
+         Argument("illConditionedSubspace", restart.getName())});
+    DiisMixer<Float64> mixer(&algorithm);
+    REQUIRE(mixer.restartIllConditioned);
+    mixer.append(getResiduum(0), getResiduum(0));
+    mixer.append(getResiduum(1), getResiduum(1));
+    mixer.append(getResiduum(0), getResiduum(0));
+    // all but the newest vector are dropped
+    REQUIRE(mixer.count == 1);
+    REQUIRE(!mixer.residua[0]);
+    REQUIRE(!mixer.residua[1]);
+    REQUIRE(std::abs(mixer.weights[2] - 1.0) < 1e-14);
+    const auto R(getResiduum(0));
+    *R -= *mixer.get();
+    REQUIRE(R->dot(*R) < 1e-24);
+  }
+
+  SECTION("subspace on disk") {
+    const std::string directory("DiisMixerTest");
+    if (Sisi4s::world->rank == 0) fs::create_directories(directory);
+    MPI_Barrier(Sisi4s::world->comm);
+    {
+      TextData subspace(directory);
+      TestAlgorithm inMemory({Argument("maxResidua", maxResidua.getName())});
+      TestAlgorithm onDisk(
+          {Argument("maxResidua", maxResidua.getName()),
+           Argument("subspaceDirectory", subspace.getName())});
+      DiisMixer<Float64> memoryMixer(&inMemory), diskMixer(&onDisk);
+      // more pairs than residua, such that the subspace wraps around
+      for (int k(0); k < 6; ++k) {
+        memoryMixer.append(getAmplitudes(k), getResiduum(k));
+        diskMixer.append(getAmplitudes(k), getResiduum(k));
+        REQUIRE(diskMixer.count == memoryMixer.count);
+        requireClose(*diskMixer.get(), *memoryMixer.get());
+        requireClose(*diskMixer.getResiduum(), *memoryMixer.getResiduum());
+      }
+      // only the last appended pair is in memory
+      REQUIRE(diskMixer.residua[(diskMixer.nextIndex + 3) % 4]);
+      REQUIRE(!diskMixer.residua[diskMixer.nextIndex]);
+
+      {
+        Checkpoint checkpoint(directory, "Test");
+        checkpoint.begin();
+        diskMixer.writeCheckpoint(checkpoint);
+        checkpoint.commit();
+      }
+      Checkpoint checkpoint(directory, "Test");
+      REQUIRE(checkpoint.load());
+      DiisMixer<Float64> restored(&onDisk);
+      restored.readCheckpoint(checkpoint);
+      requireClose(*restored.get(), *memoryMixer.get());
+      // continues from the subspace on disk as the mixer in memory
+      for (int k(6); k < 8; ++k) {
+        memoryMixer.append(getAmplitudes(k), getResiduum(k));
+        restored.append(getAmplitudes(k), getResiduum(k));
+        REQUIRE(restored.count == memoryMixer.count);
+        requireClose(*restored.get(), *memoryMixer.get());
+        requireClose(*restored.getResiduum(), *memoryMixer.getResiduum());
+      }
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    if (Sisi4s::world->rank == 0) fs::remove_all(directory);
+    MPI_Barrier(Sisi4s::world->comm);
+  }
+
+  SECTION("unknown treatment") {
+    TextData unknown("ignore");
+    TestAlgorithm algorithm(
+        {Argument("illConditionedSubspace", unknown.getName())});
+    REQUIRE_THROWS(DiisMixer<Float64>(&algorithm));
+  }
+}
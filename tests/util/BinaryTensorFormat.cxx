@@ -0,0 +1,164 @@
+#include <tests/Test.hpp>
+
+#include <util/BinaryTensorFormat.hpp>
+#include <util/TensorIo.hpp>
+#include <Sisi4s.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+TEST_CASE("BinaryTensorCodec", "[util]") {
+  SECTION("checksum") {
+    // check value of CRC-32
+    const std::string data("123456789");
+    REQUIRE(BinaryTensorCodec::getChecksum(data.data(), data.size())
+            == 0xcbf43926u);
+  }
+
+  SECTION("filters") {
+    // doubles with runs of zeros and random ones
+    std::mt19937 random;
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::vector<double> words(1000);
+    for (size_t i(0); i < words.size(); ++i) {
+      words[i] = i % 100 < 60 ? 0.0 : uniform(random);
+    }
+    const char *bytes(reinterpret_cast<const char *>(words.data()));
+    const std::vector<char> original(bytes,
+                                     bytes + words.size() * sizeof(double));
+    for (const std::string name : {"none", "shuffle", "rle"}) {
+      const int32_t filters(BinaryTensorCodec::getFilters(name));
+      std::vector<char> data(original);
+      const int32_t applied(
+          BinaryTensorCodec::encode(data, filters, sizeof(double)));
+      REQUIRE((applied & ~filters) == 0);
+      if (name == "rle") REQUIRE(data.size() < original.size());
+      BinaryTensorCodec::decode(data, applied, sizeof(double), original.size());
+      REQUIRE(data == original);
+    }
+  }
+
+  SECTION("incompressible data") {
+    // run length encoding is only applied if it reduces the size
+    std::vector<char> original(256);
+    for (size_t i(0); i < original.size(); ++i) original[i] = char(i);
+    std::vector<char> data(original);
+    const int32_t applied(
+        BinaryTensorCodec::encode(data, BinaryTensorCodec::RUN_LENGTH, 1));
+    REQUIRE((applied & BinaryTensorCodec::RUN_LENGTH) == 0);
+    REQUIRE(data == original);
+  }
+}
+
+namespace {
+template <typename F>
+std::vector<F> readAll(Tensor<F> &A) {
+  std::vector<F> values(A.get_tot_size(false));
+  A.read_all(values.data());
+  return values;
+}
+
+// writes the given values to A from the root
+template <typename F>
+void writeAll(Tensor<F> &A, const std::vector<F> &values) {
+  std::vector<int64_t> indices;
+  if (Sisi4s::world->rank == 0) {
+    indices.resize(values.size());
+    std::iota(indices.begin(), indices.end(), 0);
+  }
+  A.write(indices.size(), indices.data(), values.data());
+}
+} // namespace
+
+TEST_CASE("BinaryTensorFormat", "[util]") {
+  const std::string fileName("BinaryTensorFormatTest.bin");
+  const int lens[] = {5, 7, 3}, syms[] = {NS, NS, NS};
+  std::vector<Float64> aValues(5 * 7 * 3);
+  std::vector<Complex<Float64>> bValues(aValues.size());
+  for (size_t i(0); i < aValues.size(); ++i) {
+    // a run of zeros, compressed by run length encoding
+    aValues[i] = i < 40 ? 0.0 : 1.0 / (i + 1);
+    bValues[i] = Complex<Float64>(i, -0.5 * i);
+  }
+  Tensor<Float64> A(3, lens, syms, *Sisi4s::world, "A");
+  writeAll(A, aValues);
+  Tensor<Complex<Float64>> B(3, lens, syms, *Sisi4s::world, "B");
+  writeAll(B, bValues);
+
+  struct Format {
+    int32_t version, filters;
+  };
+  const std::vector<Format> formats(
+      {{BinaryTensorHeaderBase::DENSE_VERSION, BinaryTensorCodec::NONE},
+       {BinaryTensorHeaderBase::CHUNKED_VERSION, BinaryTensorCodec::NONE},
+       {BinaryTensorHeaderBase::CHUNKED_VERSION,
+        BinaryTensorCodec::SHUFFLE | BinaryTensorCodec::RUN_LENGTH}});
+
+  SECTION("round trip") {
+    for (const auto &format : formats) {
+      // several chunks, the last one incomplete
+      TensorIo::writeBinary<Float64>(fileName,
+                                     A,
+                                     format.version,
+                                     format.filters,
+                                     16);
+      Tensor<Float64> *a(TensorIo::readBinary<Float64>(fileName));
+      REQUIRE(readAll(*a) == aValues);
+      delete a;
+
+      TensorIo::writeBinary<Complex<Float64>>(fileName,
+                                              B,
+                                              format.version,
+                                              format.filters,
+                                              16);
+      Tensor<Complex<Float64>> *b(
+          TensorIo::readBinary<Complex<Float64>>(fileName));
+      REQUIRE(readAll(*b) == bValues);
+      delete b;
+    }
+  }
+
+  SECTION("default version") {
+    // version 1 is written by default, as read by the serial readers
+    TensorIo::writeBinary<Float64>(fileName, A);
+    BinaryTensorHeader header;
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    REQUIRE(header.version == int32_t(BinaryTensorHeaderBase::DENSE_VERSION));
+  }
+
+  SECTION("checksum") {
+    TensorIo::writeBinary<Float64>(fileName,
+                                   A,
+                                   BinaryTensorHeaderBase::CHUNKED_VERSION,
+                                   BinaryTensorCodec::NONE,
+                                   16);
+    MPI_Barrier(Sisi4s::world->comm);
+    if (Sisi4s::world->rank == 0) {
+      // flip a bit in the encoded data of the first data chunk
+      std::fstream file(fileName.c_str(),
+                        std::ios::binary | std::ios::in | std::ios::out);
+      const std::string contents((std::istreambuf_iterator<char>(file)),
+                                 std::istreambuf_iterator<char>());
+      const size_t dataOffset(contents.find(BinaryTensorChunkHeader::DATA)
+                              + sizeof(BinaryTensorChunkHeader)
+                              + sizeof(BinaryTensorDataChunk));
+      REQUIRE(dataOffset < contents.size());
+      file.seekp(dataOffset);
+      file.put(contents[dataOffset] ^ 1);
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    // all processes fail
+    REQUIRE_THROWS(TensorIo::readBinary<Float64>(fileName));
+  }
+
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) std::remove(fileName.c_str());
+}
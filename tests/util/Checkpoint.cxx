@@ -0,0 +1,203 @@
+#include <tests/Test.hpp>
+#include <tests/TestAlgorithm.hpp>
+
+#include <util/Checkpoint.hpp>
+#include <mixers/DiisMixer.hpp>
+#include <Data.hpp>
+#include <Sisi4s.hpp>
+#include <vendor/filesystem.hpp>
+
+#include <limits>
+#include <numeric>
+#include <string>
+#include <vector>
+
+using namespace sisi4s;
+
+namespace fs = ghc::filesystem;
+
+namespace {
+// a Fock vector of two components with the values offset, offset+step, ...
+template <typename F>
+PTR(FockVector<F>) getFockVector(const F offset, const F step) {
+  const int vo[] = {4, 3}, vvoo[] = {4, 4, 3, 3};
+  const int syms[] = {NS, NS, NS, NS};
+  std::vector<PTR(Tensor<F>)> tensors(
+      {NEW(Tensor<F>, 2, vo, syms, *Sisi4s::world, "Rai"),
+       NEW(Tensor<F>, 4, vvoo, syms, *Sisi4s::world, "Rabij")});
+  for (auto &tensor : tensors) {
+    std::vector<int64_t> indices;
+    std::vector<F> values;
+    if (Sisi4s::world->rank == 0) {
+      indices.resize(tensor->get_tot_size(false));
+      std::iota(indices.begin(), indices.end(), 0);
+      for (auto index : indices) values.push_back(offset + F(index) * step);
+    }
+    tensor->write(indices.size(), indices.data(), values.data());
+  }
+  return NEW(FockVector<F>,
+             tensors,
+             std::vector<std::string>({"ai", "abij"}));
+}
+
+template <typename F>
+std::vector<F> readAll(const FockVector<F> &v) {
+  std::vector<F> values;
+  for (size_t i(0); i < v.get_components_count(); ++i) {
+    std::vector<F> componentValues(v.get(i)->get_tot_size(false));
+    v.get(i)->read_all(componentValues.data());
+    values.insert(values.end(), componentValues.begin(), componentValues.end());
+  }
+  return values;
+}
+
+template <typename F>
+void requireEqual(const FockVector<F> &a, const FockVector<F> &b) {
+  REQUIRE(a.get_components_count() == b.get_components_count());
+  for (size_t i(0); i < a.get_components_count(); ++i) {
+    REQUIRE(a.get_indices(i) == b.get_indices(i));
+  }
+  REQUIRE(readAll(a) == readAll(b));
+}
+} // namespace
+
+TEST_CASE("Checkpoint", "[util]") {
+  const std::string directory("CheckpointTest");
+  // values not exactly representable in decimal
+  const Float64 third(1.0 / 3.0), tiny(std::numeric_limits<Float64>::min());
+  const Complex64 z(-0.1, 2.0 / 3.0);
+  const std::vector<Float64> xs({third, -tiny, 1e300, 0.0});
+  const std::vector<Complex64> zs({z, Complex64(tiny, -third)});
+  auto u(getFockVector<Float64>(third, 0.1));
+  auto v(getFockVector<Complex64>(z, Complex64(0.0, 0.7)));
+
+  SECTION("round trip") {
+    {
+      Checkpoint checkpoint(directory, "Test");
+      REQUIRE_FALSE(checkpoint.load());
+      checkpoint.begin();
+      checkpoint.setInteger("iteration", 7);
+      checkpoint.setScalar<Float64>("energy", third);
+      checkpoint.setScalar<Complex64>("lambda", z);
+      checkpoint.setScalars<Float64>("reals", xs);
+      checkpoint.setScalars<Complex64>("complexes", zs);
+      checkpoint.writeFockVector<Float64>("u", *u);
+      checkpoint.writeFockVector<Complex64>("v", *v);
+      checkpoint.commit();
+    }
+
+    Checkpoint checkpoint(directory, "Test");
+    REQUIRE(checkpoint.load());
+    REQUIRE(checkpoint.has("iteration"));
+    REQUIRE(checkpoint.has("u"));
+    REQUIRE_FALSE(checkpoint.has("w"));
+    REQUIRE(checkpoint.getInteger("iteration") == 7);
+    REQUIRE(checkpoint.getScalar<Float64>("energy") == third);
+    REQUIRE(checkpoint.getScalar<Complex64>("lambda") == z);
+    REQUIRE(checkpoint.getScalars<Float64>("reals") == xs);
+    REQUIRE(checkpoint.getScalars<Complex64>("complexes") == zs);
+    requireEqual(*checkpoint.readFockVector<Float64>("u"), *u);
+    requireEqual(*checkpoint.readFockVector<Complex64>("v"), *v);
+    REQUIRE_THROWS(checkpoint.getInteger("missing"));
+  }
+
+  SECTION("generations") {
+    {
+      Checkpoint checkpoint(directory, "Test");
+      checkpoint.begin();
+      checkpoint.setInteger("iteration", 1);
+      checkpoint.writeFockVector<Float64>("u", *u);
+      checkpoint.commit();
+    }
+    {
+      // continue from the written checkpoint as a restarted run would
+      Checkpoint checkpoint(directory, "Test");
+      REQUIRE(checkpoint.load());
+      checkpoint.begin();
+      checkpoint.setInteger("iteration", 2);
+      auto w(getFockVector<Float64>(1.0, -0.5));
+      checkpoint.writeFockVector<Float64>("u", *w);
+      // the previous checkpoint remains valid until commit
+      Checkpoint previous(directory, "Test");
+      REQUIRE(previous.load());
+      REQUIRE(previous.getInteger("iteration") == 1);
+      requireEqual(*previous.readFockVector<Float64>("u"), *u);
+      checkpoint.commit();
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    Checkpoint checkpoint(directory, "Test");
+    REQUIRE(checkpoint.load());
+    REQUIRE(checkpoint.getInteger("iteration") == 2);
+    requireEqual(*checkpoint.readFockVector<Float64>("u"),
+                 *getFockVector<Float64>(1.0, -0.5));
+    // only the files of the last generation remain
+    REQUIRE_FALSE(fs::exists(directory + "/Test-1-u-0.bin"));
+    REQUIRE_FALSE(fs::exists(directory + "/Test-1-u-1.bin"));
+    REQUIRE(fs::exists(directory + "/Test-2-u-0.bin"));
+    REQUIRE(fs::exists(directory + "/Test-2-u-1.bin"));
+    REQUIRE_FALSE(fs::exists(directory + "/Test-checkpoint.yaml.tmp"));
+  }
+
+  SECTION("remove") {
+    {
+      Checkpoint checkpoint(directory, "Test");
+      checkpoint.begin();
+      checkpoint.setInteger("iteration", 1);
+      checkpoint.writeFockVector<Float64>("u", *u);
+      checkpoint.commit();
+      REQUIRE(fs::exists(directory + "/Test-1-u-0.bin"));
+      checkpoint.remove();
+    }
+    MPI_Barrier(Sisi4s::world->comm);
+    REQUIRE_FALSE(fs::exists(directory + "/Test-checkpoint.yaml"));
+    REQUIRE_FALSE(fs::exists(directory + "/Test-1-u-0.bin"));
+    REQUIRE_FALSE(fs::exists(directory + "/Test-1-u-1.bin"));
+    Checkpoint checkpoint(directory, "Test");
+    REQUIRE_FALSE(checkpoint.load());
+  }
+
+  SECTION("mixer") {
+    IntegerData maxResidua(3);
+    TestAlgorithm algorithm({Argument("maxResidua", maxResidua.getName())});
+    DiisMixer<Float64> mixer(&algorithm);
+    // more pairs than residua, such that the subspace wraps around
+    for (int k(0); k < 4; ++k) {
+      mixer.append(getFockVector<Float64>(k, 0.25),
+                   getFockVector<Float64>(1.0 / (k + 1), -0.5 * k));
+    }
+    {
+      Checkpoint checkpoint(directory, "Test");
+      checkpoint.begin();
+      mixer.writeCheckpoint(checkpoint);
+      checkpoint.commit();
+    }
+
+    Checkpoint checkpoint(directory, "Test");
+    REQUIRE(checkpoint.load());
+    DiisMixer<Float64> restored(&algorithm);
+    restored.readCheckpoint(checkpoint);
+    REQUIRE(restored.nextIndex == mixer.nextIndex);
+    REQUIRE(restored.count == mixer.count);
+    REQUIRE(restored.B == mixer.B);
+    requireEqual(*restored.get(), *mixer.get());
+    requireEqual(*restored.getResiduum(), *mixer.getResiduum());
+    for (size_t i(0); i < mixer.residua.size(); ++i) {
+      REQUIRE(bool(restored.residua[i]) == bool(mixer.residua[i]));
+      if (!mixer.residua[i]) continue;
+      requireEqual(*restored.amplitudes[i], *mixer.amplitudes[i]);
+      requireEqual(*restored.residua[i], *mixer.residua[i]);
+    }
+
+    // both continue identically
+    auto A(getFockVector<Float64>(-1.0, 0.125));
+    auto R(getFockVector<Float64>(0.5, 0.0625));
+    mixer.append(A, R);
+    restored.append(A, R);
+    REQUIRE(restored.weights == mixer.weights);
+    requireEqual(*restored.get(), *mixer.get());
+  }
+
+  MPI_Barrier(Sisi4s::world->comm);
+  if (Sisi4s::world->rank == 0) fs::remove_all(directory);
+  MPI_Barrier(Sisi4s::world->comm);
+}
@@ -0,0 +1,119 @@
+#include <tests/Test.hpp>
+
+#include <util/NumberParser.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+
+using namespace sisi4s;
+
+namespace {
+// parses the number at the beginning of text and returns the number of
+// characters read, or -1 if there is no number
+int parse(const std::string &text, Float64 &x) {
+  const char *p(text.data());
+  if (!parseNumber(p, text.data() + text.size(), x)) return -1;
+  return p - text.data();
+}
+
+int parse(const std::string &text, Complex<Float64> &z) {
+  const char *p(text.data());
+  if (!parseNumber(p, text.data() + text.size(), z)) return -1;
+  return p - text.data();
+}
+} // namespace
+
+TEST_CASE("NumberParser", "[util]") {
+  Float64 x;
+
+  SECTION("signs and exponents") {
+    REQUIRE(parse("42", x) == 2);
+    REQUIRE(x == 42.0);
+    REQUIRE(parse("-1.5 2", x) == 4);
+    REQUIRE(x == -1.5);
+    REQUIRE(parse("+.25", x) == 4);
+    REQUIRE(x == 0.25);
+    REQUIRE(parse("3.", x) == 2);
+    REQUIRE(x == 3.0);
+    REQUIRE(parse("1e3", x) == 3);
+    REQUIRE(x == 1000.0);
+    REQUIRE(parse("-2.5E-3\n", x) == 7);
+    REQUIRE(x == -2.5e-3);
+    REQUIRE(parse("7e+2", x) == 4);
+    REQUIRE(x == 700.0);
+    REQUIRE(parse("0.000123", x) == 8);
+    REQUIRE(x == 0.000123);
+    // outside of the directly converted range
+    REQUIRE(parse("1.7976931348623157e308", x) == 22);
+    REQUIRE(x == std::numeric_limits<Float64>::max());
+    REQUIRE(parse("4.9406564584124654e-324", x) == 23);
+    REQUIRE(x == std::numeric_limits<Float64>::denorm_min());
+    REQUIRE(parse("12345678901234567890123", x) == 23);
+    REQUIRE(x == 12345678901234567890123.0);
+    REQUIRE(parse("-0", x) == 2);
+    REQUIRE(x == 0.0);
+    REQUIRE(std::signbit(x));
+  }
+
+  SECTION("inf and nan") {
+    REQUIRE(parse("inf", x) == 3);
+    REQUIRE(x == std::numeric_limits<Float64>::infinity());
+    REQUIRE(parse("-inf ", x) == 4);
+    REQUIRE(x == -std::numeric_limits<Float64>::infinity());
+    REQUIRE(parse("nan", x) == 3);
+    REQUIRE(std::isnan(x));
+    REQUIRE(parse("-nan\t", x) == 4);
+    REQUIRE(std::isnan(x));
+  }
+
+  SECTION("invalid numbers") {
+    REQUIRE(parse("", x) == -1);
+    REQUIRE(parse("abc", x) == -1);
+    REQUIRE(parse("-", x) == -1);
+    REQUIRE(parse(".", x) == -1);
+  }
+
+  SECTION("end of range") {
+    // the parser must not read beyond the given end
+    const std::string text("1.25e3");
+    const char *p(text.data());
+    REQUIRE(parseNumber(p, text.data() + 4, x));
+    REQUIRE(x == 1.25);
+    REQUIRE(p == text.data() + 4);
+  }
+
+  SECTION("complex numbers") {
+    Complex<Float64> z;
+    REQUIRE(parse("(1.5,-2e-3)", z) == 11);
+    REQUIRE(z == Complex<Float64>(1.5, -2e-3));
+    REQUIRE(parse("(-inf,0)", z) == 8);
+    REQUIRE(z.real() == -std::numeric_limits<Float64>::infinity());
+    REQUIRE(parse("(1.5;2)", z) == -1);
+  }
+
+  SECTION("round trip") {
+    std::mt19937 random;
+    std::uniform_real_distribution<double> mantissa(-1.0, 1.0);
+    // mostly converted directly and mostly converted by strtod
+    std::uniform_int_distribution<int> exponent(-60, 60),
+        wideExponent(-1000, 1000);
+    char buffer[32];
+    for (int n(0); n < 100000; ++n) {
+      const Float64 y(std::ldexp(mantissa(random),
+                                 n % 2 ? exponent(random)
+                                       : wideExponent(random)));
+      // as written by TensorIo::writeText, correctly rounded as strtod
+      std::snprintf(buffer, sizeof(buffer), "%.16g", y);
+      REQUIRE(parse(buffer, x) == int(std::strlen(buffer)));
+      REQUIRE(x == std::strtod(buffer, nullptr));
+      // with all significant digits exactly
+      std::snprintf(buffer, sizeof(buffer), "%.17g", y);
+      REQUIRE(parse(buffer, x) == int(std::strlen(buffer)));
+      REQUIRE(x == y);
+    }
+  }
+}